@@ -100,7 +100,10 @@ void setup() {
 }
 
 void loop() {
-  // Update BLE status (sends notifications to connected clients)
+  // Drain streamed sensor frames into the cache
+  roomba.tick();
+
+  // Apply received BLE commands and notify connected clients
   bleControl.updateStatus();
 
   // LED indicator for connection status
@@ -170,6 +173,7 @@ void loop() {
 
 // Optional: Custom BLE command handler
 // Uncomment and register in setup() with bleControl.setCommandCallback(onBLECommand)
+// Runs in the BLE task: do not call roomba from here
 /*
 void onBLECommand(const String& command) {
   Serial.print("BLE Command received: ");
@@ -6,6 +6,7 @@
  */
 
 #include "ArduRoomba.h"
+#include "RoombaMetrics.h"
 
 ArduRoomba roomba(2, 3, 4);
 
@@ -105,6 +106,12 @@ void processCommand(char cmd) {
       printSensorInfo();
       break;
       
+    case 't':
+    case 'T':
+      // Trace timings; the library must be built with ARDUROOMBA_METRICS
+      RoombaMetrics::writeText(Serial);
+      break;
+      
     case '?':
       printHelp();
       break;
@@ -136,6 +143,7 @@ void printHelp() {
   Serial.println("  B - Beep");
   Serial.println("  M - Toggle brushes");
   Serial.println("  I - Show sensor info");
+  Serial.println("  T - Show trace timings");
   Serial.println("  ? - Show this help");
   Serial.println();
 }
@@ -95,6 +95,9 @@ void setup() {
 }
 
 void loop() {
+  // Drain streamed sensor frames into the cache
+  roomba.tick();
+
   // Handle incoming web requests
   wifiControl.handleClient();
 
@@ -0,0 +1,69 @@
+/**
+ * @file BenchStreams.h
+ * @brief Allocation-free ports for benchmarks
+ *
+ * MockStream grows a vector on every write, which would show up as heap
+ * traffic in the measured code; these keep fixed state instead.
+ */
+
+#ifndef ARDUROOMBA_BENCH_STREAMS_H
+#define ARDUROOMBA_BENCH_STREAMS_H
+
+#include <Arduino.h>
+#include <RoombaOI.h>
+
+// Discards writes (counting them) and has no input, except that it answers
+// the OI mode query with SAFE so begin()'s connect handshake succeeds
+class NullStream : public Stream {
+public:
+  NullStream() : bytesWritten(0), _modeReply(false) {}
+
+  int available() { return _modeReply ? 1 : 0; }
+  int read() { return takeModeReply(); }
+  int peek() { return _modeReply ? OI_MODE_SAFE : -1; }
+  size_t write(uint8_t) { bytesWritten++; return 1; }
+  size_t write(const uint8_t* buffer, size_t size) {
+    if (size == 2 && buffer[0] == OI_SENSORS && buffer[1] == SENSOR_OI_MODE) _modeReply = true;
+    bytesWritten += size;
+    return size;
+  }
+  using Print::write;
+
+  uint64_t bytesWritten;
+
+protected:
+  bool _modeReply;
+
+  int takeModeReply() {
+    if (!_modeReply) return -1;
+    _modeReply = false;
+    return OI_MODE_SAFE;
+  }
+};
+
+// Replays a fixed byte sequence once per rewind(); load() it after begin(),
+// whose handshake drains whatever is waiting
+class ReplayStream : public NullStream {
+public:
+  ReplayStream() : _data(nullptr), _length(0), _pos(0) {}
+
+  void load(const uint8_t* data, size_t length) { _data = data; _length = length; _pos = 0; }
+  void rewind() { _pos = 0; }
+
+  int available() { return (int)(_length - _pos) + (_modeReply ? 1 : 0); }
+  int read() {
+    if (_modeReply) return takeModeReply();
+    return _pos < _length ? _data[_pos++] : -1;
+  }
+  int peek() {
+    if (_modeReply) return OI_MODE_SAFE;
+    return _pos < _length ? _data[_pos] : -1;
+  }
+
+private:
+  const uint8_t* _data;
+  size_t _length;
+  size_t _pos;
+};
+
+#endif
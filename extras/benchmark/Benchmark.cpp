@@ -0,0 +1,172 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Runner, heap accounting and main() for the host benchmarks
+ *
+ * Usage: arduroomba_bench [--filter=substring] [--min-time=seconds]
+ */
+
+#include "Benchmark.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define BENCHMARK_HEAP_STATS 1
+#else
+#define BENCHMARK_HEAP_STATS 0
+#endif
+
+#define BENCHMARK_MAX 64
+
+// Heap accounting: updated by the malloc wrappers below
+static uint64_t heapAllocations = 0;
+static uint64_t heapBytes = 0;
+static uint64_t heapLive = 0;
+static uint64_t heapPeak = 0;
+
+#if BENCHMARK_HEAP_STATS
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+
+static void noteAlloc(void* ptr) {
+  if (!ptr) return;
+  size_t size = malloc_usable_size(ptr);
+  heapAllocations++;
+  heapBytes += size;
+  heapLive += size;
+  if (heapLive > heapPeak) heapPeak = heapLive;
+}
+
+static void noteFree(void* ptr) {
+  if (ptr) heapLive -= malloc_usable_size(ptr);
+}
+
+void* malloc(size_t size) {
+  void* ptr = __libc_malloc(size);
+  noteAlloc(ptr);
+  return ptr;
+}
+
+void* calloc(size_t count, size_t size) {
+  void* ptr = __libc_calloc(count, size);
+  noteAlloc(ptr);
+  return ptr;
+}
+
+void* realloc(void* ptr, size_t size) {
+  noteFree(ptr);
+  void* moved = __libc_realloc(ptr, size);
+  noteAlloc(moved);
+  return moved;
+}
+
+void free(void* ptr) {
+  noteFree(ptr);
+  __libc_free(ptr);
+}
+}
+#endif
+
+static uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BenchmarkState::start() {
+  _startAllocations = heapAllocations;
+  _startBytes = heapBytes;
+  _startLive = heapLive;
+  heapPeak = heapLive;
+  _startNs = nowNs();
+}
+
+void BenchmarkState::stop() {
+  uint64_t stopNs = nowNs();
+  elapsedNs = (double)(stopNs - _startNs);
+  allocations = heapAllocations - _startAllocations;
+  allocatedBytes = heapBytes - _startBytes;
+  peakHeap = heapPeak - _startLive;
+}
+
+struct BenchmarkEntry {
+  const char* name;
+  BenchmarkFunction function;
+};
+
+static BenchmarkEntry benchmarks[BENCHMARK_MAX];
+static int benchmarkCount = 0;
+
+int benchmarkRegister(const char* name, BenchmarkFunction function) {
+  if (benchmarkCount < BENCHMARK_MAX) {
+    benchmarks[benchmarkCount].name = name;
+    benchmarks[benchmarkCount].function = function;
+    benchmarkCount++;
+  }
+  return benchmarkCount;
+}
+
+// Grow the iteration count until one run lasts at least minTime
+static BenchmarkState run(BenchmarkFunction function, double minTime) {
+  uint64_t iterations = 1;
+  for (;;) {
+    BenchmarkState state(iterations);
+    function(state);
+
+    double seconds = state.elapsedNs / 1e9;
+    if (seconds >= minTime || iterations >= 1000000000ull) return state;
+
+    double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+    if (scale > 10) scale = 10;
+    if (scale < 2) scale = 2;
+    iterations = (uint64_t)(iterations * scale);
+  }
+}
+
+void benchmarkCheckFailed(const char* file, int line, const char* expression) {
+  fprintf(stderr, "%s:%d: benchmark setup check failed: %s\n", file, line, expression);
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  const char* filter = nullptr;
+  double minTime = 0.2;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+      minTime = atof(argv[i] + 11);
+    } else {
+      fprintf(stderr, "usage: %s [--filter=substring] [--min-time=seconds]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%-36s %12s %12s %10s %12s %12s\n",
+         "Benchmark", "ns/op", "Iterations", "Allocs/op", "Bytes/op", "Peak heap");
+  for (int i = 0; i < 36 + 12 * 4 + 10 + 5; i++) putchar('-');
+  putchar('\n');
+
+  for (int i = 0; i < benchmarkCount; i++) {
+    if (filter && !strstr(benchmarks[i].name, filter)) continue;
+
+    BenchmarkState state = run(benchmarks[i].function, minTime);
+    double n = (double)state.iterations();
+    printf("%-36s %12.1f %12llu", benchmarks[i].name, state.elapsedNs / n,
+           (unsigned long long)state.iterations());
+    if (BENCHMARK_HEAP_STATS) {
+      printf(" %10.2f %12.1f %12llu\n", state.allocations / n, state.allocatedBytes / n,
+             (unsigned long long)state.peakHeap);
+    } else {
+      printf(" %10s %12s %12s\n", "n/a", "n/a", "n/a");
+    }
+    fflush(stdout);
+  }
+  return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file Benchmark.h
+ * @brief Minimal Google-Benchmark-style harness for host builds
+ *
+ *   static void BM_Something(BenchmarkState& state) {
+ *     // setup (not timed)
+ *     for (auto _ : state) {
+ *       benchmarkDoNotOptimize(work());
+ *     }
+ *   }
+ *   BENCHMARK(BM_Something);
+ *
+ * Only the loop is timed. Heap use inside the loop is counted through the
+ * malloc family (glibc), which also covers operator new and String.
+ */
+
+#ifndef ARDUROOMBA_BENCHMARK_H
+#define ARDUROOMBA_BENCHMARK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Loop variable type; the user-provided destructor keeps "unused variable"
+// warnings off `for (auto _ : state)`
+struct BenchmarkIteration {
+  ~BenchmarkIteration() {}
+};
+
+class BenchmarkState {
+public:
+  explicit BenchmarkState(uint64_t iterations)
+    : elapsedNs(0), allocations(0), allocatedBytes(0), peakHeap(0), _iterations(iterations),
+      _startNs(0), _startAllocations(0), _startBytes(0), _startLive(0) {}
+
+  class Iterator {
+  public:
+    Iterator(BenchmarkState* state, uint64_t remaining) : _state(state), _remaining(remaining) {}
+    bool operator!=(const Iterator&) {
+      if (_remaining > 0) return true;
+      _state->stop();
+      return false;
+    }
+    void operator++() { _remaining--; }
+    BenchmarkIteration operator*() const { return BenchmarkIteration(); }
+  private:
+    BenchmarkState* _state;
+    uint64_t _remaining;
+  };
+
+  Iterator begin() { start(); return Iterator(this, _iterations); }
+  Iterator end() { return Iterator(this, 0); }
+
+  uint64_t iterations() const { return _iterations; }
+
+  // Filled in when the loop finishes
+  double elapsedNs;
+  uint64_t allocations;
+  uint64_t allocatedBytes;
+  uint64_t peakHeap;
+
+private:
+  uint64_t _iterations;
+  uint64_t _startNs;
+  uint64_t _startAllocations;
+  uint64_t _startBytes;
+  uint64_t _startLive;
+
+  void start();
+  void stop();
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState&);
+
+int benchmarkRegister(const char* name, BenchmarkFunction function);
+
+#define BENCHMARK(fn) static int fn##_registered = benchmarkRegister(#fn, fn)
+
+// Setup assertion: a fixture that does not do what the benchmark assumes
+// (e.g. a stream frame that fails its checksum) stops the run
+void benchmarkCheckFailed(const char* file, int line, const char* expression);
+
+#define BENCHMARK_CHECK(expression) \
+  do { if (!(expression)) benchmarkCheckFailed(__FILE__, __LINE__, #expression); } while (0)
+
+// Keep a value (and the work producing it) from being optimised away
+template <class T>
+inline void benchmarkDoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void benchmarkClobberMemory() {
+  asm volatile("" : : : "memory");
+}
+
+#endif
@@ -0,0 +1,236 @@
+/**
+ * @file ExtensionBenchmarks.cpp
+ * @brief WiFi/BLE request handling paths that run on every joystick tick
+ */
+
+#include "Benchmark.h"
+#include "BenchStreams.h"
+
+#include <ArduRoomba.h>
+#include <extensions/ArduRoombaWiFi.h>
+#include <extensions/ArduRoombaBinary.h>
+#include <extensions/ArduRoombaHttp.h>
+#include <extensions/ArduRoombaWebSocket.h>
+
+// Exposes the page/status generators of the platform-neutral base class
+class BenchWiFi : public ArduRoombaWiFi {
+public:
+  explicit BenchWiFi(ArduRoomba& roomba) : ArduRoombaWiFi(roomba) {}
+
+  bool beginAP(const char*, const char*) { return true; }
+  bool beginClient(const char*, const char*) { return true; }
+  void end() {}
+  bool isConnected() const { return true; }
+  String getIPAddress() const { return String("0.0.0.0"); }
+
+  size_t statusJSON(Print& out, const char* fields) {
+    RoombaStatusFields selected;
+    parseStatusFields(fields, selected);
+    RoombaLinkSnapshot link;
+    link.capture(_roomba);
+    return writeStatusJSON(out, selected, link);
+  }
+  size_t controlPage(Print& out) { return writeControlPage(out); }
+  void metrics(Print& out) { respondMetrics(out, 0); }
+};
+
+static void BM_WiFiStatusJSON(BenchmarkState& state) {
+  NullStream port;
+  ArduRoomba roomba(port, 5);
+  roomba.begin();
+  BenchWiFi wifi(roomba);
+  NullStream client;
+
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(wifi.statusJSON(client, nullptr));
+  }
+}
+BENCHMARK(BM_WiFiStatusJSON);
+
+// Stream frame of whole groups with patterned data, for filling the cache
+static size_t groupFrame(const uint8_t* groups, uint8_t count, uint8_t* out) {
+  size_t n = 2;
+  for (uint8_t i = 0; i < count; i++) {
+    out[n++] = groups[i];
+    for (uint8_t b = RoombaPackets::size(groups[i]); b > 0; b--, n++) out[n] = (uint8_t)(n * 7);
+  }
+  out[0] = OI_STREAM_HEADER;
+  out[1] = (uint8_t)(n - 2);
+
+  uint8_t sum = 0;
+  for (size_t i = 0; i < n; i++) sum += out[i];
+  out[n++] = (uint8_t)(0 - sum);
+  return n;
+}
+
+// /status?fields=all with every packet cached
+static void BM_WiFiStatusJSONAll(BenchmarkState& state) {
+  static const uint8_t first[] = { SENSOR_GROUP_7_26, SENSOR_GROUP_43_58 };
+  static const uint8_t second[] = { SENSOR_GROUP_27_34, SENSOR_GROUP_35_42 };
+  uint8_t frame[OI_STREAM_MAX_PAYLOAD + 3];
+
+  // One tick per frame: a tick decodes only the newest frame waiting
+  ReplayStream port;
+  ArduRoomba roomba(port, 5);
+  roomba.begin();
+  port.load(frame, groupFrame(first, 2, frame));
+  roomba.tick();
+  port.load(frame, groupFrame(second, 2, frame));
+  roomba.tick();
+  BENCHMARK_CHECK(roomba.getSensorCache().has(SENSOR_STASIS) &&
+                  roomba.getSensorCache().has(SENSOR_WALL_SIGNAL));
+  BenchWiFi wifi(roomba);
+  NullStream client;
+
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(wifi.statusJSON(client, "all"));
+  }
+}
+BENCHMARK(BM_WiFiStatusJSONAll);
+
+static void BM_WiFiControlPage(BenchmarkState& state) {
+  NullStream port;
+  ArduRoomba roomba(port, 5);
+  BenchWiFi wifi(roomba);
+  NullStream client;
+
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(wifi.controlPage(client));
+  }
+}
+BENCHMARK(BM_WiFiControlPage);
+
+// Prometheus scrape: measured, then written (trace table only with ARDUROOMBA_METRICS)
+static void BM_WiFiMetrics(BenchmarkState& state) {
+  NullStream port;
+  ArduRoomba roomba(port, 5);
+  roomba.begin();
+  BenchWiFi wifi(roomba);
+  NullStream client;
+
+  for (auto _ : state) {
+    wifi.metrics(client);
+  }
+  benchmarkDoNotOptimize(client.bytesWritten);
+}
+BENCHMARK(BM_WiFiMetrics);
+
+// /cmd request as the WiFi servers handle it: parsed byte by byte, then the
+// three parameters looked up (replaced ArduRoombaWiFiS3::parseGETParameter)
+static void BM_HttpCommandParams(BenchmarkState& state) {
+  static const char request[] = "GET /cmd?action=forward&speed=200&duration=1000 HTTP/1.1\r\n\r\n";
+  RoombaHttpParser parser;
+  HttpParseResult result = HTTP_PARSE_INCOMPLETE;
+  for (const char* p = request; *p; p++) result = parser.feed(*p);
+  BENCHMARK_CHECK(result == HTTP_PARSE_DONE && parser.param("duration") &&
+                  strcmp(parser.param("duration"), "1000") == 0);
+
+  for (auto _ : state) {
+    parser.reset();
+    for (const char* p = request; *p; p++) parser.feed(*p);
+    benchmarkDoNotOptimize(parser.param("action"));
+    benchmarkDoNotOptimize(parser.param("speed"));
+    benchmarkDoNotOptimize(parser.param("duration"));
+  }
+}
+BENCHMARK(BM_HttpCommandParams);
+
+// Full joystick request as a browser sends it, parsed byte by byte
+static void BM_HttpParseRequest(BenchmarkState& state) {
+  static const char request[] =
+    "GET /cmd?action=forward&speed=200&duration=1000 HTTP/1.1\r\n"
+    "Host: 192.168.4.1\r\n"
+    "User-Agent: Mozilla/5.0 (Linux; Android 14) AppleWebKit/537.36\r\n"
+    "Accept: */*\r\n"
+    "Referer: http://192.168.4.1/\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+  RoombaHttpParser parser;
+
+  for (auto _ : state) {
+    parser.reset();
+    for (const char* p = request; *p; p++) parser.feed(*p);
+    benchmarkDoNotOptimize(parser.param("duration"));
+  }
+}
+BENCHMARK(BM_HttpParseRequest);
+
+// Keep-alive status poll answer: head and short body in one write()
+static void BM_HttpResponse(BenchmarkState& state) {
+  static const char body[] = "{\"voltage\":15800,\"connected\":true,\"remote_enabled\":true}";
+  NullStream client;
+
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(RoombaHttpResponse::write(client, 200, "application/json", body,
+                                                     HTTP_KEEP_ALIVE | HTTP_CORS));
+  }
+}
+BENCHMARK(BM_HttpResponse);
+
+// Masked binary drive frame from the control page, then the status push back
+static void BM_WebSocketCommandFrame(BenchmarkState& state) {
+  RoombaBinaryCommand in = { 1, ROOMBA_ACTION_DRIVE_DIRECT, 200, -200, 0 };
+  uint8_t frame[6 + ROOMBA_BINARY_COMMAND_SIZE] = { 0x82, 0x80 | ROOMBA_BINARY_COMMAND_SIZE, 0x12, 0x34, 0x56, 0x78 };
+  RoombaBinaryProtocol::encodeCommand(in, frame + 6, ROOMBA_BINARY_COMMAND_SIZE);
+  for (uint8_t i = 0; i < ROOMBA_BINARY_COMMAND_SIZE; i++) frame[6 + i] ^= frame[2 + (i & 3)];
+
+  RoombaWebSocketDecoder decoder;
+  RoombaBinaryCommand out;
+  RoombaBinaryStatus status = { 1, 15800, -250, BINARY_STATUS_CONNECTED };
+  uint8_t reply[ROOMBA_BINARY_STATUS_SIZE];
+  NullStream client;
+
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < sizeof(frame); i++) {
+      if (decoder.feed(frame[i]) == WS_FRAME_DONE) {
+        RoombaBinaryProtocol::decodeCommand(decoder.payload(), decoder.length(), out);
+      }
+    }
+    size_t length = RoombaBinaryProtocol::encodeStatus(status, reply, sizeof(reply));
+    RoombaWebSocket::writeFrame(client, WS_OP_BINARY, reply, length);
+  }
+  benchmarkDoNotOptimize(out);
+}
+BENCHMARK(BM_WebSocketCommandFrame);
+
+static void BM_CommandParse(BenchmarkState& state) {
+  static const char text[] = "forward:200:1000";
+  RoombaCommand cmd;
+
+  for (auto _ : state) {
+    RoombaCommandParser::parseCommand(text, sizeof(text) - 1, cmd);
+    benchmarkDoNotOptimize(RoombaCommandParser::actionFromName(cmd.action));
+  }
+}
+BENCHMARK(BM_CommandParse);
+
+// The ArduRoombaBLE::processCommand body: parse, resolve, queue and send
+static void BM_CommandDispatch(BenchmarkState& state) {
+  static const char text[] = "forward:200:0";
+  NullStream port;
+  ArduRoomba roomba(port, 5);
+  roomba.begin();
+  RoombaCommand cmd;
+
+  for (auto _ : state) {
+    RoombaCommandParser::parseCommand(text, sizeof(text) - 1, cmd);
+    RoombaAction action = RoombaCommandParser::actionFromName(cmd.action);
+    RoombaCommandParser::dispatch(roomba, action, cmd.speed, cmd.duration);
+  }
+  benchmarkDoNotOptimize(port.bytesWritten);
+}
+BENCHMARK(BM_CommandDispatch);
+
+static void BM_BinaryCommandDecode(BenchmarkState& state) {
+  RoombaBinaryCommand in = { 0, ROOMBA_ACTION_DRIVE_DIRECT, 200, -200, 0 };
+  uint8_t frame[ROOMBA_BINARY_COMMAND_SIZE];
+  RoombaBinaryProtocol::encodeCommand(in, frame, sizeof(frame));
+  RoombaBinaryCommand out;
+
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(RoombaBinaryProtocol::decodeCommand(frame, sizeof(frame), out));
+  }
+  benchmarkDoNotOptimize(out);
+}
+BENCHMARK(BM_BinaryCommandDecode);
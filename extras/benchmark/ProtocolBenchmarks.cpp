@@ -0,0 +1,217 @@
+/**
+ * @file ProtocolBenchmarks.cpp
+ * @brief OI command encoding, stream decoding and the control loop
+ */
+
+#include "Benchmark.h"
+#include "BenchStreams.h"
+
+#include <ArduRoomba.h>
+
+// Default subscription frame: bumps, wall, voltage, current
+static const uint8_t BASIC_FRAME[] = {
+  19, 10, SENSOR_BUMPS_DROPS, 0x01, SENSOR_WALL, 0x00,
+  SENSOR_VOLTAGE, 0x3A, 0x98, SENSOR_CURRENT, 0xFF, 0x38, 0x9D
+};
+
+// Group 101 (packets 43-58, 28 data bytes) plus checksum
+static uint8_t GROUP_FRAME[2 + 1 + 28 + 1];
+
+static void buildGroupFrame() {
+  GROUP_FRAME[0] = OI_STREAM_HEADER;
+  GROUP_FRAME[1] = 29;
+  GROUP_FRAME[2] = SENSOR_GROUP_43_58;
+  for (uint8_t i = 0; i < 28; i++) GROUP_FRAME[3 + i] = (uint8_t)(i * 7);
+
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < sizeof(GROUP_FRAME) - 1; i++) sum += GROUP_FRAME[i];
+  GROUP_FRAME[sizeof(GROUP_FRAME) - 1] = (uint8_t)(0x100 - sum);
+}
+
+// Frames the parser accepts in data; a fixture with a bad checksum or layout
+// would otherwise time the rejection path instead
+static uint32_t acceptedFrames(const uint8_t* data, size_t length) {
+  RoombaStreamParser parser;
+  for (size_t i = 0; i < length; i++) parser.feed(data[i]);
+  return parser.getStats().goodFrames;
+}
+
+static void BM_OIDrive(BenchmarkState& state) {
+  NullStream port;
+  RoombaOI oi(port, 5);
+  oi.begin();
+  int16_t v = 0;
+  for (auto _ : state) {
+    oi.drive(v++ & 0xFF, 500);
+  }
+  benchmarkDoNotOptimize(port.bytesWritten);
+}
+BENCHMARK(BM_OIDrive);
+
+static void BM_OIDriveDirect(BenchmarkState& state) {
+  NullStream port;
+  RoombaOI oi(port, 5);
+  oi.begin();
+  int16_t v = 0;
+  for (auto _ : state) {
+    oi.driveDirect(v & 0xFF, -(v & 0xFF));
+    v++;
+  }
+  benchmarkDoNotOptimize(port.bytesWritten);
+}
+BENCHMARK(BM_OIDriveDirect);
+
+static void BM_OIDriveDirectBatched(BenchmarkState& state) {
+  NullStream port;
+  RoombaOI oi(port, 5);
+  oi.begin();
+  oi.setTxBatching(true);
+  int16_t v = 0;
+  for (auto _ : state) {
+    oi.driveDirect(v & 0xFF, -(v & 0xFF));
+    oi.flushTx();
+    v++;
+  }
+  benchmarkDoNotOptimize(port.bytesWritten);
+}
+BENCHMARK(BM_OIDriveDirectBatched);
+
+static void BM_StreamParserBasicFrame(BenchmarkState& state) {
+  BENCHMARK_CHECK(acceptedFrames(BASIC_FRAME, sizeof(BASIC_FRAME)) == 1);
+  RoombaStreamParser parser;
+  RoombaSensorSnapshot snapshot;
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < sizeof(BASIC_FRAME); i++) {
+      if (parser.feed(BASIC_FRAME[i])) parser.decode(snapshot);
+    }
+  }
+  benchmarkDoNotOptimize(snapshot);
+}
+BENCHMARK(BM_StreamParserBasicFrame);
+
+static void BM_StreamParserGroupFrame(BenchmarkState& state) {
+  buildGroupFrame();
+  BENCHMARK_CHECK(acceptedFrames(GROUP_FRAME, sizeof(GROUP_FRAME)) == 1);
+  RoombaStreamParser parser;
+  RoombaSensorSnapshot snapshot;
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < sizeof(GROUP_FRAME); i++) {
+      if (parser.feed(GROUP_FRAME[i])) parser.decode(snapshot);
+    }
+  }
+  benchmarkDoNotOptimize(snapshot);
+}
+BENCHMARK(BM_StreamParserGroupFrame);
+
+// A false header and a truncated frame ahead of a good one
+static void BM_StreamParserResync(BenchmarkState& state) {
+  uint8_t noisy[8 + sizeof(BASIC_FRAME)] = { 0x55, 19, 200, 0xAA, 19, 4, SENSOR_WALL, 1 };
+  memcpy(noisy + 8, BASIC_FRAME, sizeof(BASIC_FRAME));
+  BENCHMARK_CHECK(acceptedFrames(noisy, sizeof(noisy)) == 1);
+
+  RoombaStreamParser parser;
+  RoombaSensorSnapshot snapshot;
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < sizeof(noisy); i++) {
+      if (parser.feed(noisy[i])) parser.decode(snapshot);
+    }
+  }
+  benchmarkDoNotOptimize(snapshot);
+}
+BENCHMARK(BM_StreamParserResync);
+
+static void BM_SensorCacheStore(BenchmarkState& state) {
+  RoombaStreamParser parser;
+  RoombaSensorSnapshot snapshot;
+  for (uint8_t i = 0; i < sizeof(BASIC_FRAME); i++) {
+    if (parser.feed(BASIC_FRAME[i])) parser.decode(snapshot);
+  }
+  BENCHMARK_CHECK(snapshot.has(SENSOR_VOLTAGE));
+
+  RoombaSensorCache cache;
+  for (auto _ : state) {
+    snapshot.timestamp++;
+    cache.store(snapshot);
+  }
+  benchmarkDoNotOptimize(cache.values());
+}
+BENCHMARK(BM_SensorCacheStore);
+
+// A 64-byte burst through the UART receive ring
+static void BM_RxRingBurst(BenchmarkState& state) {
+  RoombaRingBuffer<ROOMBA_RX_BUFFER_SIZE> ring;
+  int sum = 0;
+  for (auto _ : state) {
+    for (uint8_t i = 0; i < 64; i++) ring.push(i);
+    while (ring.available()) sum += ring.read();
+  }
+  benchmarkDoNotOptimize(sum);
+}
+BENCHMARK(BM_RxRingBurst);
+
+// One encoder pair per iteration, curving left
+static void BM_OdometryUpdate(BenchmarkState& state) {
+  RoombaOdometry odometry;
+  uint16_t left = 0, right = 0;
+  for (auto _ : state) {
+    left += 11;
+    right += 13;
+    odometry.update(left, right);
+  }
+  benchmarkDoNotOptimize(odometry.getPose());
+}
+BENCHMARK(BM_OdometryUpdate);
+
+// One S-curve step per iteration, reversing whenever a ramp completes
+static void BM_MotionProfileUpdate(BenchmarkState& state) {
+  RoombaMotionProfile profile;
+  profile.setLimits(500, 2000);
+  unsigned long now = 0;
+  int16_t speed = 300;
+  for (auto _ : state) {
+    if (!profile.isRamping()) {
+      speed = -speed;
+      profile.setTarget(speed, speed / 2);
+    }
+    now += MOTION_UPDATE_INTERVAL;
+    benchmarkDoNotOptimize(profile.update(now));
+  }
+}
+BENCHMARK(BM_MotionProfileUpdate);
+
+// One control-loop iteration with a frame waiting: poll, decode, cache, flush
+static void BM_ArduRoombaTick(BenchmarkState& state) {
+  ReplayStream port;
+  ArduRoomba roomba(port, 5);
+  BENCHMARK_CHECK(roomba.begin());
+  port.load(BASIC_FRAME, sizeof(BASIC_FRAME));
+  roomba.tick();
+  BENCHMARK_CHECK(roomba.getStreamStats().goodFrames == 1 && roomba.getStreamStats().badFrames == 0);
+
+  for (auto _ : state) {
+    port.rewind();
+    roomba.tick();
+  }
+  BENCHMARK_CHECK(roomba.isConnected());
+  benchmarkDoNotOptimize(roomba.getSensorCache().values());
+}
+BENCHMARK(BM_ArduRoombaTick);
+
+// Cached getter while streaming (no serial round trip)
+static void BM_ArduRoombaGetVoltage(BenchmarkState& state) {
+  ReplayStream port;
+  ArduRoomba roomba(port, 5);
+  BENCHMARK_CHECK(roomba.begin());
+  port.load(BASIC_FRAME, sizeof(BASIC_FRAME));
+  roomba.tick();
+  BENCHMARK_CHECK(roomba.getSensorCache().has(SENSOR_VOLTAGE));
+
+  // Frozen clock: the value must stay within its max age to time a cache hit
+  HostClock::setAutoAdvance(0);
+  for (auto _ : state) {
+    benchmarkDoNotOptimize(roomba.getBatteryVoltage());
+  }
+  BENCHMARK_CHECK(roomba.getBatteryVoltage() == 15000);
+  HostClock::setAutoAdvance(1);
+}
+BENCHMARK(BM_ArduRoombaGetVoltage);
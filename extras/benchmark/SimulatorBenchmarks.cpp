@@ -0,0 +1,82 @@
+/**
+ * @file SimulatorBenchmarks.cpp
+ * @brief The control loop against the simulated Create 2: steady streaming,
+ *        a noisy link and waking a sleeping robot
+ *
+ * Virtual time moves on by hand between ticks, so these time the CPU cost of
+ * what tick() does over that span, simulator work included, not wall time.
+ * The allocations reported here are the simulator's reply queue; the library
+ * side allocates nothing (see BM_ArduRoombaTick).
+ */
+
+#include "Benchmark.h"
+
+#include <ArduRoomba.h>
+#include <RoombaSimulator.h>
+
+#define BRC_PIN 5
+#define LOOP_PERIOD_US 1000 // A 1 kHz loop()
+
+static void connect(RoombaSimulator& sim, ArduRoomba& roomba) {
+  sim.setBrcPin(BRC_PIN);
+  BENCHMARK_CHECK(roomba.begin());
+  roomba.enableOdometry();
+  roomba.moveForward(200);
+}
+
+// One loop() pass while driving with odometry; a frame lands every 15th pass
+static void BM_SimulatorControlLoop(BenchmarkState& state) {
+  RoombaSimulator sim;
+  ArduRoomba roomba(sim, BRC_PIN);
+  connect(sim, roomba);
+  uint32_t frames = roomba.getStreamStats().goodFrames;
+
+  for (auto _ : state) {
+    HostClock::advanceMicros(LOOP_PERIOD_US);
+    roomba.tick();
+  }
+  BENCHMARK_CHECK(roomba.isConnected());
+  BENCHMARK_CHECK(state.iterations() < 100 || roomba.getStreamStats().goodFrames > frames);
+  BENCHMARK_CHECK(roomba.getLinkHealth().losses == 0);
+}
+BENCHMARK(BM_SimulatorControlLoop);
+
+// The same loop with 2% of the robot's bytes corrupted and 2% dropped: frames
+// are rejected, the parser resyncs and runs of bad frames restart the link
+static void BM_SimulatorNoisyLoop(BenchmarkState& state) {
+  RoombaSimulator sim;
+  ArduRoomba roomba(sim, BRC_PIN);
+  connect(sim, roomba);
+  sim.setCorruptionRate(0.02f);
+  sim.setDropRate(0.02f);
+  uint32_t frames = roomba.getStreamStats().goodFrames;
+
+  for (auto _ : state) {
+    HostClock::advanceMicros(LOOP_PERIOD_US);
+    roomba.tick();
+  }
+  BENCHMARK_CHECK(state.iterations() < 100 || roomba.getStreamStats().goodFrames > frames);
+  benchmarkDoNotOptimize(roomba.getPose());
+}
+BENCHMARK(BM_SimulatorNoisyLoop);
+
+// The robot falls asleep; loop() until the BRC pulses have woken it and the
+// stream is back (about 1.7 s of virtual time per iteration)
+static void BM_SimulatorSleepReconnect(BenchmarkState& state) {
+  RoombaSimulator sim;
+  ArduRoomba roomba(sim, BRC_PIN);
+  connect(sim, roomba);
+  uint16_t wakes = roomba.getLinkHealth().wakes;
+
+  for (auto _ : state) {
+    sim.sleep();
+    do {
+      HostClock::advanceMicros(LOOP_PERIOD_US);
+      roomba.tick();
+    } while (!roomba.isConnected() || roomba.getLinkHealth().wakes == wakes);
+    wakes = roomba.getLinkHealth().wakes;
+  }
+  BENCHMARK_CHECK(!sim.isAsleep() && sim.isStreaming());
+  BENCHMARK_CHECK(roomba.getLinkHealth().lastLoss == LINK_LOSS_SILENCE);
+}
+BENCHMARK(BM_SimulatorSleepReconnect);
@@ -0,0 +1,114 @@
+/**
+ * @file Arduino.cpp
+ * @brief Host implementation of the Arduino core shim
+ */
+
+#include "Arduino.h"
+
+HostSerial Serial;
+
+static uint64_t clockMicros = 0;
+static unsigned long autoAdvance = 1;
+
+void HostClock::reset() {
+  clockMicros = 0;
+  autoAdvance = 1;
+}
+
+void HostClock::set(uint64_t micros) {
+  clockMicros = micros;
+}
+
+void HostClock::advance(unsigned long ms) {
+  clockMicros += (uint64_t)ms * 1000;
+}
+
+void HostClock::advanceMicros(unsigned long us) {
+  clockMicros += us;
+}
+
+void HostClock::setAutoAdvance(unsigned long usPerRead) {
+  autoAdvance = usPerRead;
+}
+
+uint64_t HostClock::now() {
+  return clockMicros;
+}
+
+unsigned long millis() {
+  clockMicros += autoAdvance;
+  return (unsigned long)(clockMicros / 1000);
+}
+
+unsigned long micros() {
+  clockMicros += autoAdvance;
+  return (unsigned long)clockMicros;
+}
+
+void delay(unsigned long ms) {
+  HostClock::advance(ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+  HostClock::advanceMicros(us);
+}
+
+void yield() {
+}
+
+static uint8_t pinLevels[HOST_PIN_COUNT];
+static uint32_t pinFalls[HOST_PIN_COUNT];
+
+void HostPins::reset() {
+  memset(pinLevels, 0, sizeof(pinLevels));
+  memset(pinFalls, 0, sizeof(pinFalls));
+}
+
+void HostPins::write(uint8_t pin, uint8_t value) {
+  if (pin >= HOST_PIN_COUNT) return;
+  if (pinLevels[pin] == HIGH && value == LOW) pinFalls[pin]++;
+  pinLevels[pin] = value ? HIGH : LOW;
+}
+
+uint8_t HostPins::read(uint8_t pin) {
+  return pin < HOST_PIN_COUNT ? pinLevels[pin] : LOW;
+}
+
+uint32_t HostPins::fallingEdges(uint8_t pin) {
+  return pin < HOST_PIN_COUNT ? pinFalls[pin] : 0;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long value, int base) {
+  if (base == DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%ld", value);
+    return write(buf);
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", value);
+  return write(buf);
+}
+
+size_t Print::print(double value, int digits) {
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", digits, value);
+  return write(buf);
+}
+
+size_t HostSerial::write(uint8_t byte) {
+  return fwrite(&byte, 1, 1, stdout);
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file Arduino.h
+ * @brief Minimal Arduino core shim for host (Linux) builds
+ *
+ * Provides just enough of the Arduino API for the core library to compile
+ * and run off-device: Print/Stream, a virtual clock behind millis()/micros()
+ * and delay(), no-op pin I/O, and PROGMEM accessors that read plain memory.
+ */
+
+#ifndef ARDUROOMBA_HOST_ARDUINO_H
+#define ARDUROOMBA_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "WString.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define PI 3.1415926535897932384626433832795
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define DEC 10
+#define HEX 16
+
+// Flash memory reads are ordinary reads on the host
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+#define pgm_read_byte(addr)  (*(const uint8_t*)(addr))
+#define pgm_read_word(addr)  (*(const uint16_t*)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t*)(addr))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+/**
+ * Virtual clock
+ *
+ * Time only moves when the harness advances it, when delay() is called, or by
+ * the auto-advance applied on every millis()/micros() read (default 1 us) so
+ * busy-wait timeouts in the library still terminate. Set auto-advance to 0
+ * for exact timing.
+ */
+class HostClock {
+public:
+  static void reset();
+  static void set(uint64_t micros);
+  static void advance(unsigned long ms);
+  static void advanceMicros(unsigned long us);
+  static void setAutoAdvance(unsigned long usPerRead);
+  static uint64_t now(); // Microseconds, without auto-advance
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+/**
+ * Digital pins
+ *
+ * Output levels are remembered and falling edges counted, so a harness (or
+ * the simulator watching its BRC line) can see pulses the library sends.
+ */
+#define HOST_PIN_COUNT 64
+
+class HostPins {
+public:
+  static void reset();
+  static void write(uint8_t pin, uint8_t value);
+  static uint8_t read(uint8_t pin);
+  static uint32_t fallingEdges(uint8_t pin);
+};
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t value) { HostPins::write(pin, value); }
+inline int digitalRead(uint8_t pin) { return HostPins::read(pin); }
+
+class Print {
+public:
+  virtual ~Print() {}
+
+  virtual size_t write(uint8_t byte) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+
+  size_t print(const char* str) { return write(str); }
+  size_t print(const String& str) { return write((const uint8_t*)str.c_str(), str.length()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+
+  size_t println() { return write("\r\n"); }
+  size_t println(const char* str) { return print(str) + println(); }
+  size_t println(const String& str) { return print(str) + println(); }
+  size_t println(char c) { return print(c) + println(); }
+  size_t println(int value, int base = DEC) { return print(value, base) + println(); }
+  size_t println(unsigned int value, int base = DEC) { return print(value, base) + println(); }
+  size_t println(long value, int base = DEC) { return print(value, base) + println(); }
+  size_t println(unsigned long value, int base = DEC) { return print(value, base) + println(); }
+  size_t println(double value, int digits = 2) { return print(value, digits) + println(); }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+};
+
+// Console serial: writes go to stdout, nothing is ever received
+class HostSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  void end() {}
+  operator bool() const { return true; }
+
+  int available() { return 0; }
+  int read() { return -1; }
+  int peek() { return -1; }
+  size_t write(uint8_t byte);
+  size_t write(const uint8_t* buffer, size_t size);
+  using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,19 @@
+/**
+ * @file HardwareSerial.h
+ * @brief Host stand-in for a hardware UART (an unconnected MockStream)
+ */
+
+#ifndef ARDUROOMBA_HOST_HARDWARE_SERIAL_H
+#define ARDUROOMBA_HOST_HARDWARE_SERIAL_H
+
+#include "MockStream.h"
+
+class HardwareSerial : public MockStream {
+public:
+  HardwareSerial() {}
+  explicit HardwareSerial(int) {}
+  void begin(unsigned long) {}
+  void end() {}
+};
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file MockStream.h
+ * @brief Injectable in-memory Stream for host builds
+ *
+ * Bytes queued with inject() are returned by read(); everything the library
+ * writes is captured for inspection. Pass one to ArduRoomba(Stream&, brcPin)
+ * or RoombaOI(Stream&, brcPin) in place of a serial port.
+ */
+
+#ifndef ARDUROOMBA_HOST_MOCK_STREAM_H
+#define ARDUROOMBA_HOST_MOCK_STREAM_H
+
+#include "Arduino.h"
+
+#include <deque>
+#include <vector>
+
+class MockStream : public Stream {
+public:
+  MockStream() : _writeCalls(0) {}
+
+  // Receive side
+  void inject(uint8_t byte) { _rx.push_back(byte); }
+  void inject(const uint8_t* data, size_t length) { _rx.insert(_rx.end(), data, data + length); }
+  void clearInput() { _rx.clear(); }
+
+  // Transmit side
+  const std::vector<uint8_t>& written() const { return _tx; }
+  size_t writeCalls() const { return _writeCalls; } // Calls to write(), not bytes
+  void clearOutput() { _tx.clear(); _writeCalls = 0; }
+
+  int available() { return (int)_rx.size(); }
+
+  int read() {
+    if (_rx.empty()) return -1;
+    int byte = _rx.front();
+    _rx.pop_front();
+    return byte;
+  }
+
+  int peek() { return _rx.empty() ? -1 : _rx.front(); }
+
+  size_t write(uint8_t byte) {
+    _writeCalls++;
+    _tx.push_back(byte);
+    return 1;
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) {
+    _writeCalls++;
+    _tx.insert(_tx.end(), buffer, buffer + size);
+    return size;
+  }
+
+  using Print::write;
+
+private:
+  std::deque<uint8_t> _rx;
+  std::vector<uint8_t> _tx;
+  size_t _writeCalls;
+};
+
+#endif
@@ -0,0 +1,428 @@
+/**
+ * @file RoombaSimulator.cpp
+ * @brief Simulated Create 2 for host builds
+ */
+
+#include "RoombaSimulator.h"
+
+#include <math.h>
+
+// Opcodes the library does not send but a client might
+#define SIM_OP_PWM_MOTORS     144
+#define SIM_OP_DRIVE_PWM      146
+#define SIM_OP_DIGITAL_OUT    147
+#define SIM_OP_PAUSE_RESUME   150
+#define SIM_OP_STOP           173
+
+#define SIM_DEGREES_PER_RADIAN (180.0 / 3.14159265358979)
+
+RoombaSimulator::RoombaSimulator(uint32_t seed)
+  : _rng(seed ? seed : 1), _latency(0), _dropRate(0), _corruptRate(0),
+    _baudLimit(0), _hostBaud(0), _brcPin(0xFF), _brcEdges(0) {
+  reset();
+}
+
+void RoombaSimulator::reset() {
+  _cmdLength = 0;
+
+  _mode = SIM_MODE_OFF;
+  _baud = 19200; // Selected by the BRC pulses in RoombaOI::begin()
+  _asleep = false;
+  _leftVelocity = _rightVelocity = 0;
+  _x = _y = _theta = 0;
+  _leftCounts = _rightCounts = 0;
+  _distance = _angle = 0;
+  memset(_values, 0, sizeof(_values));
+  _lastUpdate = HostClock::now();
+
+  _streamCount = 0;
+  _streamPaused = false;
+  _nextFrame = 0;
+
+  _tx.clear();
+  memset(&_stats, 0, sizeof(_stats));
+
+  setBattery(16000, -150);
+  setPacket(SENSOR_TEMPERATURE, 25);
+  setPacket(SENSOR_BATTERY_CHARGE, 2500);
+  setPacket(SENSOR_BATTERY_CAPACITY, 3000);
+}
+
+void RoombaSimulator::update() {
+  uint64_t now = HostClock::now();
+
+  if (_brcPin != 0xFF) {
+    uint32_t edges = HostPins::fallingEdges(_brcPin);
+    if (edges != _brcEdges) {
+      _brcEdges = edges;
+      _asleep = false;
+    }
+  }
+
+  while (isStreaming() && _nextFrame <= now) {
+    integrate(_nextFrame);
+    sendFrame();
+    _nextFrame += SIM_STREAM_PERIOD_US;
+  }
+  integrate(now);
+}
+
+int RoombaSimulator::available() {
+  update();
+
+  uint64_t now = HostClock::now();
+  int ready = 0;
+  for (std::deque<TxByte>::const_iterator it = _tx.begin(); it != _tx.end() && it->readyAt <= now; ++it) {
+    ready++;
+  }
+  return ready;
+}
+
+int RoombaSimulator::read() {
+  update();
+  if (_tx.empty() || _tx.front().readyAt > HostClock::now()) return -1;
+
+  uint8_t value = _tx.front().value;
+  _tx.pop_front();
+  if (replyGarbled()) {
+    _stats.baudErrors++;
+    return (uint8_t)~value;
+  }
+  return value;
+}
+
+int RoombaSimulator::peek() {
+  update();
+  if (_tx.empty() || _tx.front().readyAt > HostClock::now()) return -1;
+  return replyGarbled() ? (uint8_t)~_tx.front().value : _tx.front().value;
+}
+
+size_t RoombaSimulator::write(uint8_t byte) {
+  // Bring the model up to date before the command changes it
+  update();
+
+  if (_asleep) return 1;
+  if (rateMismatch()) {
+    _stats.baudErrors++;
+    return 1;
+  }
+
+  if (_cmdLength == 0 && expectedLength(&byte, 1) == 0) {
+    _stats.unknownBytes++;
+    return 1;
+  }
+
+  _cmd[_cmdLength++] = byte;
+  uint16_t expected = expectedLength(_cmd, _cmdLength);
+
+  if (expected > sizeof(_cmd)) {
+    // Longer than any frame the library can send; resynchronise on the next opcode
+    _stats.unknownBytes += _cmdLength;
+    _cmdLength = 0;
+  } else if (_cmdLength >= expected) {
+    execute(_cmd, _cmdLength);
+    _stats.commands++;
+    _cmdLength = 0;
+  }
+  return 1;
+}
+
+void RoombaSimulator::setBrcPin(uint8_t pin) {
+  _brcPin = pin;
+  _brcEdges = pin != 0xFF ? HostPins::fallingEdges(pin) : 0;
+}
+
+void RoombaSimulator::sleep() {
+  update();
+  _asleep = true;
+  _mode = SIM_MODE_OFF;
+  _leftVelocity = _rightVelocity = 0;
+  _streamCount = 0;
+  _cmdLength = 0;
+  _tx.clear();
+}
+
+void RoombaSimulator::setBumpers(bool left, bool right) {
+  int32_t bits = _values[SENSOR_BUMPS_DROPS - OI_PACKET_FIRST] & ~0x03;
+  if (right) bits |= 0x01;
+  if (left) bits |= 0x02;
+  setPacket(SENSOR_BUMPS_DROPS, bits);
+}
+
+void RoombaSimulator::setWall(bool wall) {
+  setPacket(SENSOR_WALL, wall ? 1 : 0);
+}
+
+void RoombaSimulator::setBattery(uint16_t millivolts, int16_t milliamps) {
+  setPacket(SENSOR_VOLTAGE, millivolts);
+  setPacket(SENSOR_CURRENT, milliamps);
+}
+
+void RoombaSimulator::setPacket(uint8_t packetId, int32_t value) {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST) return;
+  _values[packetId - OI_PACKET_FIRST] = value;
+}
+
+int32_t RoombaSimulator::getPacket(uint8_t packetId) const {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST) return 0;
+  return _values[packetId - OI_PACKET_FIRST];
+}
+
+void RoombaSimulator::injectGarbage(uint8_t count) {
+  uint64_t at = HostClock::now() + _latency;
+  while (count--) {
+    TxByte b = { at, (uint8_t)random() };
+    _tx.push_back(b);
+  }
+}
+
+// Total command length given the bytes seen so far; 0 for unknown opcodes
+uint16_t RoombaSimulator::expectedLength(const uint8_t* cmd, uint8_t length) const {
+  switch (cmd[0]) {
+    case OI_START: case OI_SAFE: case OI_FULL: case OI_POWER:
+    case OI_SPOT: case OI_CLEAN: case OI_MAX_CLEAN: case OI_SEEK_DOCK:
+    case SIM_OP_STOP:
+      return 1;
+    case OI_BAUD: case OI_MOTORS: case OI_PLAY: case OI_SENSORS:
+    case SIM_OP_DIGITAL_OUT: case SIM_OP_PAUSE_RESUME:
+      return 2;
+    case OI_LEDS: case SIM_OP_PWM_MOTORS:
+      return 4;
+    case OI_DRIVE: case OI_DRIVE_DIRECT: case SIM_OP_DRIVE_PWM:
+      return 5;
+    case OI_SONG:
+      // [140][song][n][note, duration]...
+      return length < 3 ? 3 : 3 + 2 * cmd[2];
+    case OI_STREAM: case OI_QUERY_LIST: {
+      // [op][n][ids...]
+      if (length < 2) return 2;
+      return 2 + cmd[1];
+    }
+    default:
+      return 0;
+  }
+}
+
+void RoombaSimulator::execute(const uint8_t* cmd, uint8_t length) {
+  uint64_t now = HostClock::now();
+
+  switch (cmd[0]) {
+    case OI_START:
+      if (_mode == SIM_MODE_OFF) _mode = SIM_MODE_PASSIVE;
+      break;
+
+    case OI_SAFE:
+      if (_mode != SIM_MODE_OFF) _mode = SIM_MODE_SAFE;
+      break;
+
+    case OI_FULL:
+      if (_mode != SIM_MODE_OFF) _mode = SIM_MODE_FULL;
+      break;
+
+    case OI_POWER:
+    case SIM_OP_STOP:
+      _mode = SIM_MODE_OFF;
+      _leftVelocity = _rightVelocity = 0;
+      _streamCount = 0;
+      break;
+
+    case OI_SPOT:
+    case OI_CLEAN:
+    case OI_MAX_CLEAN:
+    case OI_SEEK_DOCK:
+      // Cleaning behaviours hand control back to the robot
+      if (_mode != SIM_MODE_OFF) _mode = SIM_MODE_PASSIVE;
+      _leftVelocity = _rightVelocity = 0;
+      break;
+
+    case OI_DRIVE:
+      if (_mode >= SIM_MODE_SAFE) {
+        drive((int16_t)((cmd[1] << 8) | cmd[2]), (int16_t)((cmd[3] << 8) | cmd[4]));
+      }
+      break;
+
+    case OI_DRIVE_DIRECT:
+      if (_mode >= SIM_MODE_SAFE) {
+        _rightVelocity = constrain((int16_t)((cmd[1] << 8) | cmd[2]), MIN_VELOCITY, MAX_VELOCITY);
+        _leftVelocity = constrain((int16_t)((cmd[3] << 8) | cmd[4]), MIN_VELOCITY, MAX_VELOCITY);
+        setPacket(SENSOR_REQUESTED_RIGHT_VELOCITY, _rightVelocity);
+        setPacket(SENSOR_REQUESTED_LEFT_VELOCITY, _leftVelocity);
+      }
+      break;
+
+    case OI_SENSORS: {
+      uint8_t data[OI_PACKET_DATA_BYTES];
+      uint8_t size = encodePacket(cmd[1], data);
+      if (size > 0) emit(data, size, now);
+      break;
+    }
+
+    case OI_QUERY_LIST: {
+      uint8_t data[OI_PACKET_DATA_BYTES];
+      for (uint8_t i = 0; i + 2 < length; i++) {
+        uint8_t size = encodePacket(cmd[2 + i], data);
+        if (size > 0) emit(data, size, now);
+      }
+      break;
+    }
+
+    case OI_STREAM: {
+      uint8_t count = length - 2; // cmd[1] ids, as framed by expectedLength()
+      for (uint8_t i = 0; i < count; i++) {
+        if (RoombaPackets::size(cmd[2 + i]) == 0) return; // Whole request ignored
+      }
+      memcpy(_streamIds, cmd + 2, count);
+      _streamCount = count;
+      _streamPaused = false;
+      _nextFrame = now + SIM_STREAM_PERIOD_US;
+      setPacket(SENSOR_STREAM_PACKETS, count);
+      break;
+    }
+
+    case OI_BAUD: {
+      uint32_t baud = RoombaOI::baudRateForCode(cmd[1]);
+      if (baud != 0) _baud = baud;
+      break;
+    }
+
+    case SIM_OP_PAUSE_RESUME:
+      _streamPaused = (cmd[1] == 0);
+      if (!_streamPaused) _nextFrame = now + SIM_STREAM_PERIOD_US;
+      break;
+
+    default:
+      break; // Accepted and ignored (LEDs, motors, songs...)
+  }
+
+  setPacket(SENSOR_OI_MODE, _mode);
+}
+
+void RoombaSimulator::drive(int16_t velocity, int16_t radius) {
+  velocity = constrain(velocity, MIN_VELOCITY, MAX_VELOCITY);
+  setPacket(SENSOR_REQUESTED_VELOCITY, velocity);
+  setPacket(SENSOR_REQUESTED_RADIUS, radius);
+
+  if (radius == (int16_t)DRIVE_STRAIGHT || radius == 32767) {
+    _leftVelocity = _rightVelocity = velocity;
+  } else if (radius == DRIVE_TURN_CCW) {
+    _leftVelocity = -velocity;
+    _rightVelocity = velocity;
+  } else if (radius == DRIVE_TURN_CW) {
+    _leftVelocity = velocity;
+    _rightVelocity = -velocity;
+  } else {
+    // Velocity is that of the centre; each wheel scales with its own radius
+    double half = SIM_WHEEL_BASE_MM / 2;
+    _leftVelocity = (int16_t)(velocity * (radius - half) / radius);
+    _rightVelocity = (int16_t)(velocity * (radius + half) / radius);
+  }
+}
+
+void RoombaSimulator::integrate(uint64_t until) {
+  if (until <= _lastUpdate) return;
+  double dt = (until - _lastUpdate) / 1000000.0;
+  _lastUpdate = until;
+
+  if (_leftVelocity == 0 && _rightVelocity == 0) return;
+
+  double left = _leftVelocity * dt;
+  double right = _rightVelocity * dt;
+  double center = (left + right) / 2;
+  double turn = (right - left) / SIM_WHEEL_BASE_MM;
+
+  double heading = _theta + turn / 2;
+  _x += center * cos(heading);
+  _y += center * sin(heading);
+  _theta += turn;
+
+  _leftCounts += left / SIM_MM_PER_COUNT;
+  _rightCounts += right / SIM_MM_PER_COUNT;
+  _distance += center;
+  _angle += turn * SIM_DEGREES_PER_RADIAN;
+
+  setPacket(SENSOR_LEFT_ENCODER, (int32_t)((int64_t)floor(_leftCounts) & 0xFFFF));
+  setPacket(SENSOR_RIGHT_ENCODER, (int32_t)((int64_t)floor(_rightCounts) & 0xFFFF));
+  setPacket(SENSOR_DISTANCE, (int32_t)_distance);
+  setPacket(SENSOR_ANGLE, (int32_t)_angle);
+}
+
+// Big-endian packet data for a single or group id; 0 for unknown ids
+uint8_t RoombaSimulator::encodePacket(uint8_t packetId, uint8_t* out) {
+  uint8_t first, last;
+  if (!RoombaPackets::range(packetId, first, last)) return 0;
+
+  uint8_t length = 0;
+  for (uint8_t id = first; id <= last; id++) {
+    OIPacketInfo info;
+    RoombaPackets::info(id, info);
+    int32_t value = getPacket(id);
+
+    // Distance and angle are reported since the last report
+    if (id == SENSOR_DISTANCE) {
+      _distance -= (int32_t)_distance;
+      setPacket(SENSOR_DISTANCE, 0);
+    } else if (id == SENSOR_ANGLE) {
+      _angle -= (int32_t)_angle;
+      setPacket(SENSOR_ANGLE, 0);
+    }
+
+    if (info.size == 2) out[length++] = (uint8_t)(value >> 8);
+    out[length++] = (uint8_t)value;
+  }
+  return length;
+}
+
+void RoombaSimulator::sendFrame() {
+  uint8_t frame[255];
+  uint16_t length = 2;
+
+  for (uint8_t i = 0; i < _streamCount; i++) {
+    uint8_t size = RoombaPackets::size(_streamIds[i]);
+    if (length + 1 + size >= (uint16_t)sizeof(frame)) return; // Too big for the length byte
+    frame[length++] = _streamIds[i];
+    length += encodePacket(_streamIds[i], frame + length);
+  }
+
+  frame[0] = OI_STREAM_HEADER;
+  frame[1] = (uint8_t)(length - 2);
+
+  uint8_t sum = 0;
+  for (uint16_t i = 0; i < length; i++) sum += frame[i];
+  frame[length++] = (uint8_t)(0x100 - sum);
+
+  emit(frame, (uint8_t)length, _nextFrame);
+  _stats.framesSent++;
+}
+
+void RoombaSimulator::emit(const uint8_t* data, uint8_t length, uint64_t at) {
+  uint64_t readyAt = at + _latency;
+  if (!_tx.empty() && _tx.back().readyAt > readyAt) readyAt = _tx.back().readyAt;
+
+  for (uint8_t i = 0; i < length; i++) {
+    if (chance(_dropRate)) {
+      _stats.bytesDropped++;
+      continue;
+    }
+
+    TxByte b = { readyAt, data[i] };
+    if (chance(_corruptRate)) {
+      b.value ^= (uint8_t)(1 + random() % 255);
+      _stats.bytesCorrupted++;
+    }
+    _tx.push_back(b);
+    _stats.bytesSent++;
+  }
+}
+
+// xorshift32: cheap and reproducible for a given seed
+uint32_t RoombaSimulator::random() {
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return _rng;
+}
+
+bool RoombaSimulator::chance(float probability) {
+  if (probability <= 0) return false;
+  return random() < (uint32_t)(probability * 4294967295.0);
+}
@@ -0,0 +1,156 @@
+/**
+ * @file RoombaSimulator.h
+ * @brief Simulated Create 2 behind a Stream, for host builds
+ *
+ * Plugs in wherever RoombaOI expects a serial port (it is a RoombaTransport,
+ * so begin() sets the library side's baud rate). Bytes written by the
+ * library are parsed as OI commands; drive commands move a differential-drive
+ * model (wheel base, encoder counts, distance/angle) and sensor replies and
+ * OI_STREAM frames are generated from the packet table in RoombaPackets.h.
+ *
+ * Time comes from HostClock: every call to available()/read() first brings
+ * the model up to HostClock::now(), emitting one stream frame per 15 ms
+ * period. Noise, dropped bytes and reply latency are injected on the robot's
+ * TX side from a seeded PRNG, so runs are repeatable.
+ *
+ * sleep() models the robot dozing off: it stops streaming and ignores the
+ * port until a falling edge on the BRC pin given to setBrcPin() wakes it,
+ * back in OFF mode and waiting for OI_START.
+ */
+
+#ifndef ARDUROOMBA_HOST_ROOMBA_SIMULATOR_H
+#define ARDUROOMBA_HOST_ROOMBA_SIMULATOR_H
+
+#include <Arduino.h>
+#include <RoombaOI.h>
+
+#include <deque>
+
+#define SIM_STREAM_PERIOD_US 15000
+#define SIM_WHEEL_BASE_MM    235.0
+#define SIM_MM_PER_COUNT     (72.0 * 3.14159265358979 / 508.8)
+
+// OI modes as reported in packet 35
+enum SimulatorMode : uint8_t {
+  SIM_MODE_OFF     = 0,
+  SIM_MODE_PASSIVE = 1,
+  SIM_MODE_SAFE    = 2,
+  SIM_MODE_FULL    = 3
+};
+
+struct RoombaSimulatorStats {
+  uint32_t commands;       // Complete OI commands parsed
+  uint32_t unknownBytes;   // Bytes that did not start a known opcode
+  uint32_t framesSent;     // Stream frames emitted
+  uint32_t bytesSent;      // Bytes queued for the library (after drops)
+  uint32_t bytesDropped;
+  uint32_t bytesCorrupted;
+  uint32_t baudErrors;     // Bytes garbled by a baud rate mismatch or limit
+};
+
+class RoombaSimulator : public RoombaTransport {
+public:
+  explicit RoombaSimulator(uint32_t seed = 1);
+
+  // Back to power-on state (clock and fault settings are kept)
+  void reset();
+
+  // Advance the model to HostClock::now(); called by available()/read()
+  void update();
+
+  // Transport interface (library side); rate 0 always matches the robot
+  void begin(uint32_t baudRate) { _hostBaud = baudRate; }
+  void end() {}
+  int available();
+  int read();
+  int peek();
+  size_t write(uint8_t byte);
+  using Print::write;
+
+  // World inputs
+  void setBumpers(bool left, bool right);
+  void setWall(bool wall);
+  void setBattery(uint16_t millivolts, int16_t milliamps);
+  void setPacket(uint8_t packetId, int32_t value); // Any single packet 7-58
+  int32_t getPacket(uint8_t packetId) const;
+
+  // Faults on the robot's TX side
+  void setLatency(uint32_t micros) { _latency = micros; }
+  void setDropRate(float probability) { _dropRate = probability; }
+  void setCorruptionRate(float probability) { _corruptRate = probability; }
+  void injectGarbage(uint8_t count);
+  // Fastest rate the library can receive cleanly (0 = any), e.g. SoftwareSerial RX;
+  // above it replies garble while commands still get through
+  void setBaudLimit(uint32_t baudRate) { _baudLimit = baudRate; }
+
+  // Sleep until woken by a BRC pulse (pin 0xFF = never)
+  void setBrcPin(uint8_t pin);
+  void sleep();
+  bool isAsleep() const { return _asleep; }
+
+  // Model state
+  SimulatorMode getMode() const { return _mode; }
+  uint32_t getBaudRate() const { return _baud; } // Robot side, set by OI_BAUD
+  bool isStreaming() const { return _streamCount > 0 && !_streamPaused; }
+  double getX() const { return _x; }           // mm
+  double getY() const { return _y; }           // mm
+  double getHeading() const { return _theta; } // radians, CCW positive
+  int16_t getLeftVelocity() const { return _leftVelocity; }
+  int16_t getRightVelocity() const { return _rightVelocity; }
+
+  const RoombaSimulatorStats& getStats() const { return _stats; }
+
+private:
+  struct TxByte {
+    uint64_t readyAt;
+    uint8_t value;
+  };
+
+  uint32_t _rng;
+  uint32_t _latency;
+  float _dropRate;
+  float _corruptRate;
+  uint32_t _baudLimit;
+  uint32_t _hostBaud;
+  uint8_t _brcPin;
+  uint32_t _brcEdges;      // Falling edges already seen
+
+  // Command parser
+  uint8_t _cmd[OI_TX_FRAME_MAX + 2];
+  uint8_t _cmdLength;
+
+  // Model
+  SimulatorMode _mode;
+  uint32_t _baud;
+  bool _asleep;
+  int16_t _leftVelocity, _rightVelocity;
+  double _x, _y, _theta;
+  double _leftCounts, _rightCounts;
+  double _distance, _angle; // Accumulated since the last report
+  int32_t _values[OI_PACKET_COUNT];
+  uint64_t _lastUpdate;
+
+  // Stream
+  uint8_t _streamIds[OI_TX_FRAME_MAX];
+  uint8_t _streamCount;
+  bool _streamPaused;
+  uint64_t _nextFrame;
+
+  std::deque<TxByte> _tx;
+  RoombaSimulatorStats _stats;
+
+  bool rateMismatch() const { return _hostBaud != 0 && _hostBaud != _baud; }
+  bool replyGarbled() const { return rateMismatch() || (_baudLimit != 0 && _baud > _baudLimit); }
+  uint16_t expectedLength(const uint8_t* cmd, uint8_t length) const;
+  void execute(const uint8_t* cmd, uint8_t length);
+  void drive(int16_t velocity, int16_t radius);
+  void integrate(uint64_t until);
+
+  uint8_t encodePacket(uint8_t packetId, uint8_t* out);
+  void sendFrame();
+  void emit(const uint8_t* data, uint8_t length, uint64_t at);
+  uint32_t random();
+  bool chance(float probability);
+};
+
+#endif
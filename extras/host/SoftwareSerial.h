@@ -0,0 +1,18 @@
+/**
+ * @file SoftwareSerial.h
+ * @brief Host stand-in for SoftwareSerial (an unconnected MockStream)
+ */
+
+#ifndef ARDUROOMBA_HOST_SOFTWARE_SERIAL_H
+#define ARDUROOMBA_HOST_SOFTWARE_SERIAL_H
+
+#include "MockStream.h"
+
+class SoftwareSerial : public MockStream {
+public:
+  SoftwareSerial(uint8_t, uint8_t) {}
+  void begin(long) {}
+  void end() {}
+};
+
+#endif
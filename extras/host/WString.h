@@ -0,0 +1,53 @@
+/**
+ * @file WString.h
+ * @brief Heap-backed String subset for host builds
+ *
+ * Mirrors the Arduino String members the library uses; like the original,
+ * every construction and concatenation allocates.
+ */
+
+#ifndef ARDUROOMBA_HOST_WSTRING_H
+#define ARDUROOMBA_HOST_WSTRING_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+class String {
+public:
+  String(const char* s = "") { init(s ? s : "", s ? strlen(s) : 0); }
+  String(const String& o) { init(o._buf, o._len); }
+  String(char c) { char b[2] = {c, 0}; init(b, 1); }
+  String(int v) { char b[16]; snprintf(b, sizeof(b), "%d", v); init(b, strlen(b)); }
+  String(unsigned int v) { char b[16]; snprintf(b, sizeof(b), "%u", v); init(b, strlen(b)); }
+  String(long v) { char b[24]; snprintf(b, sizeof(b), "%ld", v); init(b, strlen(b)); }
+  String(unsigned long v) { char b[24]; snprintf(b, sizeof(b), "%lu", v); init(b, strlen(b)); }
+  String(double v, unsigned char decimals = 2) { char b[40]; snprintf(b, sizeof(b), "%.*f", decimals, v); init(b, strlen(b)); }
+  ~String() { free(_buf); }
+  String& operator=(const String& o) { if (this != &o) { free(_buf); init(o._buf, o._len); } return *this; }
+  String& operator+=(const String& o) { append(o._buf, o._len); return *this; }
+  String& operator+=(const char* s) { append(s, strlen(s)); return *this; }
+  String& operator+=(char c) { append(&c, 1); return *this; }
+  friend String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+  friend String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+  friend String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+  bool operator==(const String& o) const { return _len == o._len && memcmp(_buf, o._buf, _len) == 0; }
+  bool operator==(const char* s) const { return strcmp(_buf, s) == 0; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+  bool reserve(unsigned int size) { if (size > _len) _buf = (char*)realloc(_buf, size + 1); return _buf != 0; }
+  unsigned int length() const { return _len; }
+  const char* c_str() const { return _buf; }
+  char operator[](unsigned int i) const { return i < _len ? _buf[i] : 0; }
+  int indexOf(char c, unsigned int from = 0) const { const char* p = from < _len ? strchr(_buf + from, c) : 0; return p ? (int)(p - _buf) : -1; }
+  int indexOf(const String& s, unsigned int from = 0) const { const char* p = from < _len ? strstr(_buf + from, s._buf) : 0; return p ? (int)(p - _buf) : -1; }
+  String substring(unsigned int from, unsigned int to) const { if (to > _len) to = _len; if (from > to) from = to; String r; free(r._buf); r.init(_buf + from, to - from); return r; }
+  String substring(unsigned int from) const { return substring(from, _len); }
+  bool startsWith(const String& s) const { return s._len <= _len && memcmp(_buf, s._buf, s._len) == 0; }
+  long toInt() const { return atol(_buf); }
+private:
+  char* _buf; unsigned int _len;
+  void init(const char* s, unsigned int n) { _buf = (char*)malloc(n + 1); memcpy(_buf, s, n); _buf[n] = 0; _len = n; }
+  void append(const char* s, unsigned int n) { _buf = (char*)realloc(_buf, _len + n + 1); memcpy(_buf + _len, s, n); _len += n; _buf[_len] = 0; }
+};
+
+#endif
@@ -0,0 +1,282 @@
+/**
+ * @file ArduRoombaTests.cpp
+ * @brief ArduRoomba against the simulated Create 2
+ */
+
+#include "Test.h"
+
+#include <ArduRoomba.h>
+#include <RoombaSimulator.h>
+
+#define BRC_PIN 5
+
+// Calls tick() every 500 us of virtual time for ms milliseconds
+static void run(ArduRoomba& roomba, unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    roomba.tick();
+    HostClock::advanceMicros(500);
+  }
+}
+
+TEST(RefreshSensorsSubscribesHighPackets) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  sim.setPacket(SENSOR_STASIS, 1);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 50);
+  CHECK(!roomba.getSensorCache().has(SENSOR_STASIS));
+
+  // Packets above 38 need the full 64-bit subscription mask
+  static const uint8_t ids[] = { SENSOR_GROUP_54_58 };
+  CHECK(roomba.refreshSensors(ids, 1));
+  run(roomba, 50);
+  CHECK(roomba.getSensorCache().has(SENSOR_STASIS));
+  CHECK(roomba.getSensorCache().has(SENSOR_LEFT_MOTOR_CURRENT));
+  CHECK_EQ(roomba.getSensorCache().values().get<SENSOR_STASIS>(), 1);
+  CHECK(roomba.getSensorCache().has(SENSOR_VOLTAGE));
+}
+
+TEST(RefreshSensorsKeepsStreamWhenTooLarge) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 50);
+
+  // All 52 packets do not fit one stream frame
+  static const uint8_t ids[] = { SENSOR_GROUP_ALL };
+  CHECK(!roomba.refreshSensors(ids, 1));
+  CHECK(roomba.isStreaming());
+
+  // The old subscription is still what gets requested, so a smaller one works
+  static const uint8_t small[] = { SENSOR_GROUP_54_58 };
+  CHECK(roomba.refreshSensors(small, 1));
+  run(roomba, 50);
+  CHECK(roomba.getSensorCache().has(SENSOR_STASIS));
+  CHECK(!roomba.getSensorCache().has(SENSOR_LIGHT_BUMP_LEFT));
+}
+
+TEST(StreamedGetterRejectsStaleValues) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  sim.setBattery(15800, -1200);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 50);
+  CHECK_EQ(roomba.getBatteryVoltage(), 15800);
+
+  // The stream stalls: nothing arrives, and tick() is not called either
+  sim.setDropRate(1.0f);
+  HostClock::advance(SENSOR_MAX_AGE_DEFAULT + 50);
+  CHECK(roomba.isStreaming());
+  CHECK_EQ(roomba.getBatteryVoltage(), 0);
+  CHECK_EQ(roomba.getBatteryVoltage(1000), 15800);
+}
+
+TEST(GetterDoesNotRunControlLoop) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  roomba.setTxBatching(true);
+  roomba.moveForward(200);     // Queued in the TX batch until tick()
+  run(roomba, 0);
+
+  for (int i = 0; i < 20; i++) {
+    roomba.getBatteryVoltage();
+    HostClock::advance(5);
+  }
+  CHECK_EQ(sim.getLeftVelocity(), 0);
+
+  roomba.tick();
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 200);
+}
+
+TEST(GetterSubscribesMissingPacket) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  sim.setPacket(SENSOR_TEMPERATURE, 31);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 50);
+
+  CHECK_EQ(roomba.get<SENSOR_TEMPERATURE>(), 0); // Not streamed yet
+  run(roomba, 50);
+  CHECK_EQ(roomba.get<SENSOR_TEMPERATURE>(), 31);
+}
+
+TEST(IdleLinkAnswersProbes) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  roomba.stopSensorStream();
+
+  run(roomba, 5000);
+  const RoombaLinkHealth& health = roomba.getLinkHealth();
+  CHECK(health.replies >= 4);
+  CHECK_EQ(health.timeouts, 0);
+  CHECK_EQ(health.losses, 0);
+  CHECK(roomba.isConnected());
+  CHECK(!roomba.isStreaming());
+  CHECK(!sim.isStreaming());
+}
+
+TEST(ReconnectKeepsStoppedStreamOff) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  roomba.stopSensorStream();
+
+  sim.sleep();
+  run(roomba, 10000);
+  CHECK_EQ(roomba.getLinkHealth().losses, 1);
+  CHECK(roomba.isConnected());
+  CHECK(!roomba.isStreaming());
+  CHECK(!sim.isStreaming());
+}
+
+TEST(NoisyReconnectKeepsPose) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  roomba.enableOdometry();
+  roomba.moveForward(200);
+
+  // Enough corruption that runs of bad frames restart the link
+  sim.setCorruptionRate(0.02f);
+  sim.setDropRate(0.02f);
+  run(roomba, 15000);
+  CHECK(roomba.getLinkHealth().losses > 0);
+  CHECK_EQ(roomba.getLinkHealth().lastLoss, LINK_LOSS_CHECKSUM);
+
+  double x = roomba.getPose().x / 1000.0; // mm
+  CHECK(x > sim.getX() - 50 && x < sim.getX() + 50);
+}
+
+TEST(SleepResetsPose) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  roomba.enableOdometry();
+  roomba.moveForward(200);
+  run(roomba, 1000);
+  CHECK(roomba.getPose().x > 150000);
+
+  sim.sleep();
+  run(roomba, 10000);
+  CHECK_EQ(roomba.getLinkHealth().lastLoss, LINK_LOSS_SILENCE);
+  CHECK(roomba.isConnected());
+  CHECK_EQ(roomba.getPose().x, 0);
+}
+
+TEST(StreamRecoversFromCorruption) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  sim.setBattery(15800, -1200);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  sim.setCorruptionRate(0.01f);
+  sim.setDropRate(0.01f);
+
+  run(roomba, 5000);
+  const RoombaStreamStats& stream = roomba.getStreamStats();
+  CHECK(stream.badFrames > 0);
+  CHECK(stream.goodFrames > 250); // A frame every 15 ms
+  CHECK_EQ(roomba.getLinkHealth().losses, 0);
+  CHECK_EQ(roomba.getBatteryVoltage(), 15800); // Only validated frames reach the cache
+}
+
+TEST(SleepingRobotWakesOverBrc) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 100);
+  uint32_t edges = HostPins::fallingEdges(BRC_PIN);
+
+  sim.sleep();
+  run(roomba, 1100); // A second of silence
+  CHECK(!roomba.isConnected());
+  CHECK_EQ(roomba.getLinkHealth().lastLoss, LINK_LOSS_SILENCE);
+
+  run(roomba, 5000);
+  CHECK_EQ(HostPins::fallingEdges(BRC_PIN) - edges, 3);
+  CHECK(!sim.isAsleep());
+  CHECK(roomba.isConnected());
+  CHECK(roomba.isStreaming() && sim.isStreaming());
+  CHECK_EQ(roomba.getLinkHealth().losses, 1);
+  CHECK_EQ(roomba.getLinkHealth().wakes, 1);
+  CHECK(roomba.getBatteryVoltage() > 0);
+}
+
+TEST(TimedDrivesReplaceEachOther) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+
+  // A remote resending its drive with a 500 ms deadman
+  CHECK(roomba.queueCommand(ROOMBA_ACTION_FORWARD, 200, 0, 500));
+  run(roomba, 100);
+  CHECK(roomba.queueCommand(ROOMBA_ACTION_FORWARD, 300, 0, 500));
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 300);
+
+  // The deadline restarted with the second frame
+  run(roomba, 450);
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 300);
+  run(roomba, 100);
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 0);
+  CHECK(!roomba.isBusy());
+}
+
+TEST(AppendedCommandsWaitForDeadline) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+
+  CHECK(roomba.appendCommand(ROOMBA_ACTION_FORWARD, 200, 0, 500));
+  CHECK(roomba.appendCommand(ROOMBA_ACTION_BACKWARD, 100, 0, 500));
+  run(roomba, 100);
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 200);
+  run(roomba, 500);
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), -100);
+}
+
+TEST(OISensorReadsLeaveStreamAlone) {
+  RoombaSimulator sim;
+  sim.setBrcPin(BRC_PIN);
+  sim.setBattery(15800, -1200);
+  ArduRoomba roomba(sim, BRC_PIN);
+  CHECK(roomba.begin());
+  run(roomba, 50);
+
+  // OI-level reads between ticks must not drain the port or send queries
+  RoombaOI& oi = roomba.getOI();
+  uint32_t goodFrames = oi.getStreamStats().goodFrames;
+  bool correct = true;
+  for (int i = 0; i < 300; i++) {
+    HostClock::advanceMicros(500);
+    correct = correct && oi.getBatteryVoltage() == 15800;
+    roomba.tick();
+  }
+  CHECK(correct);
+  CHECK_EQ(oi.getStreamStats().badFrames, 0);
+  CHECK(oi.getStreamStats().goodFrames >= goodFrames + 9); // 150 ms of frames
+  CHECK_EQ(roomba.getLinkHealth().timeouts, 0);
+
+  uint8_t raw[2];
+  CHECK(!oi.getSensor(SENSOR_VOLTAGE, raw, sizeof(raw)));
+}
@@ -0,0 +1,314 @@
+/**
+ * @file ExtensionTests.cpp
+ * @brief Command, binary, HTTP and WebSocket parsing shared by the WiFi/BLE
+ *        extensions, and the /status response
+ */
+
+#include "Test.h"
+
+#include <MockStream.h>
+#include <RoombaSimulator.h>
+#include <ArduRoomba.h>
+#include <extensions/ArduRoombaWiFi.h>
+#include <extensions/ArduRoombaCommand.h>
+#include <extensions/ArduRoombaBinary.h>
+#include <extensions/ArduRoombaHttp.h>
+#include <extensions/ArduRoombaWebSocket.h>
+
+TEST(CommandActionNames) {
+  CHECK_EQ(RoombaCommandParser::actionFromName("forward"), ROOMBA_ACTION_FORWARD);
+  CHECK_EQ(RoombaCommandParser::actionFromName("stop"), ROOMBA_ACTION_STOP);
+  CHECK_EQ(RoombaCommandParser::actionFromName("dock"), ROOMBA_ACTION_DOCK);
+  CHECK_EQ(RoombaCommandParser::actionFromName("forwards"), ROOMBA_ACTION_NONE);
+  CHECK_EQ(RoombaCommandParser::actionFromName("forward", 4), ROOMBA_ACTION_NONE);
+  CHECK_EQ(RoombaCommandParser::actionFromName(""), ROOMBA_ACTION_NONE);
+  CHECK_EQ(RoombaCommandParser::defaultSpeed(ROOMBA_ACTION_LEFT), 150);
+}
+
+TEST(CommandParseFields) {
+  RoombaCommand cmd;
+  const char* text = "forward:300:1500";
+  CHECK(RoombaCommandParser::parseCommand(text, strlen(text), cmd));
+  CHECK(strcmp(cmd.action, "forward") == 0);
+  CHECK_EQ(cmd.speed, 300);
+  CHECK_EQ(cmd.duration, 1500);
+
+  text = "left";
+  CHECK(RoombaCommandParser::parseCommand(text, strlen(text), cmd, 150));
+  CHECK(strcmp(cmd.action, "left") == 0);
+  CHECK_EQ(cmd.speed, 150);
+  CHECK_EQ(cmd.duration, 0);
+
+  // Over-long actions are truncated, never overflowed
+  text = "averyveryverylongaction:1";
+  CHECK(RoombaCommandParser::parseCommand(text, strlen(text), cmd));
+  CHECK_EQ(strlen(cmd.action), sizeof(cmd.action) - 1);
+
+  CHECK(!RoombaCommandParser::parseCommand(text, 0, cmd));
+}
+
+TEST(CommandParseInt) {
+  CHECK_EQ(RoombaCommandParser::parseInt("250", 3), 250);
+  CHECK_EQ(RoombaCommandParser::parseInt(" -75x", 5), -75);
+  CHECK_EQ(RoombaCommandParser::parseInt("abc", 3), 0);
+  CHECK_EQ(RoombaCommandParser::parseInt("12345", 2), 12);
+}
+
+TEST(BinaryCommandRoundTrip) {
+  RoombaBinaryCommand in = { 7, ROOMBA_ACTION_DRIVE_DIRECT, 200, -200, 0 };
+  uint8_t frame[16];
+  size_t length = RoombaBinaryProtocol::encodeCommand(in, frame, sizeof(frame));
+  CHECK(length > 0);
+  CHECK(RoombaBinaryProtocol::isBinary(frame, length));
+
+  RoombaBinaryCommand out;
+  CHECK(RoombaBinaryProtocol::decodeCommand(frame, length, out));
+  CHECK_EQ(out.action, ROOMBA_ACTION_DRIVE_DIRECT);
+  CHECK_EQ(out.arg0, 200);
+  CHECK_EQ(out.arg1, -200);
+
+  // Truncated frames are refused
+  CHECK(!RoombaBinaryProtocol::decodeCommand(frame, length - 1, out));
+  CHECK(!RoombaBinaryProtocol::isBinary((const uint8_t*)"forward", 7));
+}
+
+TEST(CommandMailboxNeverLosesStop) {
+  RoombaSimulator sim;
+  sim.setBrcPin(5);
+  ArduRoomba roomba(sim, 5);
+  CHECK(roomba.begin());
+
+  // loop() has fallen behind: the mailbox fills and refuses the next drive
+  RoombaCommandMailbox<4> mailbox;
+  RoombaBinaryCommand drive = { 0, ROOMBA_ACTION_FORWARD, 200, 0, 1000 };
+  while (mailbox.post(drive)) {}
+  CHECK_EQ(mailbox.dropped(), 1);
+
+  RoombaBinaryCommand stop = { 0, ROOMBA_ACTION_STOP, 0, 0, 0 };
+  CHECK(mailbox.post(stop));
+  mailbox.apply(roomba);
+  roomba.tick();
+  sim.update();
+  CHECK(!roomba.isBusy());
+  CHECK_EQ(sim.getLeftVelocity(), 0);
+
+  // Later commands go through as before
+  CHECK(mailbox.post(drive));
+  mailbox.apply(roomba);
+  roomba.tick();
+  sim.update();
+  CHECK_EQ(sim.getLeftVelocity(), 200);
+}
+
+static HttpParseResult feedRequest(RoombaHttpParser& parser, const char* request) {
+  HttpParseResult result = HTTP_PARSE_INCOMPLETE;
+  for (const char* c = request; *c; c++) result = parser.feed(*c);
+  return result;
+}
+
+TEST(HttpParseRequestLine) {
+  RoombaHttpParser parser;
+  CHECK_EQ(feedRequest(parser, "GET /cmd?action=forward&speed=2%300 HTTP/1.1\r\n"
+                               "Host: 192.168.4.1\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK_EQ(parser.method(), HTTP_METHOD_GET);
+  CHECK(strcmp(parser.path(), "/cmd") == 0);
+  CHECK_EQ(parser.paramCount(), 2);
+  CHECK(strcmp(parser.param("action"), "forward") == 0);
+  CHECK(strcmp(parser.param("speed"), "200") == 0);
+  CHECK(parser.param("duration") == nullptr);
+  CHECK(parser.keepAlive());
+}
+
+TEST(HttpQueryParams) {
+  RoombaHttpParser parser;
+  CHECK_EQ(feedRequest(parser, "GET /cmd?action=forward&speed=200&duration=1000 HTTP/1.1\r\n\r\n"),
+           HTTP_PARSE_DONE);
+  CHECK_EQ(parser.paramCount(), 3);
+  CHECK(strcmp(parser.param("speed"), "200") == 0);
+  CHECK(strcmp(parser.param("duration"), "1000") == 0);
+  CHECK(parser.param("spee") == nullptr);
+  CHECK(parser.param("radius") == nullptr);
+
+  parser.reset();
+  CHECK_EQ(feedRequest(parser, "GET /cmd?action=stop&speed= HTTP/1.1\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(strcmp(parser.param("action"), "stop") == 0);
+  CHECK(strcmp(parser.param("speed"), "") == 0);
+}
+
+TEST(HttpConnectionHeader) {
+  RoombaHttpParser parser;
+  CHECK_EQ(feedRequest(parser, "GET / HTTP/1.1\r\nConnection: close\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(!parser.keepAlive());
+
+  parser.reset();
+  CHECK_EQ(feedRequest(parser, "GET / HTTP/1.0\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(!parser.keepAlive());
+
+  parser.reset();
+  CHECK_EQ(feedRequest(parser, "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(parser.keepAlive());
+}
+
+TEST(HttpParseErrors) {
+  RoombaHttpParser parser;
+  CHECK_EQ(feedRequest(parser, "GET cmd HTTP/1.1\r\n\r\n"), HTTP_PARSE_ERROR);
+  CHECK_EQ(parser.errorStatus(), 400);
+
+  parser.reset();
+  CHECK_EQ(feedRequest(parser, "GET /a HTTP/2.0\r\n\r\n"), HTTP_PARSE_ERROR);
+  CHECK_EQ(parser.errorStatus(), 505);
+
+  // Path longer than HTTP_MAX_PATH
+  char request[HTTP_MAX_PATH + 32] = "GET /";
+  size_t length = strlen(request);
+  while (length < HTTP_MAX_PATH + 8) request[length++] = 'a';
+  request[length] = '\0';
+  parser.reset();
+  CHECK_EQ(feedRequest(parser, request), HTTP_PARSE_ERROR);
+  CHECK_EQ(parser.errorStatus(), 414);
+
+  // Headers beyond HTTP_MAX_HEADER_BYTES
+  parser.reset();
+  feedRequest(parser, "GET / HTTP/1.1\r\n");
+  HttpParseResult result = HTTP_PARSE_INCOMPLETE;
+  for (int i = 0; i < HTTP_MAX_HEADER_BYTES && result == HTTP_PARSE_INCOMPLETE; i++) {
+    result = feedRequest(parser, "X-Pad: 0123456789\r\n");
+  }
+  CHECK_EQ(result, HTTP_PARSE_ERROR);
+  CHECK_EQ(parser.errorStatus(), 431);
+}
+
+TEST(HttpWebSocketUpgrade) {
+  RoombaHttpParser parser;
+  CHECK_EQ(feedRequest(parser, "GET / HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                               "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n"),
+           HTTP_PARSE_DONE);
+  CHECK(parser.isWebSocketUpgrade());
+
+  // RFC 6455 section 1.3 example
+  char accept[WS_ACCEPT_LENGTH + 1];
+  RoombaWebSocket::acceptKey(parser.webSocketKey(), accept);
+  CHECK(strcmp(accept, "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") == 0);
+}
+
+TEST(HttpResponseHead) {
+  char head[HTTP_RESPONSE_HEAD_MAX];
+  size_t length = RoombaHttpResponse::formatHead(head, sizeof(head), 200, "application/json", 12,
+                                                 HTTP_KEEP_ALIVE | HTTP_CORS);
+  CHECK(length > 0);
+  head[length] = '\0';
+  CHECK(strncmp(head, "HTTP/1.1 200 OK\r\n", 17) == 0);
+  CHECK(strstr(head, "Content-Length: 12\r\n") != nullptr);
+  CHECK(strstr(head, "Connection: keep-alive\r\n") != nullptr);
+  CHECK(strstr(head, "Access-Control-Allow-Origin: *\r\n") != nullptr);
+  CHECK(strcmp(head + length - 4, "\r\n\r\n") == 0);
+}
+
+// Masked client frame, as a browser sends it
+static uint8_t clientFrame(uint8_t opcode, const uint8_t* payload, uint8_t length, uint8_t* out) {
+  static const uint8_t mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+  out[0] = 0x80 | opcode;
+  out[1] = 0x80 | length;
+  memcpy(out + 2, mask, 4);
+  for (uint8_t i = 0; i < length; i++) out[6 + i] = payload[i] ^ mask[i & 3];
+  return length + 6;
+}
+
+static WebSocketFrameResult feedFrame(RoombaWebSocketDecoder& decoder, const uint8_t* data, uint8_t length) {
+  WebSocketFrameResult result = WS_FRAME_INCOMPLETE;
+  for (uint8_t i = 0; i < length; i++) result = decoder.feed(data[i]);
+  return result;
+}
+
+TEST(WebSocketDecodesMaskedFrames) {
+  RoombaWebSocketDecoder decoder;
+  uint8_t frame[64];
+  uint8_t length = clientFrame(WS_OP_TEXT, (const uint8_t*)"forward:200", 11, frame);
+  CHECK_EQ(feedFrame(decoder, frame, length), WS_FRAME_DONE);
+  CHECK_EQ(decoder.opcode(), WS_OP_TEXT);
+  CHECK_EQ(decoder.length(), 11);
+  CHECK(memcmp(decoder.payload(), "forward:200", 11) == 0);
+
+  // Back-to-back frames need no reset
+  static const uint8_t binary[] = { 1, 2, 3 };
+  length = clientFrame(WS_OP_BINARY, binary, sizeof(binary), frame);
+  CHECK_EQ(feedFrame(decoder, frame, length), WS_FRAME_DONE);
+  CHECK_EQ(decoder.opcode(), WS_OP_BINARY);
+  CHECK(memcmp(decoder.payload(), binary, sizeof(binary)) == 0);
+}
+
+TEST(WebSocketRejectsBadFrames) {
+  RoombaWebSocketDecoder decoder;
+  static const uint8_t unmasked[] = { 0x81, 0x01, 'x' };
+  CHECK_EQ(feedFrame(decoder, unmasked, sizeof(unmasked)), WS_FRAME_ERROR);
+  CHECK_EQ(decoder.errorCode(), WS_CLOSE_PROTOCOL);
+
+  decoder.reset();
+  uint8_t big[] = { 0x82, 0x80 | (WS_MAX_PAYLOAD + 1) };
+  CHECK_EQ(feedFrame(decoder, big, sizeof(big)), WS_FRAME_ERROR);
+  CHECK_EQ(decoder.errorCode(), WS_CLOSE_TOO_BIG);
+
+  // Fragmented messages are not supported
+  decoder.reset();
+  static const uint8_t fragment[] = { 0x01, 0x80 };
+  CHECK_EQ(feedFrame(decoder, fragment, sizeof(fragment)), WS_FRAME_ERROR);
+}
+
+TEST(WebSocketServerFrames) {
+  MockStream out;
+  static const uint8_t payload[] = { 0xAA, 0xBB };
+  RoombaWebSocket::writeFrame(out, WS_OP_BINARY, payload, sizeof(payload));
+  CHECK_EQ(out.written().size(), 4);
+  CHECK_EQ(out.written()[0], 0x82);
+  CHECK_EQ(out.written()[1], 2); // Servers never mask
+  CHECK_EQ(out.written()[3], 0xBB);
+}
+
+// Exposes the responses of the platform-neutral WiFi base class
+class TestWiFi : public ArduRoombaWiFi {
+public:
+  explicit TestWiFi(ArduRoomba& roomba) : ArduRoombaWiFi(roomba) {}
+
+  bool beginAP(const char*, const char*) { return true; }
+  bool beginClient(const char*, const char*) { return true; }
+  void end() {}
+  bool isConnected() const { return true; }
+  String getIPAddress() const { return String("0.0.0.0"); }
+
+  void status(Print& out, const char* fields) { respondStatus(out, fields, HTTP_KEEP_ALIVE); }
+};
+
+// Client socket where every write takes a millisecond
+class SlowClient : public Print {
+public:
+  std::vector<char> text;
+
+  size_t write(uint8_t byte) { return write(&byte, 1); }
+  size_t write(const uint8_t* data, size_t length) {
+    text.insert(text.end(), data, data + length);
+    HostClock::advance(1);
+    return length;
+  }
+};
+
+TEST(StatusContentLengthMatchesBody) {
+  RoombaSimulator sim;
+  sim.setBrcPin(5);
+  ArduRoomba roomba(sim, 5);
+  CHECK(roomba.begin());
+  TestWiFi wifi(roomba);
+
+  // link_ms_since_valid gains a digit while the head is being sent
+  HostClock::advance(99 - roomba.getTimeSinceValid());
+  CHECK_EQ(roomba.getTimeSinceValid(), 99);
+
+  SlowClient client;
+  wifi.status(client, "link");
+  client.text.push_back('\0');
+  const char* response = client.text.data();
+  const char* body = strstr(response, "\r\n\r\n");
+  const char* header = strstr(response, "Content-Length: ");
+  CHECK(body != nullptr && header != nullptr);
+  CHECK_EQ(strlen(body + 4), (size_t)atol(header + 16));
+  CHECK(strstr(body, "\"link_ms_since_valid\":99") != nullptr);
+}
@@ -0,0 +1,357 @@
+/**
+ * @file ProtocolTests.cpp
+ * @brief Stream parser, sensor cache, packet table, scheduler, rings and odometry
+ */
+
+#include "Test.h"
+
+#include <RoombaStreamParser.h>
+#include <RoombaSensorCache.h>
+#include <RoombaScheduler.h>
+#include <RoombaRingBuffer.h>
+#include <RoombaOdometry.h>
+
+// [19][n][payload][checksum] with the checksum that makes the sum zero
+static uint8_t streamFrame(const uint8_t* payload, uint8_t length, uint8_t* out) {
+  uint8_t sum = OI_STREAM_HEADER + length;
+  out[0] = OI_STREAM_HEADER;
+  out[1] = length;
+  for (uint8_t i = 0; i < length; i++) {
+    out[2 + i] = payload[i];
+    sum += payload[i];
+  }
+  out[2 + length] = (uint8_t)(0x100 - sum);
+  return length + 3;
+}
+
+static int feedAll(RoombaStreamParser& parser, const uint8_t* data, uint8_t length) {
+  int frames = 0;
+  for (uint8_t i = 0; i < length; i++) {
+    if (parser.feed(data[i])) frames++;
+  }
+  return frames;
+}
+
+// Voltage 15800 mV, current -1200 mA, wall on
+static const uint8_t BASIC_PAYLOAD[] = {
+  SENSOR_VOLTAGE, 0x3D, 0xB8, SENSOR_CURRENT, 0xFB, 0x50, SENSOR_WALL, 1
+};
+
+TEST(StreamParserDecodesFrame) {
+  uint8_t frame[16];
+  uint8_t length = streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), frame);
+
+  RoombaStreamParser parser;
+  CHECK_EQ(feedAll(parser, frame, length), 1);
+  CHECK_EQ(parser.getFrameLength(), sizeof(BASIC_PAYLOAD));
+
+  RoombaSensorSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  parser.decode(snapshot);
+  CHECK(snapshot.has(SENSOR_VOLTAGE));
+  CHECK(snapshot.has(SENSOR_WALL));
+  CHECK(!snapshot.has(SENSOR_BUMPS_DROPS));
+  CHECK_EQ(snapshot.get<SENSOR_VOLTAGE>(), 15800);
+  CHECK_EQ(snapshot.get<SENSOR_CURRENT>(), -1200);
+  CHECK_EQ(snapshot.value(SENSOR_WALL), 1);
+  CHECK_EQ(parser.getStats().goodFrames, 1);
+}
+
+TEST(StreamParserRejectsBadChecksum) {
+  uint8_t frame[16];
+  uint8_t length = streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), frame);
+  frame[length - 1] ^= 0x01;
+
+  RoombaStreamParser parser;
+  CHECK_EQ(feedAll(parser, frame, length), 0);
+  CHECK_EQ(parser.getStats().goodFrames, 0);
+  CHECK_EQ(parser.getStats().badFrames, 1);
+
+  // The next clean frame still gets through
+  frame[length - 1] ^= 0x01;
+  CHECK_EQ(feedAll(parser, frame, length), 1);
+}
+
+TEST(StreamParserRejectsBadLayout) {
+  // Packet 22 needs two data bytes, not one
+  static const uint8_t payload[] = { SENSOR_WALL, 1, SENSOR_VOLTAGE, 0x3D };
+  uint8_t frame[16];
+  uint8_t length = streamFrame(payload, sizeof(payload), frame);
+
+  RoombaStreamParser parser;
+  CHECK_EQ(feedAll(parser, frame, length), 0);
+  CHECK_EQ(parser.getStats().badFrames, 1);
+}
+
+TEST(StreamParserResyncsInsideRejectedFrame) {
+  // A corrupted length byte swallows the start of the next frame; the rescan
+  // has to find that frame's header among the rejected bytes
+  uint8_t good[16];
+  uint8_t goodLength = streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), good);
+
+  uint8_t data[48];
+  uint8_t length = 0;
+  data[length++] = OI_STREAM_HEADER;
+  data[length++] = 4;      // Claims four payload bytes
+  data[length++] = 0xAA;
+  memcpy(data + length, good, goodLength);
+  length += goodLength;
+
+  RoombaStreamParser parser;
+  CHECK_EQ(feedAll(parser, data, length), 1);
+  CHECK(parser.getStats().resyncs >= 1);
+  CHECK_EQ(parser.getStats().goodFrames, 1);
+
+  RoombaSensorSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  parser.decode(snapshot);
+  CHECK_EQ(snapshot.get<SENSOR_VOLTAGE>(), 15800);
+}
+
+TEST(StreamParserSkipsNoise) {
+  uint8_t data[32] = { 0x00, 0xFF, 0x42 };
+  uint8_t length = 3 + streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), data + 3);
+
+  RoombaStreamParser parser;
+  CHECK_EQ(feedAll(parser, data, length), 1);
+  CHECK_EQ(parser.getStats().droppedBytes, 3);
+}
+
+TEST(StreamParserRejectsOversizedLength) {
+  RoombaStreamParser parser;
+  CHECK(!parser.feed(OI_STREAM_HEADER));
+  CHECK(!parser.feed(OI_STREAM_MAX_PAYLOAD + 1));
+
+  uint8_t frame[16];
+  uint8_t length = streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), frame);
+  CHECK_EQ(feedAll(parser, frame, length), 1);
+}
+
+TEST(SensorCacheAgeAndFreshness) {
+  RoombaSensorCache cache;
+  CHECK(!cache.has(SENSOR_VOLTAGE));
+  CHECK(!cache.isFresh(SENSOR_VOLTAGE, 1000, 0));
+
+  static const uint8_t voltage[] = { 0x3D, 0xB8 };
+  cache.store(SENSOR_VOLTAGE, voltage, 100);
+  CHECK(cache.has(SENSOR_VOLTAGE));
+  CHECK_EQ(cache.values().get<SENSOR_VOLTAGE>(), 15800);
+  CHECK_EQ(cache.getAge(SENSOR_VOLTAGE, 150), 50);
+  CHECK(cache.isFresh(SENSOR_VOLTAGE, 50, 150));
+  CHECK(!cache.isFresh(SENSOR_VOLTAGE, 49, 150));
+
+  cache.clear();
+  CHECK(!cache.has(SENSOR_VOLTAGE));
+}
+
+TEST(SensorCacheStoresGroupsAndFrames) {
+  RoombaSensorCache cache;
+
+  // Group 3 is packets 21-26: charging state, voltage, current, temperature, charge, capacity
+  uint8_t group[10] = { 2, 0x3D, 0xB8, 0xFB, 0x50, 25, 0x0A, 0x28, 0x0B, 0xB8 };
+  CHECK_EQ(RoombaPackets::size(SENSOR_GROUP_21_26), sizeof(group));
+  cache.store(SENSOR_GROUP_21_26, group, 10);
+  CHECK(cache.has(SENSOR_CHARGING_STATE));
+  CHECK(cache.has(SENSOR_BATTERY_CAPACITY));
+  CHECK_EQ(cache.values().get<SENSOR_BATTERY_CHARGE>(), 2600);
+  CHECK_EQ(cache.values().get<SENSOR_TEMPERATURE>(), 25);
+
+  // A stream frame only touches its own packets
+  uint8_t frame[16];
+  uint8_t length = streamFrame(BASIC_PAYLOAD, sizeof(BASIC_PAYLOAD), frame);
+  RoombaStreamParser parser;
+  feedAll(parser, frame, length);
+  RoombaSensorSnapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  parser.decode(snapshot);
+  snapshot.timestamp = 20;
+  cache.store(snapshot);
+
+  CHECK_EQ(cache.getAge(SENSOR_WALL, 20), 0);
+  CHECK_EQ(cache.getAge(SENSOR_BATTERY_CAPACITY, 20), 10);
+  CHECK_EQ(cache.values().get<SENSOR_BATTERY_CHARGE>(), 2600);
+}
+
+TEST(PacketTableSizesAndRanges) {
+  CHECK_EQ(RoombaPackets::size(SENSOR_BUMPS_DROPS), 1);
+  CHECK_EQ(RoombaPackets::size(SENSOR_VOLTAGE), 2);
+  CHECK_EQ(RoombaPackets::size(SENSOR_GROUP_7_26), 26);
+  CHECK_EQ(RoombaPackets::size(SENSOR_GROUP_ALL), 80);
+  CHECK_EQ(RoombaPackets::size(SENSOR_GROUP_43_58), 28);
+  CHECK_EQ(RoombaPackets::size(99), 0);
+
+  uint8_t first, last;
+  CHECK(RoombaPackets::range(SENSOR_GROUP_35_42, first, last));
+  CHECK_EQ(first, 35);
+  CHECK_EQ(last, 42);
+  CHECK(RoombaPackets::range(SENSOR_STASIS, first, last));
+  CHECK_EQ(first, SENSOR_STASIS);
+  CHECK(!RoombaPackets::range(200, first, last));
+
+  OIPacketInfo info;
+  CHECK(RoombaPackets::info(SENSOR_ANGLE, info));
+  CHECK(info.isSigned);
+  CHECK_EQ(OIPacket<SENSOR_LEFT_ENCODER>::size, 2);
+  CHECK(!OIPacket<SENSOR_LEFT_ENCODER>::isSigned);
+}
+
+TEST(PacketTableNames) {
+  char name[28];
+  CHECK_EQ(RoombaPackets::name(SENSOR_VOLTAGE, name, sizeof(name)), 7);
+  CHECK(strcmp(name, "voltage") == 0);
+  CHECK(RoombaPackets::name(SENSOR_LEFT_ENCODER, name, sizeof(name)) > 0);
+  CHECK(strcmp(name, "left_encoder") == 0);
+  CHECK_EQ(RoombaPackets::name(6, name, sizeof(name)), 0);
+
+  CHECK_EQ(RoombaPackets::idForName("voltage", 7), SENSOR_VOLTAGE);
+  CHECK_EQ(RoombaPackets::idForName("bumps_drops", 11), SENSOR_BUMPS_DROPS);
+  CHECK_EQ(RoombaPackets::idForName("volt", 4), 0);
+
+  // Every name maps back to its own id
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    uint8_t length = RoombaPackets::name(id, name, sizeof(name));
+    CHECK(length > 0);
+    CHECK_EQ(RoombaPackets::idForName(name, length), id);
+  }
+}
+
+static RoombaScheduledCommand command(RoombaAction action, uint16_t duration) {
+  RoombaScheduledCommand cmd = { action, 200, 0, duration };
+  return cmd;
+}
+
+TEST(SchedulerRunsTimedCommandsInOrder) {
+  RoombaScheduler scheduler;
+  RoombaScheduledCommand next;
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_IDLE);
+  CHECK(!scheduler.isBusy());
+
+  CHECK(scheduler.push(command(ROOMBA_ACTION_FORWARD, 1000)));
+  CHECK(scheduler.push(command(ROOMBA_ACTION_LEFT, 500)));
+  CHECK(scheduler.isBusy());
+
+  CHECK_EQ(scheduler.poll(100, next), SCHEDULER_START);
+  CHECK_EQ(next.action, ROOMBA_ACTION_FORWARD);
+  CHECK_EQ(scheduler.poll(1099, next), SCHEDULER_IDLE);
+
+  CHECK_EQ(scheduler.poll(1100, next), SCHEDULER_START);
+  CHECK_EQ(next.action, ROOMBA_ACTION_LEFT);
+
+  CHECK_EQ(scheduler.poll(1600, next), SCHEDULER_EXPIRED);
+  CHECK_EQ(scheduler.poll(1601, next), SCHEDULER_IDLE);
+  CHECK(!scheduler.isBusy());
+}
+
+TEST(SchedulerContinuousCommandsDoNotHold) {
+  RoombaScheduler scheduler;
+  RoombaScheduledCommand next;
+  scheduler.push(command(ROOMBA_ACTION_FORWARD, 0));
+  scheduler.push(command(ROOMBA_ACTION_STOP, 0));
+
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_START);
+  CHECK_EQ(next.action, ROOMBA_ACTION_FORWARD);
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_START);
+  CHECK_EQ(next.action, ROOMBA_ACTION_STOP);
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_IDLE);
+}
+
+TEST(SchedulerReplaceTakesOverTimedCommand) {
+  RoombaScheduler scheduler;
+  RoombaScheduledCommand next;
+  scheduler.push(command(ROOMBA_ACTION_FORWARD, 1000));
+  scheduler.push(command(ROOMBA_ACTION_LEFT, 1000));
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_START);
+
+  // Starts at once, with its own deadline; the queued LEFT is gone
+  scheduler.replace(command(ROOMBA_ACTION_BACKWARD, 500));
+  CHECK_EQ(scheduler.poll(10, next), SCHEDULER_START);
+  CHECK_EQ(next.action, ROOMBA_ACTION_BACKWARD);
+  CHECK_EQ(scheduler.poll(509, next), SCHEDULER_IDLE);
+  CHECK_EQ(scheduler.poll(510, next), SCHEDULER_EXPIRED);
+  CHECK(!scheduler.isBusy());
+}
+
+TEST(SchedulerCapacityAndClear) {
+  RoombaScheduler scheduler;
+  for (uint8_t i = 0; i < ROOMBA_QUEUE_SIZE; i++) {
+    CHECK(scheduler.push(command(ROOMBA_ACTION_BEEP, 0)));
+  }
+  CHECK(scheduler.isFull());
+  CHECK(!scheduler.push(command(ROOMBA_ACTION_BEEP, 0)));
+
+  RoombaScheduledCommand next;
+  scheduler.poll(0, next);
+  scheduler.clear();
+  CHECK_EQ(scheduler.size(), 0);
+  CHECK(!scheduler.isBusy());
+  CHECK_EQ(scheduler.poll(0, next), SCHEDULER_IDLE);
+}
+
+TEST(MailboxKeepsOrderAndCountsDrops) {
+  RoombaMailbox<RoombaScheduledCommand, 4> mailbox;
+  CHECK(mailbox.empty());
+  for (int16_t i = 0; i < 3; i++) {
+    CHECK(mailbox.post(command(ROOMBA_ACTION_FORWARD, 100 + i)));
+  }
+  CHECK(!mailbox.post(command(ROOMBA_ACTION_STOP, 0))); // One slot stays free
+  CHECK_EQ(mailbox.dropped(), 1);
+
+  RoombaScheduledCommand next;
+  CHECK(mailbox.take(next));
+  CHECK_EQ(next.duration, 100);
+
+  // Indices wrap without losing records
+  CHECK(mailbox.post(command(ROOMBA_ACTION_STOP, 7)));
+  CHECK(mailbox.take(next));
+  CHECK(mailbox.take(next));
+  CHECK_EQ(next.duration, 102);
+  CHECK(mailbox.take(next));
+  CHECK_EQ(next.action, ROOMBA_ACTION_STOP);
+  CHECK(!mailbox.take(next));
+  CHECK(mailbox.empty());
+}
+
+TEST(OdometryStraightLine) {
+  RoombaOdometry odometry;
+  CHECK(!odometry.update(1000, 1000)); // Seeds only
+  CHECK(odometry.update(3000, 3000));
+
+  // 2000 counts at 444.57 um
+  const RoombaPose& pose = odometry.getPose();
+  CHECK(pose.x > 889000 && pose.x < 890300);
+  CHECK_EQ(pose.y, 0);
+  CHECK_EQ(pose.heading, 0);
+}
+
+TEST(OdometryTurnInPlace) {
+  RoombaOdometry odometry;
+  odometry.update(0, 0);
+  // pi/2 * 235 mm / 0.44457 mm per count = 830 counts of wheel difference
+  odometry.update((uint16_t)-415, 415);
+
+  const RoombaPose& pose = odometry.getPose();
+  CHECK(pose.headingDegrees() > 89.5f && pose.headingDegrees() < 90.5f);
+  CHECK(pose.x > -50 && pose.x < 50);
+}
+
+TEST(OdometryWrapsAndReseeds) {
+  RoombaOdometry odometry;
+  odometry.update(65000, 65000);
+  CHECK(odometry.update(500, 500)); // 1036 counts across the 16-bit wrap
+  CHECK(odometry.getPose().x > 460000 && odometry.getPose().x < 461000);
+
+  // A jump past ODOMETRY_MAX_STEP re-seeds instead of moving
+  int32_t x = odometry.getPose().x;
+  CHECK(!odometry.update(20000, 20000));
+  CHECK_EQ(odometry.getResyncCount(), 1);
+  CHECK_EQ(odometry.getPose().x, x);
+  CHECK(odometry.update(20100, 20100));
+  CHECK(odometry.getPose().x > x);
+}
+
+TEST(OdometrySine) {
+  CHECK_EQ(RoombaOdometry::sin(0), 0);
+  CHECK(RoombaOdometry::sin(ODOMETRY_ANGLE_HALF_TURN >> 1) > 32700);
+  CHECK(RoombaOdometry::sin(ODOMETRY_ANGLE_HALF_TURN + (ODOMETRY_ANGLE_HALF_TURN >> 1)) < -32700);
+  CHECK(RoombaOdometry::cos(0) > 32700);
+}
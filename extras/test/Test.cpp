@@ -0,0 +1,75 @@
+/**
+ * @file Test.cpp
+ * @brief Runner and main() for the host unit tests
+ *
+ * Usage: arduroomba_tests [--filter=substring]
+ */
+
+#include "Test.h"
+
+#include <Arduino.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_MAX 128
+
+struct TestEntry {
+  const char* name;
+  TestFunction function;
+};
+
+static TestEntry tests[TEST_MAX];
+static int testCount = 0;
+static bool currentFailed = false;
+
+int testRegister(const char* name, TestFunction function) {
+  if (testCount < TEST_MAX) {
+    tests[testCount].name = name;
+    tests[testCount].function = function;
+    testCount++;
+  }
+  return testCount;
+}
+
+void testFail(const char* file, int line, const char* expression) {
+  printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+  currentFailed = true;
+}
+
+void testFailEqual(const char* file, int line, const char* actual, const char* expected,
+                   long long actualValue, long long expectedValue) {
+  printf("  %s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n",
+         file, line, actual, expected, actualValue, expectedValue);
+  currentFailed = true;
+}
+
+int main(int argc, char** argv) {
+  const char* filter = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else {
+      fprintf(stderr, "usage: %s [--filter=substring]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int run = 0;
+  int failed = 0;
+  for (int i = 0; i < testCount; i++) {
+    if (filter && !strstr(tests[i].name, filter)) continue;
+
+    HostClock::reset();
+    HostPins::reset();
+    currentFailed = false;
+    tests[i].function();
+
+    printf("%-4s %s\n", currentFailed ? "FAIL" : "ok", tests[i].name);
+    run++;
+    if (currentFailed) failed++;
+  }
+
+  printf("\n%d tests, %d failed\n", run, failed);
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file Test.h
+ * @brief Minimal assertion harness for the host unit tests
+ *
+ *   TEST(StreamParserResync) {
+ *     RoombaStreamParser parser;
+ *     CHECK(parser.feed(...));
+ *     CHECK_EQ(parser.getStats().resyncs, 1);
+ *   }
+ *
+ * A failed check reports its file, line and expression and ends that test;
+ * the runner goes on with the next one and exits non-zero if any failed.
+ * The virtual clock and pins are reset before every test.
+ */
+
+#ifndef ARDUROOMBA_TEST_H
+#define ARDUROOMBA_TEST_H
+
+#include <stdint.h>
+
+typedef void (*TestFunction)();
+
+int testRegister(const char* name, TestFunction function);
+void testFail(const char* file, int line, const char* expression);
+void testFailEqual(const char* file, int line, const char* actual, const char* expected,
+                   long long actualValue, long long expectedValue);
+
+#define TEST(name)                                                       \
+  static void name();                                                    \
+  static int name##_registered = testRegister(#name, name);             \
+  static void name()
+
+#define CHECK(expression)                                                \
+  do {                                                                   \
+    if (!(expression)) {                                                 \
+      testFail(__FILE__, __LINE__, #expression);                         \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                       \
+  do {                                                                   \
+    long long testActual = (long long)(actual);                          \
+    long long testExpected = (long long)(expected);                      \
+    if (testActual != testExpected) {                                    \
+      testFailEqual(__FILE__, __LINE__, #actual, #expected, testActual, testExpected); \
+      return;                                                            \
+    }                                                                    \
+  } while (0)
+
+#endif
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Regenerate src/extensions/ArduRoombaControlPage.h from control.html.
+
+The page is gzip-compressed (deterministically: fixed mtime, max level) and
+emitted as a PROGMEM byte array, so the firmware never holds the page in RAM.
+Run after editing control.html:
+
+    python3 extras/web/build_page.py
+"""
+
+import gzip
+import os
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.join(HERE, "control.html")
+TARGET = os.path.join(HERE, "..", "..", "src", "extensions", "ArduRoombaControlPage.h")
+
+
+def main():
+    with open(SOURCE, "rb") as f:
+        html = f.read()
+
+    data = gzip.compress(html, compresslevel=9, mtime=0)
+
+    lines = []
+    for i in range(0, len(data), 16):
+        chunk = ", ".join("0x%02x" % b for b in data[i:i + 16])
+        lines.append("  " + chunk + ",")
+
+    header = """/**
+ * @file ArduRoombaControlPage.h
+ * @brief Gzip-compressed control page (generated - do not edit)
+ *
+ * Generated by extras/web/build_page.py from extras/web/control.html
+ * (%d bytes, %d compressed).
+ */
+
+#ifndef ARDUROOMBA_CONTROL_PAGE_H
+#define ARDUROOMBA_CONTROL_PAGE_H
+
+#include <Arduino.h>
+
+#define ARDUROOMBA_CONTROL_PAGE_LENGTH %d
+
+static const uint8_t ARDUROOMBA_CONTROL_PAGE_GZ[ARDUROOMBA_CONTROL_PAGE_LENGTH] PROGMEM = {
+%s
+};
+
+#endif
+""" % (len(html), len(data), len(data), "\n".join(lines))
+
+    with open(TARGET, "w") as f:
+        f.write(header)
+    print("%s: %d -> %d bytes" % (os.path.relpath(TARGET), len(html), len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -4,26 +4,60 @@
  */
 
 #include "ArduRoomba.h"
+#include "RoombaMetrics.h"
+
+// Packets streamed by default: everything the basic sensor getters read
+#define DEFAULT_STREAM_MASK (PACKET_BIT(SENSOR_BUMPS_DROPS) | PACKET_BIT(SENSOR_WALL) | \
+                             PACKET_BIT(SENSOR_VOLTAGE) | PACKET_BIT(SENSOR_CURRENT))
 
 ArduRoomba::ArduRoomba(uint8_t rxPin, uint8_t txPin, uint8_t brcPin)
-  : _oi(rxPin, txPin, brcPin), _debug(false) {
+  : _oi(rxPin, txPin, brcPin), _debug(false), _streamMask(DEFAULT_STREAM_MASK), _streamWanted(true) {
+}
+
+ArduRoomba::ArduRoomba(Stream& port, uint8_t brcPin)
+  : _oi(port, brcPin), _debug(false), _streamMask(DEFAULT_STREAM_MASK), _streamWanted(true) {
+}
+
+ArduRoomba::ArduRoomba(RoombaTransport& transport, uint8_t brcPin)
+  : _oi(transport, brcPin), _debug(false), _streamMask(DEFAULT_STREAM_MASK), _streamWanted(true) {
 }
 
 bool ArduRoomba::begin(uint32_t baudRate) {
   debugPrint("Starting ArduRoomba...");
+  _oi.setDebug(_debug);
+  _odometry.reset();
   
   if (_oi.begin(baudRate)) {
-    _oi.setDebug(_debug);
-    debugPrint("ArduRoomba ready");
+    linkUp();
     return true;
   }
   
+  // tick() keeps trying and finishes the setup once the robot answers
   debugPrint("ArduRoomba failed to start");
   return false;
 }
 
+void ArduRoomba::beginAsync(uint32_t baudRate) {
+  debugPrint("Starting ArduRoomba...");
+  _oi.setDebug(_debug);
+  _odometry.reset();
+  _oi.beginAsync(baudRate);
+}
+
+// Fresh state on every (re)connection, as the robot has none left either;
+// the pose is dealt with when the link is lost
+void ArduRoomba::linkUp() {
+  _cache.clear();
+  _motion.reset();
+  if (_streamWanted) startSensorStream(); // Stays off if the sketch stopped it
+  debugPrint("ArduRoomba ready");
+}
+
 void ArduRoomba::end() {
+  _scheduler.clear();
+  _motion.reset();
   _oi.end();
+  _cache.clear();
   debugPrint("ArduRoomba stopped");
 }
 
@@ -31,72 +65,308 @@ bool ArduRoomba::isConnected() const {
   return _oi.isConnected();
 }
 
+bool ArduRoomba::negotiateBaud(uint32_t baudRate) {
+  // Replies to the link check must not interleave with stream frames
+  bool streaming = _oi.isStreaming();
+  if (streaming) _oi.stopSensorStream();
+  
+  bool ok = _oi.negotiateBaud(baudRate);
+  debugPrint(ok ? "Baud rate negotiated" : "Baud rate unchanged", (int)(_oi.getBaudRate() / 100));
+  
+  if (streaming) startSensorStream();
+  return ok;
+}
+
 // Simple movement commands
 void ArduRoomba::moveForward(int16_t speed) {
   debugPrint("Moving forward", speed);
-  _oi.drive(speed, DRIVE_STRAIGHT);
+  drive(speed, DRIVE_STRAIGHT);
 }
 
 void ArduRoomba::moveBackward(int16_t speed) {
   debugPrint("Moving backward", speed);
-  _oi.drive(-speed, DRIVE_STRAIGHT);
+  drive(-speed, DRIVE_STRAIGHT);
 }
 
 void ArduRoomba::turnLeft(int16_t speed) {
   debugPrint("Turning left", speed);
-  _oi.drive(speed, DRIVE_TURN_CCW);
+  drive(speed, DRIVE_TURN_CCW);
 }
 
 void ArduRoomba::turnRight(int16_t speed) {
   debugPrint("Turning right", speed);
-  _oi.drive(speed, DRIVE_TURN_CW);
+  drive(speed, DRIVE_TURN_CW);
 }
 
 void ArduRoomba::stop() {
   debugPrint("Stopping");
-  _oi.stop();
+  drive(0, 0);
 }
 
 // Advanced movement
 void ArduRoomba::drive(int16_t velocity, int16_t radius) {
+  if (_motion.isEnabled()) {
+    int16_t rightVel, leftVel;
+    RoombaMotionProfile::wheelSpeeds(velocity, radius, rightVel, leftVel);
+    _motion.setTarget(rightVel, leftVel);
+    return;
+  }
   _oi.drive(velocity, radius);
 }
 
 void ArduRoomba::driveDirect(int16_t rightVel, int16_t leftVel) {
+  if (_motion.isEnabled()) {
+    _motion.setTarget(rightVel, leftVel);
+    return;
+  }
   _oi.driveDirect(rightVel, leftVel);
 }
 
+void ArduRoomba::setMotionLimits(uint16_t accel, uint16_t jerk) {
+  // Profiling assumes it knows the current speed; start from a stop
+  if (!_motion.isEnabled()) _motion.reset();
+  _motion.setLimits(accel, jerk);
+}
+
+// Command queue
+bool ArduRoomba::queueCommand(RoombaAction action, int16_t arg0, int16_t arg1, uint16_t duration) {
+  if (action == ROOMBA_ACTION_STOP) {
+    // Stop never waits behind queued or timed commands
+    clearQueue();
+    return true;
+  }
+  
+  // A remote streaming timed drives (a deadman) must not lag behind its own
+  // earlier frames, so the newest motion takes over at once
+  if (RoombaScheduler::isMotion(action)) {
+    RoombaScheduledCommand cmd = {action, arg0, arg1, duration};
+    _scheduler.replace(cmd);
+    serviceQueue();
+    return true;
+  }
+  return appendCommand(action, arg0, arg1, duration);
+}
+
+bool ArduRoomba::appendCommand(RoombaAction action, int16_t arg0, int16_t arg1, uint16_t duration) {
+  RoombaScheduledCommand cmd = {action, arg0, arg1, duration};
+  if (!_scheduler.push(cmd)) {
+    debugPrint("Command queue full");
+    return false;
+  }
+  
+  // Start immediately if nothing is running
+  serviceQueue();
+  return true;
+}
+
+void ArduRoomba::clearQueue() {
+  _scheduler.clear();
+  stop();
+}
+
+void ArduRoomba::serviceQueue() {
+  RoombaScheduledCommand cmd;
+  RoombaSchedulerEvent event;
+  
+  while ((event = _scheduler.poll(millis(), cmd)) == SCHEDULER_START) {
+    execute(cmd);
+    if (cmd.duration > 0) return; // Wait for its deadline
+  }
+  
+  if (event == SCHEDULER_EXPIRED) {
+    stop();
+  }
+}
+
+void ArduRoomba::execute(const RoombaScheduledCommand& cmd) {
+  switch (cmd.action) {
+    case ROOMBA_ACTION_FORWARD:      moveForward(cmd.arg0); break;
+    case ROOMBA_ACTION_BACKWARD:     moveBackward(cmd.arg0); break;
+    case ROOMBA_ACTION_LEFT:         turnLeft(cmd.arg0); break;
+    case ROOMBA_ACTION_RIGHT:        turnRight(cmd.arg0); break;
+    case ROOMBA_ACTION_STOP:         stop(); break;
+    case ROOMBA_ACTION_CLEAN:        startCleaning(); break;
+    case ROOMBA_ACTION_SPOT:         spotClean(); break;
+    case ROOMBA_ACTION_DOCK:         dock(); break;
+    case ROOMBA_ACTION_BEEP:         beep(); break;
+    case ROOMBA_ACTION_DRIVE:        drive(cmd.arg0, cmd.arg1); break;
+    case ROOMBA_ACTION_DRIVE_DIRECT: driveDirect(cmd.arg0, cmd.arg1); break;
+    default: break;
+  }
+}
+
 // Cleaning modes
 void ArduRoomba::startCleaning() {
   debugPrint("Starting cleaning mode");
+  _motion.reset(); // The robot drives itself from here
   _oi.clean();
 }
 
 void ArduRoomba::spotClean() {
   debugPrint("Starting spot cleaning");
+  _motion.reset();
   _oi.spot();
 }
 
 void ArduRoomba::dock() {
   debugPrint("Seeking dock");
+  _motion.reset();
   _oi.seekDock();
 }
 
 // Basic sensors
-uint16_t ArduRoomba::getBatteryVoltage() {
-  return _oi.getBatteryVoltage();
+uint16_t ArduRoomba::getBatteryVoltage(uint16_t maxAge) {
+  return refreshSensor(SENSOR_VOLTAGE, maxAge) ? _cache.values().get<SENSOR_VOLTAGE>() : 0;
+}
+
+int16_t ArduRoomba::getBatteryCurrent(uint16_t maxAge) {
+  return refreshSensor(SENSOR_CURRENT, maxAge) ? _cache.values().get<SENSOR_CURRENT>() : 0;
 }
 
-int16_t ArduRoomba::getBatteryCurrent() {
-  return _oi.getBatteryCurrent();
+bool ArduRoomba::isWallDetected(uint16_t maxAge) {
+  return refreshSensor(SENSOR_WALL, maxAge) && _cache.values().get<SENSOR_WALL>() != 0;
 }
 
-bool ArduRoomba::isWallDetected() {
-  return _oi.isWallDetected();
+bool ArduRoomba::isBumperPressed(uint16_t maxAge) {
+  // Check bump bits
+  return refreshSensor(SENSOR_BUMPS_DROPS, maxAge) && (_cache.values().get<SENSOR_BUMPS_DROPS>() & 0x03) != 0;
 }
 
-bool ArduRoomba::isBumperPressed() {
-  return _oi.isBumperPressed();
+// Control loop: link, sensor stream, command queue, motion profile, TX flush
+void ArduRoomba::tick() {
+  ROOMBA_TRACE(METRIC_TICK);
+  
+  switch (_oi.serviceLink()) {
+    case OI_LINK_EVENT_CONNECTED:
+      linkUp();
+      break;
+    case OI_LINK_EVENT_LOST: {
+      // The robot stopped when it slept; don't resume a ramp on wake
+      _motion.reset();
+      
+      // A sleeping robot goes silent. Runs of bad frames or timeouts are a
+      // noisy link: the robot kept its place and its encoder counts, so the
+      // pose carries on (a jump in the counts re-seeds in the odometry)
+      RoombaLinkLoss loss = _oi.getLinkHealth().lastLoss;
+      if (loss == LINK_LOSS_SILENCE || loss == LINK_LOSS_PROBE) _odometry.reset();
+      debugPrint("Link lost, reconnecting");
+      break;
+    }
+    default:
+      break;
+  }
+  
+  receiveFrame();
+  serviceQueue();
+  
+  if (_motion.update(millis())) {
+    _oi.driveDirect(_motion.right(), _motion.left());
+  }
+  
+  // One TX burst per control tick when batching
+  _oi.flushTx();
+}
+
+bool ArduRoomba::startSensorStream() {
+  _streamWanted = true;
+  uint8_t packets[OI_PACKET_COUNT];
+  uint8_t count = 0;
+  
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    if (_streamMask & PACKET_BIT(id)) {
+      packets[count++] = id;
+    }
+  }
+  
+  if (!_oi.startSensorStream(packets, count)) return false;
+  debugPrint("Sensor stream packets", count);
+  return true;
+}
+
+void ArduRoomba::enableOdometry(bool enable) {
+  const uint64_t encoders = PACKET_BIT(SENSOR_LEFT_ENCODER) | PACKET_BIT(SENSOR_RIGHT_ENCODER);
+  uint64_t wanted = enable ? (_streamMask | encoders) : (_streamMask & ~encoders);
+  if (wanted == _streamMask) return;
+  
+  _streamMask = wanted;
+  if (enable) _odometry.reset();
+  if (_oi.isStreaming()) startSensorStream();
+}
+
+void ArduRoomba::stopSensorStream() {
+  _streamWanted = false;
+  _oi.stopSensorStream();
+}
+
+bool ArduRoomba::refreshSensors(const uint8_t* packetIds, uint8_t numPackets) {
+  if (!packetIds || numPackets == 0) return false;
+  
+  if (_oi.isStreaming()) {
+    uint64_t wanted = _streamMask;
+    for (uint8_t i = 0; i < numPackets; i++) {
+      uint8_t first, last;
+      if (RoombaPackets::range(packetIds[i], first, last)) {
+        for (uint8_t id = first; id <= last; id++) wanted |= PACKET_BIT(id);
+      }
+    }
+    if (wanted != _streamMask) {
+      // Keep the running subscription if the wider one is refused (too large)
+      uint64_t previous = _streamMask;
+      _streamMask = wanted;
+      if (!startSensorStream()) {
+        _streamMask = previous;
+        return false;
+      }
+    }
+    receiveFrame();
+    return true;
+  }
+  
+  // One OI_QUERY_LIST round trip for all requested packets
+  RoombaSensorSnapshot snapshot;
+  if (!_oi.queryList(packetIds, numPackets, snapshot)) return false;
+  _cache.store(snapshot);
+  return true;
+}
+
+// Takes in a waiting stream frame only; the queue, motion profile and link
+// are left to tick() so a sensor read never sends commands
+bool ArduRoomba::receiveFrame() {
+  if (!_oi.pollStream()) return false;
+  
+  const RoombaSensorSnapshot& frame = _oi.getStreamSnapshot();
+  _cache.store(frame);
+  if (frame.has(SENSOR_LEFT_ENCODER) && frame.has(SENSOR_RIGHT_ENCODER)) {
+    _odometry.update(frame.get<SENSOR_LEFT_ENCODER>(), frame.get<SENSOR_RIGHT_ENCODER>());
+  }
+  return true;
+}
+
+bool ArduRoomba::refreshSensor(uint8_t packetId, uint16_t maxAge) {
+  if (_oi.isStreaming()) {
+    // Never poll while streaming; the response would interleave with frames
+    receiveFrame();
+    
+    if (!(_streamMask & PACKET_BIT(packetId))) {
+      uint64_t previous = _streamMask;
+      _streamMask |= PACKET_BIT(packetId);
+      if (!startSensorStream()) {
+        _streamMask = previous;
+        return false;
+      }
+    }
+    // A stalled stream must not serve old values as current
+    return _cache.isFresh(packetId, maxAge, millis());
+  }
+  
+  if (_cache.isFresh(packetId, maxAge, millis())) return true;
+  
+  uint8_t data[2];
+  if (!_oi.getSensor(packetId, data, RoombaPackets::size(packetId))) {
+    return false;
+  }
+  _cache.store(packetId, data, millis());
+  return true;
 }
 
 // Actuators
@@ -132,6 +402,7 @@ void ArduRoomba::playTone(uint8_t note, uint8_t duration) {
   
   // Define song
   _oi.sendCommand(OI_SONG, songData, 4);
+  _oi.flushTx();
   delay(20);
   
   // Play song
@@ -10,16 +10,40 @@
 #define ARDUROOMBA_H
 
 #include "RoombaOI.h"
+#include "RoombaSensorCache.h"
+#include "RoombaScheduler.h"
+#include "RoombaOdometry.h"
+#include "RoombaMotionProfile.h"
+
+// Default max age (ms) of a cached sensor value before it is re-polled
+#ifndef SENSOR_MAX_AGE_DEFAULT
+#define SENSOR_MAX_AGE_DEFAULT 100
+#endif
 
 class ArduRoomba {
 public:
   // Constructor
   ArduRoomba(uint8_t rxPin, uint8_t txPin, uint8_t brcPin);
+  ArduRoomba(Stream& port, uint8_t brcPin); // Caller opens the port
+  ArduRoomba(RoombaTransport& transport, uint8_t brcPin); // begin() opens it
   
-  // Basic lifecycle
+  // Basic lifecycle. begin() blocks until the robot answers (or times out);
+  // beginAsync() returns at once and tick() connects, then reconnects
+  // whenever the robot goes to sleep
   bool begin(uint32_t baudRate = 19200);
+  void beginAsync(uint32_t baudRate = 19200);
   void end();
   bool isConnected() const;
+  RoombaLinkState getLinkState() const { return _oi.getLinkState(); }
+  
+  // Link health for diagnostics (also in /status and over BLE)
+  const RoombaLinkHealth& getLinkHealth() const { return _oi.getLinkHealth(); }
+  const RoombaStreamStats& getStreamStats() const { return _oi.getStreamStats(); }
+  unsigned long getTimeSinceValid() const { return _oi.getTimeSinceValid(); }
+  void resetLinkHealth() { _oi.resetLinkHealth(); }
+  
+  // Move to a faster link (e.g. 115200) after begin(); falls back if unverified
+  bool negotiateBaud(uint32_t baudRate);
   
   // Simple movement commands
   void moveForward(int16_t speed = 200);
@@ -32,16 +56,52 @@ public:
   void drive(int16_t velocity, int16_t radius);
   void driveDirect(int16_t rightVel, int16_t leftVel);
   
+  // Motion profile: with limits set, movement commands only set wheel speed
+  // targets and tick() ramps towards them (accel mm/s^2, jerk mm/s^3; 0 = off)
+  void setMotionLimits(uint16_t accel, uint16_t jerk = 0);
+  bool isRamping() const { return _motion.isRamping(); }
+  const RoombaMotionProfile& getMotionProfile() const { return _motion; }
+  
+  // Command queue (advanced by tick(); ROOMBA_ACTION_STOP preempts it).
+  // queueCommand() starts a motion at once, replacing any running or queued
+  // one (the latest remote drive wins); other actions wait their turn.
+  // appendCommand() always waits, for scripted sequences
+  bool queueCommand(RoombaAction action, int16_t arg0 = 0, int16_t arg1 = 0, uint16_t duration = 0);
+  bool appendCommand(RoombaAction action, int16_t arg0 = 0, int16_t arg1 = 0, uint16_t duration = 0);
+  void clearQueue();
+  bool isBusy() const { return _scheduler.isBusy(); }
+  
   // Cleaning modes
   void startCleaning();
   void spotClean();
   void dock();
   
-  // Basic sensors
-  uint16_t getBatteryVoltage();
-  int16_t getBatteryCurrent();
-  bool isWallDetected();
-  bool isBumperPressed();
+  // Basic sensors (served from the sensor cache, maxAge in ms)
+  uint16_t getBatteryVoltage(uint16_t maxAge = SENSOR_MAX_AGE_DEFAULT);
+  int16_t getBatteryCurrent(uint16_t maxAge = SENSOR_MAX_AGE_DEFAULT);
+  bool isWallDetected(uint16_t maxAge = SENSOR_MAX_AGE_DEFAULT);
+  bool isBumperPressed(uint16_t maxAge = SENSOR_MAX_AGE_DEFAULT);
+  
+  // Sensor streaming (started by begin(); call tick() from loop())
+  void tick();
+  bool startSensorStream();
+  void stopSensorStream();
+  bool isStreaming() const { return _oi.isStreaming(); }
+  bool refreshSensors(const uint8_t* packetIds, uint8_t numPackets);
+  
+  // Any single sensor packet, typed at compile time: get<SENSOR_ANGLE>()
+  template <uint8_t Id>
+  typename OIPacket<Id>::type get(uint16_t maxAge = SENSOR_MAX_AGE_DEFAULT) {
+    refreshSensor(Id, maxAge);
+    return _cache.values().get<Id>();
+  }
+  const RoombaSensorCache& getSensorCache() const { return _cache; }
+  
+  // Odometry from the encoder counts in the stream (no extra queries)
+  void enableOdometry(bool enable = true); // Subscribes packets 43/44
+  const RoombaPose& getPose() const { return _odometry.getPose(); }
+  void resetPose() { _odometry.reset(); }
+  RoombaOdometry& getOdometry() { return _odometry; }
   
   // Actuators
   void setBrushes(bool main, bool side, bool vacuum = false);
@@ -54,6 +114,7 @@ public:
   
   // Utility
   void setDebug(bool enable);
+  void setTxBatching(bool enable) { _oi.setTxBatching(enable); } // Flushed once per tick()
   
   // Access to underlying OI layer for advanced use
   RoombaOI& getOI() { return _oi; }
@@ -62,6 +123,19 @@ private:
   RoombaOI _oi;
   bool _debug;
   
+  RoombaSensorCache _cache;
+  RoombaScheduler _scheduler;
+  RoombaOdometry _odometry;
+  RoombaMotionProfile _motion;
+  uint64_t _streamMask; // Subscribed packets, bit (id - OI_PACKET_FIRST)
+  bool _streamWanted;   // Resubscribe on reconnect (cleared by stopSensorStream())
+  
+  bool receiveFrame();
+  bool refreshSensor(uint8_t packetId, uint16_t maxAge);
+  void linkUp();
+  void serviceQueue();
+  void execute(const RoombaScheduledCommand& cmd);
+  
   void debugPrint(const char* msg);
   void debugPrint(const char* msg, int value);
 };
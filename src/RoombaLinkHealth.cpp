@@ -0,0 +1,53 @@
+/**
+ * @file RoombaLinkHealth.cpp
+ * @brief Implementation of the OI link counters
+ */
+
+#include "RoombaLinkHealth.h"
+
+void RoombaLinkHealth::reset() {
+  replies = 0;
+  timeouts = 0;
+  consecutiveTimeouts = 0;
+  latencyMin = 0;
+  latencyMax = 0;
+  latencySum = 0;
+  memset(latencyHistogram, 0, sizeof(latencyHistogram));
+  connects = 0;
+  wakes = 0;
+  losses = 0;
+  lastLoss = LINK_LOSS_NONE;
+}
+
+void RoombaLinkHealth::recordReply(uint32_t micros) {
+  if (replies == 0 || micros < latencyMin) latencyMin = micros;
+  if (micros > latencyMax) latencyMax = micros;
+  latencySum = (latencySum > 0xFFFFFFFFu - micros) ? 0xFFFFFFFFu : latencySum + micros;
+  replies++;
+  consecutiveTimeouts = 0;
+
+  uint8_t bucket = 0;
+  for (uint32_t ms = micros / 1000; ms > 0 && bucket < LINK_LATENCY_BUCKETS - 1; ms >>= 1) bucket++;
+  if (latencyHistogram[bucket] < 0xFFFF) latencyHistogram[bucket]++;
+}
+
+void RoombaLinkHealth::recordTimeout() {
+  timeouts++;
+  if (consecutiveTimeouts < 0xFFFF) consecutiveTimeouts++;
+}
+
+void RoombaLinkHealth::recordLoss(RoombaLinkLoss reason) {
+  losses++;
+  lastLoss = reason;
+  consecutiveTimeouts = 0;
+}
+
+const char* RoombaLinkHealth::lossName(RoombaLinkLoss reason) {
+  switch (reason) {
+    case LINK_LOSS_SILENCE:  return "silence";
+    case LINK_LOSS_PROBE:    return "probe";
+    case LINK_LOSS_TIMEOUTS: return "timeouts";
+    case LINK_LOSS_CHECKSUM: return "checksum";
+    default:                 return "none";
+  }
+}
@@ -0,0 +1,57 @@
+/**
+ * @file RoombaLinkHealth.h
+ * @brief Counters describing how well the OI serial link is doing
+ *
+ * RoombaOI records every query round trip, timeout, wake and lost link here.
+ * Together with the stream parser's frame counters and the time since the
+ * last valid reply, they tell a flaky cable (checksum errors, resyncs, slow
+ * or missing replies between good ones) from a robot that went to sleep
+ * (a clean link that suddenly goes silent and needs waking).
+ *
+ * Latencies run from the request being written to the last reply byte and
+ * are binned by powers of two: bucket i holds replies under 2^i ms, the last
+ * one everything from 2^(LINK_LATENCY_BUCKETS - 2) ms up.
+ */
+
+#ifndef ROOMBA_LINK_HEALTH_H
+#define ROOMBA_LINK_HEALTH_H
+
+#include <Arduino.h>
+
+#define LINK_LATENCY_BUCKETS 8  // <1, <2, <4, <8, <16, <32, <64, >=64 ms
+
+// Why the link was last declared lost
+enum RoombaLinkLoss : uint8_t {
+  LINK_LOSS_NONE,
+  LINK_LOSS_SILENCE,   // No stream frame for OI_LINK_TIMEOUT_MS
+  LINK_LOSS_PROBE,     // Idle mode probes went unanswered
+  LINK_LOSS_TIMEOUTS,  // OI_HEALTH_TIMEOUT_LIMIT query timeouts in a row
+  LINK_LOSS_CHECKSUM   // OI_HEALTH_BAD_FRAME_LIMIT bad stream frames in a row
+};
+
+struct RoombaLinkHealth {
+  uint32_t replies;             // Query replies received in full
+  uint32_t timeouts;            // Queries and probes that went unanswered
+  uint16_t consecutiveTimeouts;
+  uint32_t latencyMin;          // us
+  uint32_t latencyMax;          // us
+  uint32_t latencySum;          // us, saturating
+  uint16_t latencyHistogram[LINK_LATENCY_BUCKETS];
+  uint16_t connects;            // Successful handshakes
+  uint16_t wakes;               // BRC wake sequences sent
+  uint16_t losses;              // Times the link was declared lost
+  RoombaLinkLoss lastLoss;
+
+  RoombaLinkHealth() { reset(); }
+
+  void reset();
+  void recordReply(uint32_t micros);
+  void recordTimeout();
+  void recordLoss(RoombaLinkLoss reason);
+
+  uint32_t latencyMean() const { return replies ? latencySum / replies : 0; }
+
+  static const char* lossName(RoombaLinkLoss reason);
+};
+
+#endif
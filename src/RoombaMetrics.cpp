@@ -0,0 +1,276 @@
+/**
+ * @file RoombaMetrics.cpp
+ * @brief Trace point clock, table and exporters
+ */
+
+#include "RoombaMetrics.h"
+
+#if defined(ARDUROOMBA_HOST)
+  #include <chrono>
+#endif
+
+// One output line, sent with a single write()
+class MetricLine {
+public:
+  MetricLine() : _length(0) {}
+
+  void put(char c) {
+    if (_length < sizeof(_text)) _text[_length++] = c;
+  }
+
+  void put(const char* text) {
+    while (*text) put(*text++);
+  }
+
+  void number(uint64_t value, uint8_t width = 0) {
+    char digits[20];
+    uint8_t n = 0;
+    do {
+      digits[n++] = '0' + value % 10;
+      value /= 10;
+    } while (value > 0);
+    while (width > n) {
+      put(' ');
+      width--;
+    }
+    while (n > 0) put(digits[--n]);
+  }
+
+  // value / 10^decimals with all decimals shown, right-aligned in width
+  void fixed(uint64_t value, uint8_t decimals, uint8_t width = 0) {
+    uint64_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+    number(value / scale, width > decimals + 1 ? width - decimals - 1 : 0);
+    put('.');
+
+    uint64_t fraction = value % scale;
+    for (uint64_t place = scale / 10; place > 0; place /= 10) {
+      put('0' + (fraction / place) % 10);
+    }
+  }
+
+  void pad(uint8_t column) {
+    while (_length < column) put(' ');
+  }
+
+  size_t send(Print& out) {
+    put('\n');
+    size_t written = out.write((const uint8_t*)_text, _length);
+    _length = 0;
+    return written;
+  }
+
+private:
+  char _text[96];
+  uint8_t _length;
+};
+
+#ifdef ARDUROOMBA_METRICS
+
+static RoombaMetric metricTable[METRIC_COUNT];
+
+#if !defined(ARDUROOMBA_HOST) && !defined(ESP32) && (defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__))
+// Cortex-M3/M4/M7 (e.g. the Uno R4): the DWT cycle counter, started before setup()
+#define DWT_CYCCNT (*(volatile uint32_t*)0xE0001004)
+#define DWT_CTRL   (*(volatile uint32_t*)0xE0001000)
+#define SCB_DEMCR  (*(volatile uint32_t*)0xE000EDFC)
+
+static struct CycleCounterStart {
+  CycleCounterStart() {
+    SCB_DEMCR |= 1UL << 24; // TRCENA
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= 1UL;        // CYCCNTENA
+  }
+} cycleCounterStart;
+#define METRICS_DWT
+#endif
+
+bool RoombaMetrics::enabled() {
+  return true;
+}
+
+uint32_t RoombaMetrics::now() {
+#if defined(ARDUROOMBA_HOST)
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+#elif defined(ESP32)
+  return ESP.getCycleCount();
+#elif defined(METRICS_DWT)
+  return DWT_CYCCNT;
+#else
+  return micros();
+#endif
+}
+
+uint32_t RoombaMetrics::ticksPerMicrosecond() {
+#if defined(ARDUROOMBA_HOST)
+  return 1000;
+#elif defined(ESP32)
+  return ESP.getCpuFreqMHz();
+#elif defined(METRICS_DWT) && defined(F_CPU)
+  return F_CPU / 1000000;
+#elif defined(METRICS_DWT)
+  return 48; // Uno R4 core clock
+#else
+  return 1;
+#endif
+}
+
+void RoombaMetrics::record(RoombaMetricId id, uint32_t ticks) {
+  if (id >= METRIC_COUNT) return;
+
+  RoombaMetric& metric = metricTable[id];
+  if (metric.count == 0 || ticks < metric.min) metric.min = ticks;
+  if (ticks > metric.max) metric.max = ticks;
+  metric.total += ticks;
+  metric.count++;
+}
+
+void RoombaMetrics::reset() {
+  memset(metricTable, 0, sizeof(metricTable));
+}
+
+void RoombaMetrics::snapshot(RoombaMetric* table) {
+  memcpy(table, metricTable, sizeof(metricTable));
+}
+
+#else
+
+bool RoombaMetrics::enabled() { return false; }
+uint32_t RoombaMetrics::now() { return 0; }
+uint32_t RoombaMetrics::ticksPerMicrosecond() { return 1; }
+void RoombaMetrics::record(RoombaMetricId, uint32_t) {}
+void RoombaMetrics::reset() {}
+
+void RoombaMetrics::snapshot(RoombaMetric* table) {
+  memset(table, 0, sizeof(RoombaMetric) * METRIC_COUNT);
+}
+
+#endif
+
+const char* RoombaMetrics::name(RoombaMetricId id) {
+  switch (id) {
+    case METRIC_TICK:         return "tick";
+    case METRIC_OI_SEND:      return "oi_send";
+    case METRIC_OI_FLUSH:     return "oi_flush";
+    case METRIC_OI_POLL:      return "oi_poll";
+    case METRIC_OI_DECODE:    return "oi_decode";
+    case METRIC_OI_QUERY:     return "oi_query";
+    case METRIC_HTTP_PARSE:   return "http_parse";
+    case METRIC_HTTP_STATUS:  return "http_status";
+    case METRIC_HTTP_COMMAND: return "http_command";
+    case METRIC_HTTP_PAGE:    return "http_page";
+    case METRIC_HTTP_METRICS: return "http_metrics";
+    case METRIC_WS_FRAME:     return "ws_frame";
+    case METRIC_BLE_COMMAND:  return "ble_command";
+    case METRIC_BLE_STATUS:   return "ble_status";
+    default:                  return "unknown";
+  }
+}
+
+// Ticks to nanoseconds
+static uint64_t tickNanos(uint64_t ticks) {
+  return ticks * 1000 / RoombaMetrics::ticksPerMicrosecond();
+}
+
+static size_t writeSeries(Print& out, const char* metric, const char* suffix,
+                          RoombaMetricId id, uint64_t value, bool seconds) {
+  MetricLine line;
+  line.put(metric);
+  line.put(suffix);
+  line.put("{point=\"");
+  line.put(RoombaMetrics::name(id));
+  line.put("\"} ");
+  if (seconds) {
+    line.fixed(tickNanos(value), 9);
+  } else {
+    line.number(value);
+  }
+  return line.send(out);
+}
+
+static size_t writeHeader(Print& out, const char* metric, const char* type, const char* help) {
+  MetricLine line;
+  line.put("# HELP ");
+  line.put(metric);
+  line.put(' ');
+  line.put(help);
+  size_t written = line.send(out);
+
+  line.put("# TYPE ");
+  line.put(metric);
+  line.put(' ');
+  line.put(type);
+  return written + line.send(out);
+}
+
+size_t RoombaMetrics::writePrometheus(Print& out, const RoombaMetric* table) {
+  if (!enabled()) {
+    MetricLine line;
+    line.put("# ArduRoomba trace points not compiled (define ARDUROOMBA_METRICS)");
+    return line.send(out);
+  }
+
+  size_t written = writeHeader(out, "arduroomba_trace_seconds", "summary",
+                               "Time spent in each trace point");
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    written += writeSeries(out, "arduroomba_trace_seconds", "_sum", (RoombaMetricId)i, table[i].total, true);
+    written += writeSeries(out, "arduroomba_trace_seconds", "_count", (RoombaMetricId)i, table[i].count, false);
+  }
+
+  written += writeHeader(out, "arduroomba_trace_min_seconds", "gauge", "Shortest run of each trace point");
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    written += writeSeries(out, "arduroomba_trace_min_seconds", "", (RoombaMetricId)i, table[i].min, true);
+  }
+
+  written += writeHeader(out, "arduroomba_trace_max_seconds", "gauge", "Longest run of each trace point");
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    written += writeSeries(out, "arduroomba_trace_max_seconds", "", (RoombaMetricId)i, table[i].max, true);
+  }
+  return written;
+}
+
+size_t RoombaMetrics::writeSample(Print& out, const char* name, const char* type, uint64_t value) {
+  MetricLine line;
+  line.put("# TYPE ");
+  line.put(name);
+  line.put(' ');
+  line.put(type);
+  size_t written = line.send(out);
+
+  line.put(name);
+  line.put(' ');
+  line.number(value);
+  return written + line.send(out);
+}
+
+size_t RoombaMetrics::writeText(Print& out) {
+  MetricLine line;
+  if (!enabled()) {
+    line.put("Trace points not compiled (define ARDUROOMBA_METRICS)");
+    return line.send(out);
+  }
+
+  RoombaMetric table[METRIC_COUNT];
+  snapshot(table);
+
+  line.put("point");
+  line.pad(14);
+  line.put("      count     min_us    mean_us     max_us");
+  size_t written = line.send(out);
+
+  for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+    const RoombaMetric& metric = table[i];
+    uint64_t mean = metric.count ? metric.total / metric.count : 0;
+
+    line.put(name((RoombaMetricId)i));
+    line.pad(14);
+    line.number(metric.count, 11);
+    line.fixed(tickNanos(metric.min), 3, 11);
+    line.fixed(tickNanos(mean), 3, 11);
+    line.fixed(tickNanos(metric.max), 3, 11);
+    written += line.send(out);
+  }
+  return written;
+}
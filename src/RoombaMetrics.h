@@ -0,0 +1,93 @@
+/**
+ * @file RoombaMetrics.h
+ * @brief Compile-time gated trace points with a static timing table
+ *
+ * ROOMBA_TRACE(METRIC_x) at the top of a scope times that scope and adds the
+ * run to a fixed table: count, min, max and total duration per trace point.
+ * Nothing is printed or allocated on the hot path. Build with
+ * ARDUROOMBA_METRICS defined to compile the trace points; without it they
+ * expand to nothing and the table does not exist.
+ *
+ * Durations are counted in CPU cycles where the core has a cycle counter
+ * (ESP32, Cortex-M3/M4/M7 via DWT), in nanoseconds on the host and in
+ * micros() ticks elsewhere; ticksPerMicrosecond() converts. A single run
+ * longer than 2^32 ticks (about 17 s at 240 MHz) wraps.
+ *
+ * The table is read for /metrics (Prometheus text) and by writeText(), a
+ * human-readable dump for a serial command. Trace points in other tasks
+ * (ESP32 BLE callbacks) write their own entries without locking, so a read
+ * may catch one entry mid-update.
+ */
+
+#ifndef ROOMBA_METRICS_H
+#define ROOMBA_METRICS_H
+
+#include <Arduino.h>
+
+enum RoombaMetricId : uint8_t {
+  METRIC_TICK,          // ArduRoomba::tick()
+  METRIC_OI_SEND,       // One command written or queued
+  METRIC_OI_FLUSH,      // TX batch written
+  METRIC_OI_POLL,       // Stream bytes drained and parsed
+  METRIC_OI_DECODE,     // Stream frame decoded into the snapshot
+  METRIC_OI_QUERY,      // Waiting for a query reply
+  METRIC_HTTP_PARSE,    // Request bytes fed to the HTTP parser
+  METRIC_HTTP_STATUS,   // /status
+  METRIC_HTTP_COMMAND,  // /cmd
+  METRIC_HTTP_PAGE,     // Control page
+  METRIC_HTTP_METRICS,  // /metrics
+  METRIC_WS_FRAME,      // WebSocket frame handled
+  METRIC_BLE_COMMAND,   // BLE command write callback
+  METRIC_BLE_STATUS,    // BLE status update
+  METRIC_COUNT
+};
+
+struct RoombaMetric {
+  uint32_t count;
+  uint32_t min;   // Ticks
+  uint32_t max;
+  uint64_t total;
+};
+
+class RoombaMetrics {
+public:
+  static bool enabled();
+
+  static uint32_t now(); // Ticks
+  static uint32_t ticksPerMicrosecond();
+  static void record(RoombaMetricId id, uint32_t ticks);
+  static void reset();
+
+  // Copy of the table (METRIC_COUNT entries; all zero when disabled)
+  static void snapshot(RoombaMetric* table);
+
+  static const char* name(RoombaMetricId id);
+
+  // Prometheus text for a snapshot: arduroomba_trace_seconds summary plus
+  // min/max gauges, one series per trace point
+  static size_t writePrometheus(Print& out, const RoombaMetric* table);
+
+  // "# TYPE name type" and "name value" lines, for other exported values
+  static size_t writeSample(Print& out, const char* name, const char* type, uint64_t value);
+
+  // Table of count and min/mean/max microseconds, for a serial dump
+  static size_t writeText(Print& out);
+};
+
+#ifdef ARDUROOMBA_METRICS
+class RoombaTraceScope {
+public:
+  explicit RoombaTraceScope(RoombaMetricId id) : _id(id), _start(RoombaMetrics::now()) {}
+  ~RoombaTraceScope() { RoombaMetrics::record(_id, RoombaMetrics::now() - _start); }
+
+private:
+  RoombaMetricId _id;
+  uint32_t _start;
+};
+
+#define ROOMBA_TRACE(id) RoombaTraceScope roombaTrace(id)
+#else
+#define ROOMBA_TRACE(id) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file RoombaMotionProfile.cpp
+ * @brief Implementation of the wheel velocity profiler
+ */
+
+#include "RoombaMotionProfile.h"
+#include "RoombaOI.h"
+#include "RoombaOdometry.h"
+
+static int16_t toMillimeters(int32_t velocity) {
+  return (int16_t)((velocity >= 0 ? velocity + 128 : velocity - 128) / 256);
+}
+
+static int32_t clampMagnitude(int32_t value, int32_t limit) {
+  if (value > limit) return limit;
+  if (value < -limit) return -limit;
+  return value;
+}
+
+RoombaMotionProfile::RoombaMotionProfile() : _accel(0), _jerk(0) {
+  reset();
+}
+
+void RoombaMotionProfile::setLimits(uint16_t accel, uint16_t jerk) {
+  _accel = accel;
+  _jerk = jerk;
+  setTarget(targetRight(), targetLeft()); // Re-share the new limits
+}
+
+void RoombaMotionProfile::reset() {
+  memset(_wheels, 0, sizeof(_wheels));
+  _lastStep = 0;
+  _starting = false;
+  _sentRight = 0;
+  _sentLeft = 0;
+}
+
+void RoombaMotionProfile::setTarget(int16_t rightVel, int16_t leftVel) {
+  bool idle = !isRamping();
+  rightVel = constrain(rightVel, MIN_VELOCITY, MAX_VELOCITY);
+  leftVel = constrain(leftVel, MIN_VELOCITY, MAX_VELOCITY);
+  _wheels[0].target = (int32_t)rightVel * 256;
+  _wheels[1].target = (int32_t)leftVel * 256;
+
+  // Split the limits by each wheel's share of the change so they finish together
+  int32_t change[2];
+  int32_t largest = 0;
+  for (uint8_t i = 0; i < 2; i++) {
+    change[i] = abs(_wheels[i].target - _wheels[i].velocity);
+    if (change[i] > largest) largest = change[i];
+  }
+  for (uint8_t i = 0; i < 2; i++) {
+    Wheel& wheel = _wheels[i];
+    if (largest == 0) {
+      wheel.maxAccel = (int32_t)_accel * 256;
+      wheel.maxJerk = (int32_t)_jerk * 256;
+      continue;
+    }
+    wheel.maxAccel = (int32_t)((int64_t)_accel * 256 * change[i] / largest);
+    wheel.maxJerk = (int32_t)((int64_t)_jerk * 256 * change[i] / largest);
+    if (wheel.maxAccel == 0) wheel.maxAccel = 1;
+    if (_jerk != 0 && wheel.maxJerk == 0) wheel.maxJerk = 1;
+  }
+
+  // Idle time since the last step is not part of the ramp
+  if (idle && isRamping()) _starting = true;
+}
+
+bool RoombaMotionProfile::isRamping() const {
+  for (uint8_t i = 0; i < 2; i++) {
+    if (_wheels[i].velocity != _wheels[i].target || _wheels[i].accel != 0) return true;
+  }
+  return false;
+}
+
+bool RoombaMotionProfile::update(unsigned long now) {
+  if (!isEnabled()) return false;
+
+  if (!isRamping()) return false;
+
+  unsigned long elapsed = _starting ? MOTION_UPDATE_INTERVAL : now - _lastStep;
+  if (elapsed < MOTION_UPDATE_INTERVAL) return false;
+  _lastStep = now;
+  _starting = false;
+
+  int32_t dt = elapsed > MOTION_MAX_STEP ? MOTION_MAX_STEP : (int32_t)elapsed;
+  step(_wheels[0], dt);
+  step(_wheels[1], dt);
+
+  int16_t rightVel = toMillimeters(_wheels[0].velocity);
+  int16_t leftVel = toMillimeters(_wheels[1].velocity);
+  if (rightVel == _sentRight && leftVel == _sentLeft) return false;
+  _sentRight = rightVel;
+  _sentLeft = leftVel;
+  return true;
+}
+
+void RoombaMotionProfile::step(Wheel& wheel, int32_t dt) {
+  int32_t error = wheel.target - wheel.velocity;
+
+  if (wheel.maxJerk == 0) {
+    // Trapezoid: constant acceleration straight to the target
+    wheel.accel = 0;
+    wheel.velocity += clampMagnitude(error, (int32_t)((int64_t)wheel.maxAccel * dt / 1000));
+    return;
+  }
+
+  // S-curve: start easing the acceleration off once the velocity it will
+  // still add while ramping down to zero (a^2 / 2j) covers the remaining error
+  int32_t coast = (int32_t)((int64_t)wheel.accel * abs(wheel.accel) / (2 * (int64_t)wheel.maxJerk));
+  int32_t remaining = error - coast;
+  int32_t wanted = remaining > 0 ? wheel.maxAccel : (remaining < 0 ? -wheel.maxAccel : 0);
+  int32_t jerkStep = (int32_t)((int64_t)wheel.maxJerk * dt / 1000);
+  wheel.accel += clampMagnitude(wanted - wheel.accel, jerkStep);
+
+  int32_t change = (int32_t)((int64_t)wheel.accel * dt / 1000);
+  int32_t settle = (int32_t)((int64_t)jerkStep * dt / 1000); // Smallest step worth taking
+  bool overshoots = (error >= 0) ? change >= error : change <= error;
+  if (overshoots || (abs(error) <= settle && abs(wheel.accel) <= jerkStep)) {
+    wheel.velocity = wheel.target;
+    wheel.accel = 0;
+  } else {
+    wheel.velocity += change;
+  }
+}
+
+void RoombaMotionProfile::wheelSpeeds(int16_t velocity, int16_t radius,
+                                      int16_t& rightVel, int16_t& leftVel) {
+  if (radius == DRIVE_TURN_CCW) {
+    rightVel = velocity;
+    leftVel = -velocity;
+    return;
+  }
+  if (radius == DRIVE_TURN_CW) {
+    rightVel = -velocity;
+    leftVel = velocity;
+    return;
+  }
+  if (radius == (int16_t)DRIVE_STRAIGHT || radius == 32767 || radius == 0) {
+    rightVel = leftVel = velocity;
+    return;
+  }
+
+  // Velocity is that of the centre; each wheel scales with its own radius
+  int32_t twice = 2 * (int32_t)radius;
+  int32_t right = (int32_t)velocity * (twice + ODOMETRY_WHEEL_BASE_MM) / twice;
+  int32_t left = (int32_t)velocity * (twice - ODOMETRY_WHEEL_BASE_MM) / twice;
+
+  // Keep the radius if the outer wheel would exceed the speed limit
+  int32_t fastest = abs(right) > abs(left) ? abs(right) : abs(left);
+  if (fastest > MAX_VELOCITY) {
+    right = right * MAX_VELOCITY / fastest;
+    left = left * MAX_VELOCITY / fastest;
+  }
+  rightVel = (int16_t)right;
+  leftVel = (int16_t)left;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file RoombaMotionProfile.h
+ * @brief Acceleration- and jerk-limited wheel velocity setpoints
+ *
+ * Drive commands set a target speed for each wheel; update() moves the
+ * setpoints towards it once per OI stream period (15 ms). With only an
+ * acceleration limit the ramp is trapezoidal; adding a jerk limit rounds
+ * its corners into an S-curve. The wheel with the smaller change gets
+ * proportionally smaller limits, so both arrive together and an arc keeps
+ * its radius while ramping.
+ *
+ * Velocities are kept in 1/256 mm/s; update() reports a change only when
+ * the whole mm/s setpoint sent to the robot would actually differ.
+ */
+
+#ifndef ROOMBA_MOTION_PROFILE_H
+#define ROOMBA_MOTION_PROFILE_H
+
+#include <Arduino.h>
+
+#ifndef MOTION_UPDATE_INTERVAL
+#define MOTION_UPDATE_INTERVAL 15  // ms, the OI stream period
+#endif
+
+#ifndef MOTION_MAX_STEP
+#define MOTION_MAX_STEP 100        // ms; longer gaps between updates are clamped
+#endif
+
+class RoombaMotionProfile {
+public:
+  RoombaMotionProfile();
+
+  // accel in mm/s^2 (0 disables profiling), jerk in mm/s^3 (0 = trapezoidal)
+  void setLimits(uint16_t accel, uint16_t jerk);
+  bool isEnabled() const { return _accel != 0; }
+
+  // New wheel speed targets in mm/s, clamped to +-MAX_VELOCITY
+  void setTarget(int16_t rightVel, int16_t leftVel);
+
+  // Forget the current motion, e.g. when the robot drives itself
+  void reset();
+
+  // Advance to now (ms); true when the setpoints to send have changed
+  bool update(unsigned long now);
+
+  int16_t right() const { return _sentRight; }
+  int16_t left() const { return _sentLeft; }
+  int16_t targetRight() const { return _wheels[0].target / 256; }
+  int16_t targetLeft() const { return _wheels[1].target / 256; }
+  bool isRamping() const;
+
+  // Wheel speeds for an OI_DRIVE velocity and radius (DRIVE_* specials included)
+  static void wheelSpeeds(int16_t velocity, int16_t radius, int16_t& rightVel, int16_t& leftVel);
+
+private:
+  struct Wheel {
+    int32_t velocity; // 1/256 mm/s
+    int32_t accel;    // 1/256 mm/s^2
+    int32_t target;
+    int32_t maxAccel; // This wheel's share of the limits
+    int32_t maxJerk;
+  };
+
+  Wheel _wheels[2]; // Right, left (OI_DRIVE_DIRECT order)
+  uint16_t _accel;
+  uint16_t _jerk;
+  unsigned long _lastStep;
+  bool _starting;          // First step after idle uses the nominal interval
+  int16_t _sentRight;
+  int16_t _sentLeft;
+
+  void step(Wheel& wheel, int32_t dt);
+};
+
+#endif
@@ -4,20 +4,71 @@
  */
 
 #include "RoombaOI.h"
+#include "RoombaMetrics.h"
+
+// OI_BAUD rates, indexed by baud code
+static const uint32_t OI_BAUD_RATES[] PROGMEM = {
+  300, 600, 1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 115200
+};
+#define OI_BAUD_CODES (sizeof(OI_BAUD_RATES) / sizeof(OI_BAUD_RATES[0]))
+
+// Battery voltage range (mV) accepted as a sane reply by verifyLink()
+#define LINK_MIN_VOLTAGE 5000
+#define LINK_MAX_VOLTAGE 24000
 
 RoombaOI::RoombaOI(uint8_t rxPin, uint8_t txPin, uint8_t brcPin)
-  : _rxPin(rxPin), _txPin(txPin), _brcPin(brcPin), _connected(false), _debug(false) {
+  : _rxPin(rxPin), _txPin(txPin), _brcPin(brcPin), _baudRate(0), _portOpen(false), _debug(false),
+    _linkState(OI_LINK_OFF), _linkSince(0), _connectStart(0), _lastValid(0),
+    _wakeStep(0), _modeQueried(false), _probePending(false), _probeFailures(0),
+    _requestAt(0), _badStreak(0),
+    _snapshot(), _frameUnread(false), _streaming(false),
+    _txLength(0), _txBatching(false) {
     #ifdef ESP32
-      _hwSerial = new HardwareSerial(1);
-      _port = _hwSerial;
+      // Remaps UART1 to the requested pins when begin() opens it
+      _transport = new RoombaUartTransport(*new HardwareSerial(1), rxPin, txPin);
     #else
-      _swSerial = new SoftwareSerial(rxPin, txPin);
-      _port = _swSerial;
+      _transport = new RoombaSoftwareSerialTransport(rxPin, txPin);
     #endif
+    _port = _transport;
+}
+
+RoombaOI::RoombaOI(Stream& port, uint8_t brcPin)
+  : _port(&port), _transport(nullptr), _rxPin(0), _txPin(0), _brcPin(brcPin),
+    _baudRate(0), _portOpen(false), _debug(false),
+    _linkState(OI_LINK_OFF), _linkSince(0), _connectStart(0), _lastValid(0),
+    _wakeStep(0), _modeQueried(false), _probePending(false), _probeFailures(0),
+    _requestAt(0), _badStreak(0),
+    _snapshot(), _frameUnread(false), _streaming(false),
+    _txLength(0), _txBatching(false) {
+}
+
+RoombaOI::RoombaOI(RoombaTransport& transport, uint8_t brcPin)
+  : _port(&transport), _transport(&transport), _rxPin(0), _txPin(0), _brcPin(brcPin),
+    _baudRate(0), _portOpen(false), _debug(false),
+    _linkState(OI_LINK_OFF), _linkSince(0), _connectStart(0), _lastValid(0),
+    _wakeStep(0), _modeQueried(false), _probePending(false), _probeFailures(0),
+    _requestAt(0), _badStreak(0),
+    _snapshot(), _frameUnread(false), _streaming(false),
+    _txLength(0), _txBatching(false) {
 }
 
 bool RoombaOI::begin(uint32_t baudRate) {
-  if (_connected) return true;
+  if (isConnected()) return true;
+  
+  beginAsync(baudRate);
+  unsigned long start = millis();
+  while (serviceLink() != OI_LINK_EVENT_CONNECTED) {
+    if (millis() - start >= OI_CONNECT_TIMEOUT_MS) {
+      debugPrint("Roomba not responding");
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
+
+void RoombaOI::beginAsync(uint32_t baudRate) {
+  if (_linkState != OI_LINK_OFF) return;
   
   // Setup BRC pin
   pinMode(_brcPin, OUTPUT);
@@ -25,47 +76,142 @@ bool RoombaOI::begin(uint32_t baudRate) {
   
   debugPrint("Initializing Roomba OI...");
   
-  // Wait for power stabilization
-  delay(2000);
+  // Start serial communication
+  if (_transport) _transport->begin(baudRate);
+  _baudRate = baudRate;
+  _portOpen = true;
   
-  // Pulse BRC to wake up
-  pulseDD();
-  delay(100);
+  // A robot that is already awake answers straight away; the power settling
+  // time and BRC pulses are only spent when it does not
+  unsigned long now = millis();
+  _connectStart = now;
+  startHandshake(now);
+  setLinkState(OI_LINK_PROBING, now);
+}
+
+RoombaLinkEvent RoombaOI::serviceLink() {
+  unsigned long now = millis();
   
-  // Start serial communication
-  #ifdef ESP32
-  // Remap pins here: baud, config, RX, TX
-  // This maps your requested pins (RX=16, TX=0) to UART1
-    _hwSerial->begin(baudRate, SERIAL_8N1, _rxPin, _txPin);
-  #else
-    _swSerial->begin(baudRate);
-  #endif
+  switch (_linkState) {
+    case OI_LINK_PROBING:
+    case OI_LINK_STARTING: {
+      int8_t result = serviceHandshake(now);
+      if (result > 0) {
+        setLinkState(OI_LINK_CONNECTED, now);
+        _lastValid = now;
+        _probeFailures = 0;
+        _badStreak = 0;
+        _health.consecutiveTimeouts = 0;
+        _health.connects++;
+        debugPrint("Roomba OI connected");
+        return OI_LINK_EVENT_CONNECTED;
+      }
+      if (result < 0) {
+        setLinkState(_linkState == OI_LINK_PROBING ? OI_LINK_WAKING : OI_LINK_RETRY, now);
+      }
+      break;
+    }
+    
+    case OI_LINK_WAKING:
+      serviceWake(now);
+      break;
+    
+    case OI_LINK_RETRY:
+      if (now - _linkSince >= OI_RETRY_INTERVAL_MS) setLinkState(OI_LINK_WAKING, now);
+      break;
+    
+    case OI_LINK_CONNECTED: {
+      RoombaLinkLoss loss = checkLink(now);
+      if (loss != LINK_LOSS_NONE) {
+        // Asleep, unplugged or too noisy: restart as if the robot had slept,
+        // since it forgets its stream and mode when it does
+        debugPrint("Roomba link lost", loss);
+        _health.recordLoss(loss);
+        _streaming = false;
+        _frameUnread = false;
+        _parser.reset();
+        setLinkState(OI_LINK_WAKING, now);
+        return OI_LINK_EVENT_LOST;
+      }
+      break;
+    }
+    
+    case OI_LINK_OFF:
+      break;
+  }
+  return OI_LINK_EVENT_NONE;
+}
 
-  delay(100);
+void RoombaOI::resetLinkHealth() {
+  _health.reset();
+  _parser.resetStats();
+}
+
+void RoombaOI::end() {
+  if (_portOpen) {
+    powerOff();
+    flushTx();
+    if (_transport) _transport->end();
+    _portOpen = false;
+    _streaming = false;
+  }
+  _linkState = OI_LINK_OFF;
+}
+
+bool RoombaOI::negotiateBaud(uint32_t baudRate) {
+  int8_t code = baudCode(baudRate);
+  int8_t previousCode = baudCode(_baudRate);
+  if (!isConnected() || _streaming || !_transport || code < 0 || previousCode < 0) return false;
+  if (baudRate == _baudRate) return verifyLink();
   
-  // Send start command
-  start();
-  delay(100);
+  uint32_t previous = _baudRate;
+  switchBaud(code, baudRate);
+  if (verifyLink()) {
+    debugPrint("Baud rate changed", (int)(baudRate / 100));
+    return true;
+  }
   
-  // Enter safe mode
-  safeMode();
-  delay(100);
+  // The robot took the opcode at a rate it was known to understand, so it
+  // has most likely switched; ask it back at the new rate
+  debugPrint("Baud rate check failed, reverting");
+  switchBaud(previousCode, previous);
+  if (!verifyLink()) {
+    debugPrint("No reply at either baud rate");
+  }
+  return false;
+}
+
+void RoombaOI::switchBaud(uint8_t code, uint32_t baudRate) {
+  sendCommand(OI_BAUD, code);
+  flushTx();
+  _port->flush(); // Opcode leaves at the old rate
+  delay(OI_BAUD_SETTLE_MS);
   
-  _connected = true;
-  debugPrint("Roomba OI initialized");
-  return true;
+  _transport->begin(baudRate);
+  _baudRate = baudRate;
 }
 
-void RoombaOI::end() {
-  if (_connected) {
-    powerOff();
-    #ifdef ESP32
-      _hwSerial->end();
-    #else
-      _swSerial->end();
-    #endif
-    _connected = false;
+bool RoombaOI::verifyLink() {
+  // Mode and voltage in one round trip: the wrong rate loses or garbles bytes
+  static const uint8_t probe[] = { SENSOR_OI_MODE, SENSOR_VOLTAGE };
+  uint8_t data[3];
+  finishProbe();
+  while (_port->available() > 0) _port->read();
+  if (!queryList(probe, sizeof(probe), data, sizeof(data))) return false;
+  
+  uint16_t voltage = ((uint16_t)data[1] << 8) | data[2];
+  return data[0] <= 3 && voltage >= LINK_MIN_VOLTAGE && voltage <= LINK_MAX_VOLTAGE;
+}
+
+int8_t RoombaOI::baudCode(uint32_t baudRate) {
+  for (uint8_t code = 0; code < OI_BAUD_CODES; code++) {
+    if (pgm_read_dword(&OI_BAUD_RATES[code]) == baudRate) return code;
   }
+  return -1;
+}
+
+uint32_t RoombaOI::baudRateForCode(uint8_t code) {
+  return code < OI_BAUD_CODES ? pgm_read_dword(&OI_BAUD_RATES[code]) : 0;
 }
 
 void RoombaOI::start() {
@@ -152,131 +298,341 @@ void RoombaOI::setLEDs(uint8_t ledBits, uint8_t powerColor, uint8_t powerIntensi
 }
 
 bool RoombaOI::getSensor(uint8_t sensorId, uint8_t* data, uint8_t dataSize) {
-  if (!_connected || !data) return false;
+  if (!isConnected() || _streaming || !data) return false;
+  finishProbe();
+  while (_port->available() > 0) _port->read(); // Stream tail, not this reply
   
   sendCommand(OI_SENSORS, sensorId);
-  delay(15); // Wait for response
+  flushTx();
   
-  return readBytes(data, dataSize, 100);
+  return awaitReply(data, dataSize);
 }
 
 uint16_t RoombaOI::getBatteryVoltage() {
-  uint8_t data[2];
-  if (getSensor(SENSOR_VOLTAGE, data, 2)) {
-    return (data[0] << 8) | data[1];
-  }
-  return 0;
+  uint16_t voltage;
+  return getSensor<SENSOR_VOLTAGE>(voltage) ? voltage : 0;
 }
 
 int16_t RoombaOI::getBatteryCurrent() {
-  uint8_t data[2];
-  if (getSensor(SENSOR_CURRENT, data, 2)) {
-    return (int16_t)((data[0] << 8) | data[1]);
-  }
-  return 0;
+  int16_t current;
+  return getSensor<SENSOR_CURRENT>(current) ? current : 0;
 }
 
 bool RoombaOI::isWallDetected() {
-  uint8_t data;
-  if (getSensor(SENSOR_WALL, &data, 1)) {
-    return data != 0;
-  }
-  return false;
+  uint8_t wall;
+  return getSensor<SENSOR_WALL>(wall) && wall != 0;
 }
 
 bool RoombaOI::isBumperPressed() {
-  uint8_t data;
-  if (getSensor(SENSOR_BUMPS_DROPS, &data, 1)) {
-    return (data & 0x03) != 0; // Check bump bits
+  uint8_t bumps;
+  return getSensor<SENSOR_BUMPS_DROPS>(bumps) && (bumps & 0x03) != 0; // Check bump bits
+}
+
+bool RoombaOI::queryList(const uint8_t* packetIds, uint8_t numPackets, uint8_t* data, uint8_t dataSize) {
+  if (!isConnected() || _streaming || !packetIds || !data || numPackets == 0) return false;
+  
+  // Response is the packets' data back to back, sized by the packet table
+  uint16_t total = 0;
+  for (uint8_t i = 0; i < numPackets; i++) {
+    uint8_t size = RoombaPackets::size(packetIds[i]);
+    if (size == 0) return false;
+    total += size;
   }
-  return false;
+  if (total > dataSize) return false;
+  finishProbe();
+  while (_port->available() > 0) _port->read(); // Stream tail, not this reply
+  
+  if (!sendListCommand(OI_QUERY_LIST, packetIds, numPackets)) return false;
+  flushTx();
+  
+  return awaitReply(data, total);
 }
 
-bool RoombaOI::startSensorStream(const uint8_t* sensorList, uint8_t numSensors) {
-  if (!_connected || !sensorList || numSensors == 0) return false;
+bool RoombaOI::queryList(const uint8_t* packetIds, uint8_t numPackets, RoombaSensorSnapshot& snapshot) {
+  uint8_t data[OI_STREAM_MAX_PAYLOAD];
+  if (!queryList(packetIds, numPackets, data, sizeof(data))) return false;
   
-  sendCommand(OI_STREAM, numSensors);
+  snapshot.present = 0;
+  uint8_t offset = 0;
+  for (uint8_t i = 0; i < numPackets; i++) {
+    offset += snapshot.apply(packetIds[i], data + offset);
+  }
+  snapshot.timestamp = millis();
   
+  debugPrint("QUERY_LIST packets", numPackets);
+  return true;
+}
+
+bool RoombaOI::startSensorStream(const uint8_t* sensorList, uint8_t numSensors) {
+  if (!isConnected() || !sensorList || numSensors == 0) return false;
+  finishProbe();
+  
+  // Every frame must fit the parser's buffer
+  uint16_t payload = 0;
   for (uint8_t i = 0; i < numSensors; i++) {
-    _port->write(sensorList[i]);
+    uint8_t size = RoombaPackets::size(sensorList[i]);
+    if (size == 0) return false;
+    payload += 1 + size;
+  }
+  if (payload > OI_STREAM_MAX_PAYLOAD) {
+    debugPrint("Sensor stream too large", payload);
+    return false;
   }
   
+  _parser.reset();
+  if (!sendListCommand(OI_STREAM, sensorList, numSensors)) return false;
+  _streaming = true;
+  _lastValid = millis(); // The first frame is due one period from now
+  
   debugPrint("Sensor stream started", numSensors);
   return true;
 }
 
 bool RoombaOI::stopSensorStream() {
-  if (!_connected) return false;
+  if (!isConnected()) return false;
   
   sendCommand(OI_STREAM, 0); // 0 sensors = stop stream
+  _parser.reset();
+  _streaming = false;
   debugPrint("Sensor stream stopped");
   return true;
 }
 
-bool RoombaOI::readStreamData(uint8_t* buffer, uint8_t bufferSize) {
-  // Simple stream reading - look for header (19) then size byte
-  if (!_connected || !buffer) return false;
-  
-  // Wait for header byte (19)
-  unsigned long timeout = millis() + 100;
-  while (millis() < timeout) {
-    if (_port->available() && _port->read() == 19) {
-      // Found header, read size
-      uint8_t size = readByte(50);
-      if (size > 0 && size <= bufferSize) {
-        return readBytes(buffer, size, 100);
-      }
+bool RoombaOI::pollStream() {
+  // Idle, the port carries query and probe replies, which checkLink() and
+  // the queries read themselves
+  if (!isConnected() || !_streaming || _probePending) return false;
+  ROOMBA_TRACE(METRIC_OI_POLL);
+  
+  // Only consume what has already arrived; never wait for more
+  bool fresh = false;
+  uint32_t badFrames = _parser.getStats().badFrames;
+  while (_port->available() > 0) {
+    if (_parser.feed(_port->read())) {
+      fresh = true;
+      _badStreak = 0;
     }
   }
-  return false;
+  
+  // Rejected frames count towards a noisy link until a good one arrives
+  uint32_t rejected = _parser.getStats().badFrames - badFrames;
+  if (rejected > 0 && _badStreak < 0xFF) {
+    _badStreak = (rejected > 0xFFu - _badStreak) ? 0xFF : _badStreak + rejected;
+  }
+  
+  if (fresh) {
+    ROOMBA_TRACE(METRIC_OI_DECODE);
+    _parser.decode(_snapshot);
+    _snapshot.timestamp = millis();
+    _lastValid = _snapshot.timestamp;
+    _frameUnread = true;
+  }
+  return fresh;
+}
+
+bool RoombaOI::readStreamData(uint8_t* buffer, uint8_t bufferSize) {
+  // Returns the payload of the newest validated frame not yet read
+  if (!isConnected() || !buffer) return false;
+  
+  pollStream();
+  if (!_frameUnread || _parser.getFrameLength() > bufferSize) return false;
+  
+  memcpy(buffer, _parser.getFrame(), _parser.getFrameLength());
+  _frameUnread = false;
+  return true;
 }
 
 // Private helper methods
-void RoombaOI::pulseDD() {
-  debugPrint("Pulsing BRC pin");
-  for (int i = 0; i < 3; i++) {
-    digitalWrite(_brcPin, LOW);
-    delay(100);
-    digitalWrite(_brcPin, HIGH);
-    delay(100);
+void RoombaOI::setLinkState(RoombaLinkState state, unsigned long now) {
+  _linkState = state;
+  _linkSince = now;
+  if (state == OI_LINK_WAKING) _wakeStep = 0;
+  _probePending = false;
+}
+
+void RoombaOI::startHandshake(unsigned long now) {
+  // An awake robot may still be streaming; its frames would be read as the
+  // mode reply, so stop them and let the tail drain before asking
+  start();
+  sendCommand(OI_STREAM, 0);
+  flushTx();
+  _modeQueried = false;
+  _linkSince = now;
+}
+
+// 1 once the robot reports SAFE or FULL, -1 on a bad or missing reply
+int8_t RoombaOI::serviceHandshake(unsigned long now) {
+  if (!_modeQueried) {
+    if (now - _linkSince < OI_MODE_CHANGE_MS) return 0;
+    while (_port->available() > 0) _port->read();
+    safeMode();
+    sendCommand(OI_SENSORS, SENSOR_OI_MODE);
+    flushTx();
+    _modeQueried = true;
+    _linkSince = now;
+    return 0;
   }
+  
+  if (_port->available() > 0) {
+    int mode = _port->read();
+    return (mode == OI_MODE_SAFE || mode == OI_MODE_FULL) ? 1 : -1;
+  }
+  return (now - _linkSince >= OI_REPLY_TIMEOUT_MS) ? -1 : 0;
 }
 
-void RoombaOI::sendCommand(uint8_t cmd) {
-  if (_connected) {
-    _port->write(cmd);
+// Three BRC low/high pulses, one edge per call, then the handshake again
+void RoombaOI::serviceWake(unsigned long now) {
+  if (_wakeStep == 0) {
+    if (now - _connectStart < OI_POWER_SETTLE_MS) return;
+    debugPrint("Pulsing BRC pin");
+    _health.wakes++;
+  } else if (now - _linkSince < OI_WAKE_PULSE_MS) {
+    return;
+  }
+  
+  if (_wakeStep == 6) {
+    setLinkState(OI_LINK_STARTING, now);
+    startHandshake(now);
+    return;
   }
+  digitalWrite(_brcPin, (_wakeStep & 1) ? HIGH : LOW);
+  _wakeStep++;
+  _linkSince = now;
 }
 
-void RoombaOI::sendCommand(uint8_t cmd, uint8_t param) {
-  if (_connected) {
-    _port->write(cmd);
-    _port->write(param);
+// Streaming: frames must keep arriving. Idle: ask for the mode now and then.
+// Either way, runs of query timeouts or bad frames give up sooner
+RoombaLinkLoss RoombaOI::checkLink(unsigned long now) {
+  if (_health.consecutiveTimeouts >= OI_HEALTH_TIMEOUT_LIMIT) return LINK_LOSS_TIMEOUTS;
+  if (_badStreak >= OI_HEALTH_BAD_FRAME_LIMIT) return LINK_LOSS_CHECKSUM;
+  if (_streaming) return (now - _lastValid < OI_LINK_TIMEOUT_MS) ? LINK_LOSS_NONE : LINK_LOSS_SILENCE;
+  
+  if (_probePending) {
+    if (_port->available() > 0) {
+      settleProbe(true, _port->read());
+    } else if (now - _linkSince >= OI_REPLY_TIMEOUT_MS) {
+      settleProbe(false, 0);
+    }
+  } else if (now - _lastValid >= OI_LINK_TIMEOUT_MS) {
+    sendProbe(now);
   }
+  return (_probeFailures < OI_PROBE_RETRIES) ? LINK_LOSS_NONE : LINK_LOSS_PROBE;
 }
 
-void RoombaOI::sendCommand(uint8_t cmd, uint8_t param1, uint8_t param2) {
-  if (_connected) {
-    _port->write(cmd);
-    _port->write(param1);
-    _port->write(param2);
+void RoombaOI::sendProbe(unsigned long now) {
+  while (_port->available() > 0) _port->read();
+  sendCommand(OI_SENSORS, SENSOR_OI_MODE);
+  flushTx();
+  _probePending = true;
+  _linkSince = now;
+  _requestAt = micros();
+}
+
+void RoombaOI::settleProbe(bool replied, uint8_t mode) {
+  _probePending = false;
+  if (replied) {
+    _health.recordReply(micros() - _requestAt);
+  } else {
+    _health.recordTimeout();
   }
+  
+  // OFF means the robot wants START again, as after waking on its own
+  if (replied && mode >= OI_MODE_PASSIVE && mode <= OI_MODE_FULL) {
+    _lastValid = millis();
+    _probeFailures = 0;
+  } else {
+    _probeFailures++;
+  }
+}
+
+// A probe reply still on its way must not be read as a query's data
+void RoombaOI::finishProbe() {
+  if (!_probePending) return;
+  
+  uint8_t mode = 0;
+  bool replied = readBytes(&mode, 1, OI_REPLY_TIMEOUT_MS);
+  settleProbe(replied, mode);
+}
+
+void RoombaOI::sendCommand(uint8_t cmd) {
+  sendFrame(&cmd, 1);
+}
+
+void RoombaOI::sendCommand(uint8_t cmd, uint8_t param) {
+  uint8_t frame[2] = {cmd, param};
+  sendFrame(frame, 2);
+}
+
+void RoombaOI::sendCommand(uint8_t cmd, uint8_t param1, uint8_t param2) {
+  uint8_t frame[3] = {cmd, param1, param2};
+  sendFrame(frame, 3);
 }
 
 void RoombaOI::sendCommand(uint8_t cmd, const uint8_t* params, uint8_t numParams) {
-  if (_connected && params) {
-    _port->write(cmd);
-    for (uint8_t i = 0; i < numParams; i++) {
-      _port->write(params[i]);
-    }
+  if (!params || numParams + 1 > OI_TX_FRAME_MAX) return;
+  
+  uint8_t frame[OI_TX_FRAME_MAX];
+  frame[0] = cmd;
+  memcpy(frame + 1, params, numParams);
+  sendFrame(frame, numParams + 1);
+}
+
+void RoombaOI::setTxBatching(bool enable) {
+  if (!enable) flushTx();
+  _txBatching = enable;
+}
+
+void RoombaOI::flushTx() {
+  if (_txLength > 0) {
+    ROOMBA_TRACE(METRIC_OI_FLUSH);
+    _port->write(_txBuf, _txLength);
+    _txLength = 0;
+  }
+}
+
+// Send one complete command with a single write(), or queue it when batching
+void RoombaOI::sendFrame(const uint8_t* frame, uint8_t length) {
+  if (!_portOpen) return;
+  ROOMBA_TRACE(METRIC_OI_SEND);
+  
+  if (_txBatching && length <= OI_TX_BATCH_SIZE) {
+    if (_txLength + length > OI_TX_BATCH_SIZE) flushTx();
+    memcpy(_txBuf + _txLength, frame, length);
+    _txLength += length;
+    return;
   }
+  
+  _port->write(frame, length);
+}
+
+// Commands of the form [opcode][count][items...]
+bool RoombaOI::sendListCommand(uint8_t cmd, const uint8_t* list, uint8_t count) {
+  if (count + 2 > OI_TX_FRAME_MAX) return false;
+  
+  uint8_t frame[OI_TX_FRAME_MAX];
+  frame[0] = cmd;
+  frame[1] = count;
+  memcpy(frame + 2, list, count);
+  sendFrame(frame, count + 2);
+  return true;
 }
 
 void RoombaOI::sendInt16(int16_t value) {
-  if (_connected) {
-    _port->write((value >> 8) & 0xFF);
-    _port->write(value & 0xFF);
+  uint8_t bytes[2] = {(uint8_t)((value >> 8) & 0xFF), (uint8_t)(value & 0xFF)};
+  sendFrame(bytes, 2);
+}
+
+// Reply to the request just flushed, timed from now into the link health
+bool RoombaOI::awaitReply(uint8_t* data, uint8_t length) {
+  ROOMBA_TRACE(METRIC_OI_QUERY);
+  unsigned long sent = micros();
+  if (!readBytes(data, length, OI_REPLY_TIMEOUT_MS)) {
+    _health.recordTimeout();
+    return false;
   }
+  _health.recordReply(micros() - sent);
+  _lastValid = millis();
+  return true;
 }
 
 uint8_t RoombaOI::readByte(uint16_t timeout) {
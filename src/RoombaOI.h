@@ -11,11 +11,9 @@
 
 #include <Arduino.h>
 
-#ifdef ESP32
-  #include <HardwareSerial.h>
-#else
-  #include <SoftwareSerial.h>
-#endif
+#include "RoombaTransport.h"
+#include "RoombaStreamParser.h"
+#include "RoombaLinkHealth.h"
 
 // OI Command opcodes
 #define OI_START        128
@@ -35,24 +33,55 @@
 #define OI_SEEK_DOCK    143
 #define OI_DRIVE_DIRECT 145
 #define OI_STREAM       148
+#define OI_QUERY_LIST   149
+
+// Sensor packet IDs and metadata live in RoombaPackets.h
+
+// Largest single command frame (opcode + data) assembled on the stack
+#define OI_TX_FRAME_MAX 66
+
+// TX batch buffer; a batch is written with one write() per flush
+#ifndef OI_TX_BATCH_SIZE
+#define OI_TX_BATCH_SIZE 64
+#endif
+
+// Wait after OI_BAUD before talking at the new rate (per the OI spec)
+#ifndef OI_BAUD_SETTLE_MS
+#define OI_BAUD_SETTLE_MS 100
+#endif
+
+// OI modes, as reported in SENSOR_OI_MODE
+#define OI_MODE_OFF     0
+#define OI_MODE_PASSIVE 1
+#define OI_MODE_SAFE    2
+#define OI_MODE_FULL    3
 
-// Common sensor packet IDs
-#define SENSOR_BUMPS_DROPS      7
-#define SENSOR_WALL             8
-#define SENSOR_CLIFF_LEFT       9
-#define SENSOR_CLIFF_FRONT_LEFT 10
-#define SENSOR_CLIFF_FRONT_RIGHT 11
-#define SENSOR_CLIFF_RIGHT      12
-#define SENSOR_VIRTUAL_WALL     13
-#define SENSOR_BUTTONS          18
-#define SENSOR_DISTANCE         19
-#define SENSOR_ANGLE           20
-#define SENSOR_CHARGING_STATE   21
-#define SENSOR_VOLTAGE         22
-#define SENSOR_CURRENT         23
-#define SENSOR_TEMPERATURE     24
-#define SENSOR_BATTERY_CHARGE  25
-#define SENSOR_BATTERY_CAPACITY 26
+// Connection timing (ms). BRC pulses only count once the robot has been
+// powered for OI_POWER_SETTLE_MS, measured from beginAsync()
+#ifndef OI_POWER_SETTLE_MS
+#define OI_POWER_SETTLE_MS 2000
+#endif
+#define OI_WAKE_PULSE_MS   100     // BRC low and high time of each pulse
+#define OI_MODE_CHANGE_MS  20      // Between START and SAFE
+#ifndef OI_REPLY_TIMEOUT_MS
+#define OI_REPLY_TIMEOUT_MS 100    // Mode query reply
+#endif
+#ifndef OI_CONNECT_TIMEOUT_MS
+#define OI_CONNECT_TIMEOUT_MS 4000 // begin() gives up; serviceLink() keeps trying
+#endif
+#ifndef OI_RETRY_INTERVAL_MS
+#define OI_RETRY_INTERVAL_MS 1000  // Between failed wake attempts
+#endif
+#ifndef OI_LINK_TIMEOUT_MS
+#define OI_LINK_TIMEOUT_MS 1000    // Stream silence, or idle time before a mode probe
+#endif
+#define OI_PROBE_RETRIES   2       // Failed mode probes in a row before the link is lost
+#ifndef OI_HEALTH_TIMEOUT_LIMIT
+#define OI_HEALTH_TIMEOUT_LIMIT 3    // Query timeouts in a row before the link is lost
+#endif
+#ifndef OI_HEALTH_BAD_FRAME_LIMIT
+#define OI_HEALTH_BAD_FRAME_LIMIT 8  // Bad stream frames in a row before the link is lost
+#endif
 
 // Drive constants
 #define DRIVE_STRAIGHT     32768
@@ -61,14 +90,55 @@
 #define MAX_VELOCITY       500
 #define MIN_VELOCITY       -500
 
+enum RoombaLinkState : uint8_t {
+  OI_LINK_OFF,        // Not started, or end()
+  OI_LINK_PROBING,    // START/SAFE sent to a robot that may already be awake
+  OI_LINK_WAKING,     // Pulsing BRC
+  OI_LINK_STARTING,   // START/SAFE sent after waking, mode reply pending
+  OI_LINK_RETRY,      // Waiting before the next wake attempt
+  OI_LINK_CONNECTED   // Mode reply seen; watched for stream silence or sleep
+};
+
+enum RoombaLinkEvent : uint8_t {
+  OI_LINK_EVENT_NONE,
+  OI_LINK_EVENT_CONNECTED,
+  OI_LINK_EVENT_LOST
+};
+
 class RoombaOI {
 public:
   RoombaOI(uint8_t rxPin, uint8_t txPin, uint8_t brcPin);
+  // Use an already-opened port (begin() will not reconfigure it)
+  RoombaOI(Stream& port, uint8_t brcPin);
+  // Use a transport that begin() opens, e.g. RoombaUartTransport over Serial1
+  RoombaOI(RoombaTransport& transport, uint8_t brcPin);
   
-  // Basic setup
+  // Basic setup. begin() runs the connection state machine until the robot
+  // answers or OI_CONNECT_TIMEOUT_MS passes; beginAsync() only starts it and
+  // serviceLink() advances it without blocking, reconnecting after sleep
   bool begin(uint32_t baudRate = 19200);
+  void beginAsync(uint32_t baudRate = 19200);
+  RoombaLinkEvent serviceLink();
   void end();
-  bool isConnected() const { return _connected; }
+  bool isConnected() const { return _linkState == OI_LINK_CONNECTED; }
+  RoombaLinkState getLinkState() const { return _linkState; }
+  
+  // Link health: query latency and timeouts, wakes and losses (see
+  // RoombaLinkHealth.h), plus the stream's frame counters
+  const RoombaLinkHealth& getLinkHealth() const { return _health; }
+  unsigned long getTimeSinceValid() const { return millis() - _lastValid; } // ms
+  void resetLinkHealth();
+  uint32_t getBaudRate() const { return _baudRate; }
+  
+  // Switch robot and transport to another rate with OI_BAUD, then check the
+  // link with a sensor query; on failure both go back to the previous rate.
+  // Needs a RoombaTransport and a stopped stream
+  bool negotiateBaud(uint32_t baudRate);
+  bool verifyLink();
+  
+  // OI_BAUD code for a rate (-1 if the OI has none) and back (0 if invalid)
+  static int8_t baudCode(uint32_t baudRate);
+  static uint32_t baudRateForCode(uint8_t code);
   
   // Core OI commands
   void start();
@@ -90,19 +160,34 @@ public:
   void setMotors(bool mainBrush, bool sideBrush, bool vacuum);
   void setLEDs(uint8_t ledBits, uint8_t powerColor, uint8_t powerIntensity);
   
-  // Sensors
+  // Sensors: one query round trip, or while streaming the newest frame
+  // (the raw form fails then, as queryList() does)
   bool getSensor(uint8_t sensorId, uint8_t* data, uint8_t dataSize);
+  template <uint8_t Id> bool getSensor(typename OIPacket<Id>::type& value);
   uint16_t getBatteryVoltage();
   int16_t getBatteryCurrent();
   bool isWallDetected();
   bool isBumperPressed();
   
-  // Streaming (basic)
+  // Query list: several packets in one round trip (not while streaming)
+  bool queryList(const uint8_t* packetIds, uint8_t numPackets, uint8_t* data, uint8_t dataSize);
+  bool queryList(const uint8_t* packetIds, uint8_t numPackets, RoombaSensorSnapshot& snapshot);
+  
+  // Streaming
   bool startSensorStream(const uint8_t* sensorList, uint8_t numSensors);
   bool stopSensorStream();
+  bool isStreaming() const { return _streaming; }
+  bool pollStream(); // Non-blocking; true if a new frame was decoded
   bool readStreamData(uint8_t* buffer, uint8_t bufferSize);
+  const RoombaSensorSnapshot& getStreamSnapshot() const { return _snapshot; }
+  const RoombaStreamStats& getStreamStats() const { return _parser.getStats(); }
   
 
+  // TX batching: commands are queued and sent in one burst by flushTx()
+  void setTxBatching(bool enable);
+  bool isTxBatching() const { return _txBatching; }
+  void flushTx();
+
   // Internal helpers
   void sendCommand(uint8_t cmd);
   void sendCommand(uint8_t cmd, uint8_t param);
@@ -114,22 +199,52 @@ public:
   
 private:
 
-  Stream* _port; // Polymorphic pointer (works for Soft and Hard serial)
-  #ifdef ESP32
-    HardwareSerial* _hwSerial;
-  #else
-    SoftwareSerial* _swSerial;
-  #endif
+  Stream* _port; // Everything reads and writes through this
+  RoombaTransport* _transport; // Opened by begin(); null when a plain Stream was injected
 
   uint8_t _rxPin, _txPin, _brcPin;
-  bool _connected;
+  uint32_t _baudRate;
+  bool _portOpen;    // Commands are only sent while the port is open
   bool _debug;
+
+  RoombaLinkState _linkState;
+  unsigned long _linkSince;   // Entry to the current state or step
+  unsigned long _connectStart;
+  unsigned long _lastValid;   // Last frame or reply that proved the link
+  uint8_t _wakeStep;          // BRC edges written so far
+  bool _modeQueried;          // Handshake has sent SAFE and the mode query
+  bool _probePending;
+  uint8_t _probeFailures;
+  unsigned long _requestAt;   // micros() when the pending probe went out
+  uint8_t _badStreak;         // Bad stream frames since the last good one
+  RoombaLinkHealth _health;
+
+  RoombaStreamParser _parser;
+  RoombaSensorSnapshot _snapshot;
+  bool _frameUnread;
+  bool _streaming;
+  
+  uint8_t _txBuf[OI_TX_BATCH_SIZE];
+  uint8_t _txLength;
+  bool _txBatching;
   
   // Internal helpers
-  void pulseDD();
+  void setLinkState(RoombaLinkState state, unsigned long now);
+  void startHandshake(unsigned long now);
+  int8_t serviceHandshake(unsigned long now);
+  void serviceWake(unsigned long now);
+  RoombaLinkLoss checkLink(unsigned long now);
+  void sendProbe(unsigned long now);
+  void settleProbe(bool replied, uint8_t mode);
+  void finishProbe();
+  void switchBaud(uint8_t code, uint32_t baudRate);
+  
+  void sendFrame(const uint8_t* frame, uint8_t length);
+  bool sendListCommand(uint8_t cmd, const uint8_t* list, uint8_t count);
 
   void sendInt16(int16_t value);
   
+  bool awaitReply(uint8_t* data, uint8_t length);
   uint8_t readByte(uint16_t timeout = 100);
   bool readBytes(uint8_t* buffer, uint8_t numBytes, uint16_t timeout = 100);
   
@@ -137,4 +252,21 @@ private:
   void debugPrint(const char* msg, int value);
 };
 
+template <uint8_t Id>
+bool RoombaOI::getSensor(typename OIPacket<Id>::type& value) {
+  // While streaming, the port carries frames: answer from the newest one
+  // decoded (pollStream() takes them in) and leave the port alone
+  if (_streaming) {
+    if (!_snapshot.has(Id)) return false;
+    value = _snapshot.get<Id>();
+    return true;
+  }
+  
+  uint8_t data[OIPacket<Id>::size];
+  if (!getSensor(Id, data, OIPacket<Id>::size)) return false;
+  
+  value = OIPacket<Id>::decode(data);
+  return true;
+}
+
 #endif
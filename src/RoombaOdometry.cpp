@@ -0,0 +1,99 @@
+/**
+ * @file RoombaOdometry.cpp
+ * @brief Fixed-point differential-drive integration
+ */
+
+#include "RoombaOdometry.h"
+
+// sin(i * pi / 128) in Q15 for the first quarter turn, both ends included
+static const int16_t SINE_TABLE[65] PROGMEM = {
+      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+   6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+  18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+  27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+  32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767
+};
+
+// 2^32 / (2 pi): binary angle units per radian
+#define ANGLE_PER_RADIAN 683565276ULL
+
+RoombaOdometry::RoombaOdometry() {
+  setCalibration(ODOMETRY_UM_PER_COUNT_Q8, ODOMETRY_WHEEL_BASE_MM);
+  reset();
+}
+
+void RoombaOdometry::reset() {
+  RoombaPose origin = { 0, 0, 0 };
+  setPose(origin);
+  _seeded = false;
+  _resyncs = 0;
+}
+
+void RoombaOdometry::setPose(const RoombaPose& pose) {
+  _pose = pose;
+  _x = (int64_t)pose.x * 256;
+  _y = (int64_t)pose.y * 256;
+}
+
+void RoombaOdometry::setCalibration(uint32_t umPerCountQ8, uint16_t wheelBaseMm) {
+  if (umPerCountQ8 == 0 || wheelBaseMm == 0) return;
+  _umPerCountQ8 = umPerCountQ8;
+  // dTheta = (dRight - dLeft) * distance per count / wheel base
+  _anglePerCount = (uint32_t)(((uint64_t)umPerCountQ8 * ANGLE_PER_RADIAN) /
+                              ((uint64_t)wheelBaseMm * 1000 * 256));
+}
+
+bool RoombaOdometry::update(uint16_t leftCounts, uint16_t rightCounts) {
+  // Modulo 2^16, so a wrap in either direction is just a small step
+  int16_t left = (int16_t)(leftCounts - _lastLeft);
+  int16_t right = (int16_t)(rightCounts - _lastRight);
+  _lastLeft = leftCounts;
+  _lastRight = rightCounts;
+
+  if (!_seeded) {
+    _seeded = true;
+    return false;
+  }
+  if (left > ODOMETRY_MAX_STEP || left < -ODOMETRY_MAX_STEP ||
+      right > ODOMETRY_MAX_STEP || right < -ODOMETRY_MAX_STEP) {
+    _resyncs++;
+    return false;
+  }
+  if (left == 0 && right == 0) return true;
+
+  uint32_t turn = (uint32_t)((int32_t)(right - left) * (int64_t)_anglePerCount);
+
+  // Centre travel along the mid-step heading (exact for arcs to second order)
+  int64_t distance = ((int32_t)left + right) * (int64_t)_umPerCountQ8 / 2;
+  uint32_t heading = _pose.heading + (uint32_t)((int32_t)turn / 2);
+  _x += (distance * cos(heading)) >> 15;
+  _y += (distance * sin(heading)) >> 15;
+  _pose.heading += turn;
+
+  _pose.x = (int32_t)((_x + 128) >> 8);
+  _pose.y = (int32_t)((_y + 128) >> 8);
+  return true;
+}
+
+int16_t RoombaOdometry::sin(uint32_t angle) {
+  uint8_t segment = angle >> 24;           // 256 segments per turn
+  uint16_t fraction = (angle >> 8) & 0xFFFF;
+  uint8_t index = segment & 63;
+
+  int16_t a, b;
+  if (segment & 64) {
+    // Second and fourth quarters run the table backwards
+    a = pgm_read_word(&SINE_TABLE[64 - index]);
+    b = pgm_read_word(&SINE_TABLE[63 - index]);
+  } else {
+    a = pgm_read_word(&SINE_TABLE[index]);
+    b = pgm_read_word(&SINE_TABLE[index + 1]);
+  }
+
+  int16_t value = a + (int16_t)(((int32_t)(b - a) * fraction) >> 16);
+  return (segment & 128) ? -value : value;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file RoombaOdometry.h
+ * @brief Dead-reckoning pose from the wheel encoder counts
+ *
+ * Integrates packets 43/44 (left/right encoder counts) as they arrive in the
+ * sensor stream. The counts are absolute and wrap at 16 bits, so steps are
+ * taken modulo 2^16 and a dropped frame only makes the next step longer;
+ * nothing is lost the way the reset-on-read DISTANCE/ANGLE packets lose it.
+ *
+ * Everything is fixed point: position in 1/256 um, heading as a 32-bit
+ * binary angle (2^32 per turn, so it wraps for free) and a quarter-wave sine
+ * table, so an update costs a few integer multiplies even on AVR.
+ */
+
+#ifndef ROOMBA_ODOMETRY_H
+#define ROOMBA_ODOMETRY_H
+
+#include <Arduino.h>
+
+// Create 2 drive geometry: 72 mm wheels, 508.8 counts per revolution
+#ifndef ODOMETRY_WHEEL_BASE_MM
+#define ODOMETRY_WHEEL_BASE_MM 235
+#endif
+
+#ifndef ODOMETRY_UM_PER_COUNT_Q8
+#define ODOMETRY_UM_PER_COUNT_Q8 113809  // 444.57 um per count, x256
+#endif
+
+// Larger steps between frames (power cycle, garbled frame) re-seed instead of moving
+#ifndef ODOMETRY_MAX_STEP
+#define ODOMETRY_MAX_STEP 2000
+#endif
+
+#define ODOMETRY_ANGLE_HALF_TURN 0x80000000UL
+
+struct RoombaPose {
+  int32_t x;        // um, along the heading at reset
+  int32_t y;        // um, to the left
+  uint32_t heading; // Binary angle, counter-clockwise, 2^32 per turn
+
+  float xMillimeters() const { return x / 1000.0f; }
+  float yMillimeters() const { return y / 1000.0f; }
+  float headingRadians() const { return (int32_t)heading * (PI / 2147483648.0f); }   // (-pi, pi]
+  float headingDegrees() const { return (int32_t)heading * (180.0f / 2147483648.0f); }
+};
+
+class RoombaOdometry {
+public:
+  RoombaOdometry();
+
+  // Back to the origin; the next update only seeds the counters
+  void reset();
+  void setPose(const RoombaPose& pose);
+
+  // Wheel calibration (defaults above); resets nothing
+  void setCalibration(uint32_t umPerCountQ8, uint16_t wheelBaseMm);
+
+  // Feed one pair of encoder readings; false if it only (re-)seeded
+  bool update(uint16_t leftCounts, uint16_t rightCounts);
+
+  const RoombaPose& getPose() const { return _pose; }
+  uint32_t getResyncCount() const { return _resyncs; }
+
+  // Q15 sine/cosine of a binary angle, linearly interpolated
+  static int16_t sin(uint32_t angle);
+  static int16_t cos(uint32_t angle) { return sin(angle + (ODOMETRY_ANGLE_HALF_TURN >> 1)); }
+
+private:
+  RoombaPose _pose;
+  int64_t _x;              // 1/256 um; _pose holds the rounded value
+  int64_t _y;
+  uint16_t _lastLeft;
+  uint16_t _lastRight;
+  bool _seeded;
+  uint32_t _resyncs;
+
+  uint32_t _umPerCountQ8;
+  uint32_t _anglePerCount; // Binary angle per count of wheel difference
+};
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * @file RoombaPackets.cpp
+ * @brief Runtime lookups over the sensor packet tables
+ */
+
+#include "RoombaPackets.h"
+
+// Names for packets 7-58 in id order, each NUL-terminated
+static const char OI_PACKET_NAMES[] PROGMEM =
+  "bumps_drops\0"                   //  7
+  "wall\0"                          //  8
+  "cliff_left\0"                    //  9
+  "cliff_front_left\0"              // 10
+  "cliff_front_right\0"             // 11
+  "cliff_right\0"                   // 12
+  "virtual_wall\0"                  // 13
+  "overcurrents\0"                  // 14
+  "dirt_detect\0"                   // 15
+  "unused_16\0"                     // 16
+  "ir_opcode\0"                     // 17
+  "buttons\0"                       // 18
+  "distance\0"                      // 19
+  "angle\0"                         // 20
+  "charging_state\0"                // 21
+  "voltage\0"                       // 22
+  "current\0"                       // 23
+  "temperature\0"                   // 24
+  "battery_charge\0"                // 25
+  "battery_capacity\0"              // 26
+  "wall_signal\0"                   // 27
+  "cliff_left_signal\0"             // 28
+  "cliff_front_left_signal\0"       // 29
+  "cliff_front_right_signal\0"      // 30
+  "cliff_right_signal\0"            // 31
+  "unused_32\0"                     // 32
+  "unused_33\0"                     // 33
+  "charging_sources\0"              // 34
+  "oi_mode\0"                       // 35
+  "song_number\0"                   // 36
+  "song_playing\0"                  // 37
+  "stream_packets\0"                // 38
+  "requested_velocity\0"            // 39
+  "requested_radius\0"              // 40
+  "requested_right_velocity\0"      // 41
+  "requested_left_velocity\0"       // 42
+  "left_encoder\0"                  // 43
+  "right_encoder\0"                 // 44
+  "light_bumper\0"                  // 45
+  "light_bump_left\0"               // 46
+  "light_bump_front_left\0"         // 47
+  "light_bump_center_left\0"        // 48
+  "light_bump_center_right\0"       // 49
+  "light_bump_front_right\0"        // 50
+  "light_bump_right\0"              // 51
+  "ir_opcode_left\0"                // 52
+  "ir_opcode_right\0"               // 53
+  "left_motor_current\0"            // 54
+  "right_motor_current\0"           // 55
+  "main_brush_current\0"            // 56
+  "side_brush_current\0"            // 57
+  "stasis\0";                       // 58
+
+static uint8_t tableSize(uint8_t packetId) {
+  return pgm_read_byte(&OI_PACKET_TABLE[packetId - OI_PACKET_FIRST].size);
+}
+
+static uint8_t tableOffset(uint8_t packetId) {
+  return pgm_read_byte(&OI_PACKET_TABLE[packetId - OI_PACKET_FIRST].offset);
+}
+
+bool RoombaPackets::range(uint8_t packetId, uint8_t& first, uint8_t& last) {
+  if (packetId >= OI_PACKET_FIRST && packetId <= OI_PACKET_LAST) {
+    first = last = packetId;
+    return true;
+  }
+
+  for (uint8_t i = 0; i < OI_GROUP_COUNT; i++) {
+    if (pgm_read_byte(&OI_GROUP_TABLE[i].id) == packetId) {
+      first = pgm_read_byte(&OI_GROUP_TABLE[i].first);
+      last = pgm_read_byte(&OI_GROUP_TABLE[i].last);
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t RoombaPackets::size(uint8_t packetId) {
+  uint8_t first, last;
+  if (!range(packetId, first, last)) return 0;
+
+  // Groups are contiguous in the table layout
+  return tableOffset(last) + tableSize(last) - tableOffset(first);
+}
+
+bool RoombaPackets::info(uint8_t packetId, OIPacketInfo& out) {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST) return false;
+
+  memcpy_P(&out, &OI_PACKET_TABLE[packetId - OI_PACKET_FIRST], sizeof(out));
+  return true;
+}
+
+const char* RoombaPackets::unitName(OIUnit unit) {
+  switch (unit) {
+    case OI_UNIT_MM:       return "mm";
+    case OI_UNIT_DEGREES:  return "deg";
+    case OI_UNIT_MV:       return "mV";
+    case OI_UNIT_MA:       return "mA";
+    case OI_UNIT_CELSIUS:  return "C";
+    case OI_UNIT_MAH:      return "mAh";
+    case OI_UNIT_MM_PER_S: return "mm/s";
+    case OI_UNIT_COUNTS:   return "counts";
+    default:               return "";
+  }
+}
+
+uint8_t RoombaPackets::name(uint8_t packetId, char* out, size_t outSize) {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST || outSize == 0) return 0;
+
+  const char* p = OI_PACKET_NAMES;
+  for (uint8_t id = OI_PACKET_FIRST; id < packetId; id++) {
+    while (pgm_read_byte(p++) != '\0') {}
+  }
+
+  uint8_t length = 0;
+  char c;
+  while ((c = (char)pgm_read_byte(p + length)) != '\0' && length + 1u < outSize) {
+    out[length++] = c;
+  }
+  out[length] = '\0';
+  return length;
+}
+
+uint8_t RoombaPackets::idForName(const char* name, size_t length) {
+  if (!name || length == 0) return 0;
+
+  const char* p = OI_PACKET_NAMES;
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    size_t i = 0;
+    char c;
+    while ((c = (char)pgm_read_byte(p + i)) != '\0' && i < length && c == name[i]) i++;
+    if (i == length && c == '\0') return id;
+
+    while (pgm_read_byte(p++) != '\0') {}
+  }
+  return 0;
+}
+
+bool RoombaSensorSnapshot::has(uint8_t packetId) const {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST) return false;
+  return (present & PACKET_BIT(packetId)) != 0;
+}
+
+uint8_t RoombaSensorSnapshot::apply(uint8_t packetId, const uint8_t* data) {
+  uint8_t first, last;
+  if (!data || !RoombaPackets::range(packetId, first, last)) return 0;
+
+  uint8_t offset = tableOffset(first);
+  uint8_t size = tableOffset(last) + tableSize(last) - offset;
+  memcpy(raw + offset, data, size);
+
+  for (uint8_t id = first; id <= last; id++) {
+    present |= PACKET_BIT(id);
+  }
+  return size;
+}
+
+int32_t RoombaSensorSnapshot::value(uint8_t packetId) const {
+  if (packetId < OI_PACKET_FIRST || packetId > OI_PACKET_LAST) return 0;
+
+  const uint8_t* data = raw + tableOffset(packetId);
+  bool isSigned = pgm_read_byte(&OI_PACKET_TABLE[packetId - OI_PACKET_FIRST].isSigned);
+  if (tableSize(packetId) == 1) {
+    return isSigned ? (int32_t)(int8_t)data[0] : (int32_t)data[0];
+  }
+  uint16_t v = ((uint16_t)data[0] << 8) | data[1];
+  return isSigned ? (int32_t)(int16_t)v : (int32_t)v;
+}
@@ -0,0 +1,288 @@
+/**
+ * @file RoombaPackets.h
+ * @brief Create 2 sensor packet IDs and compile-time packet metadata
+ *
+ * One constexpr table describes every single sensor packet (7-58): data size,
+ * signedness, unit, scale and its offset in the group 100 layout. Group
+ * packets are contiguous ranges of that table. OIPacket<Id> resolves the C++
+ * value type and decoder at compile time; the runtime lookups used by the
+ * stream parser and query lists read the same table from flash.
+ */
+
+#ifndef ROOMBA_PACKETS_H
+#define ROOMBA_PACKETS_H
+
+#include <Arduino.h>
+
+// Single sensor packet IDs
+#define SENSOR_BUMPS_DROPS              7
+#define SENSOR_WALL                     8
+#define SENSOR_CLIFF_LEFT               9
+#define SENSOR_CLIFF_FRONT_LEFT         10
+#define SENSOR_CLIFF_FRONT_RIGHT        11
+#define SENSOR_CLIFF_RIGHT              12
+#define SENSOR_VIRTUAL_WALL             13
+#define SENSOR_OVERCURRENTS             14
+#define SENSOR_DIRT_DETECT              15
+#define SENSOR_UNUSED_16                16
+#define SENSOR_IR_OPCODE                17
+#define SENSOR_BUTTONS                  18
+#define SENSOR_DISTANCE                 19
+#define SENSOR_ANGLE                    20
+#define SENSOR_CHARGING_STATE           21
+#define SENSOR_VOLTAGE                  22
+#define SENSOR_CURRENT                  23
+#define SENSOR_TEMPERATURE              24
+#define SENSOR_BATTERY_CHARGE           25
+#define SENSOR_BATTERY_CAPACITY         26
+#define SENSOR_WALL_SIGNAL              27
+#define SENSOR_CLIFF_LEFT_SIGNAL        28
+#define SENSOR_CLIFF_FRONT_LEFT_SIGNAL  29
+#define SENSOR_CLIFF_FRONT_RIGHT_SIGNAL 30
+#define SENSOR_CLIFF_RIGHT_SIGNAL       31
+#define SENSOR_UNUSED_32                32
+#define SENSOR_UNUSED_33                33
+#define SENSOR_CHARGING_SOURCES         34
+#define SENSOR_OI_MODE                  35
+#define SENSOR_SONG_NUMBER              36
+#define SENSOR_SONG_PLAYING             37
+#define SENSOR_STREAM_PACKETS           38
+#define SENSOR_REQUESTED_VELOCITY       39
+#define SENSOR_REQUESTED_RADIUS         40
+#define SENSOR_REQUESTED_RIGHT_VELOCITY 41
+#define SENSOR_REQUESTED_LEFT_VELOCITY  42
+#define SENSOR_LEFT_ENCODER             43
+#define SENSOR_RIGHT_ENCODER            44
+#define SENSOR_LIGHT_BUMPER             45
+#define SENSOR_LIGHT_BUMP_LEFT          46
+#define SENSOR_LIGHT_BUMP_FRONT_LEFT    47
+#define SENSOR_LIGHT_BUMP_CENTER_LEFT   48
+#define SENSOR_LIGHT_BUMP_CENTER_RIGHT  49
+#define SENSOR_LIGHT_BUMP_FRONT_RIGHT   50
+#define SENSOR_LIGHT_BUMP_RIGHT         51
+#define SENSOR_IR_OPCODE_LEFT           52
+#define SENSOR_IR_OPCODE_RIGHT          53
+#define SENSOR_LEFT_MOTOR_CURRENT       54
+#define SENSOR_RIGHT_MOTOR_CURRENT      55
+#define SENSOR_MAIN_BRUSH_CURRENT       56
+#define SENSOR_SIDE_BRUSH_CURRENT       57
+#define SENSOR_STASIS                   58
+
+// Group packet IDs (Create 2 defines 0-6, 100, 101, 106 and 107)
+#define SENSOR_GROUP_7_26     0
+#define SENSOR_GROUP_7_16     1
+#define SENSOR_GROUP_17_20    2
+#define SENSOR_GROUP_21_26    3
+#define SENSOR_GROUP_27_34    4
+#define SENSOR_GROUP_35_42    5
+#define SENSOR_GROUP_7_42     6
+#define SENSOR_GROUP_ALL      100
+#define SENSOR_GROUP_43_58    101
+#define SENSOR_GROUP_46_51    106
+#define SENSOR_GROUP_54_58    107
+
+#define OI_PACKET_FIRST      7
+#define OI_PACKET_LAST       58
+#define OI_PACKET_COUNT      (OI_PACKET_LAST - OI_PACKET_FIRST + 1)
+#define PACKET_BIT(id)       ((uint64_t)1 << ((id) - OI_PACKET_FIRST)) // Bit in a packet mask
+#define OI_PACKET_DATA_BYTES 80  // Data bytes of packets 7-58 (group 100)
+#define OI_GROUP_COUNT       11
+
+enum OIUnit : uint8_t {
+  OI_UNIT_NONE,     // Bit field, enum or raw signal
+  OI_UNIT_MM,
+  OI_UNIT_DEGREES,
+  OI_UNIT_MV,
+  OI_UNIT_MA,
+  OI_UNIT_CELSIUS,
+  OI_UNIT_MAH,
+  OI_UNIT_MM_PER_S,
+  OI_UNIT_COUNTS
+};
+
+struct OIPacketInfo {
+  uint8_t size;    // Data bytes
+  uint8_t offset;  // Byte offset within the group 100 layout
+  bool isSigned;
+  OIUnit unit;
+  float scale;     // raw * scale = value in unit
+};
+
+struct OIGroupInfo {
+  uint8_t id;
+  uint8_t first;
+  uint8_t last;
+};
+
+// Indexed by (packet id - OI_PACKET_FIRST)
+constexpr OIPacketInfo OI_PACKET_TABLE[OI_PACKET_COUNT] PROGMEM = {
+  {1,  0, false, OI_UNIT_NONE,     1.0f},  //  7 Bumps and wheel drops
+  {1,  1, false, OI_UNIT_NONE,     1.0f},  //  8 Wall
+  {1,  2, false, OI_UNIT_NONE,     1.0f},  //  9 Cliff left
+  {1,  3, false, OI_UNIT_NONE,     1.0f},  // 10 Cliff front left
+  {1,  4, false, OI_UNIT_NONE,     1.0f},  // 11 Cliff front right
+  {1,  5, false, OI_UNIT_NONE,     1.0f},  // 12 Cliff right
+  {1,  6, false, OI_UNIT_NONE,     1.0f},  // 13 Virtual wall
+  {1,  7, false, OI_UNIT_NONE,     1.0f},  // 14 Wheel overcurrents
+  {1,  8, false, OI_UNIT_NONE,     1.0f},  // 15 Dirt detect
+  {1,  9, false, OI_UNIT_NONE,     1.0f},  // 16 Unused
+  {1, 10, false, OI_UNIT_NONE,     1.0f},  // 17 IR opcode omni
+  {1, 11, false, OI_UNIT_NONE,     1.0f},  // 18 Buttons
+  {2, 12, true,  OI_UNIT_MM,       1.0f},  // 19 Distance
+  {2, 14, true,  OI_UNIT_DEGREES,  1.0f},  // 20 Angle
+  {1, 16, false, OI_UNIT_NONE,     1.0f},  // 21 Charging state
+  {2, 17, false, OI_UNIT_MV,       1.0f},  // 22 Voltage
+  {2, 19, true,  OI_UNIT_MA,       1.0f},  // 23 Current
+  {1, 21, true,  OI_UNIT_CELSIUS,  1.0f},  // 24 Temperature
+  {2, 22, false, OI_UNIT_MAH,      1.0f},  // 25 Battery charge
+  {2, 24, false, OI_UNIT_MAH,      1.0f},  // 26 Battery capacity
+  {2, 26, false, OI_UNIT_NONE,     1.0f},  // 27 Wall signal
+  {2, 28, false, OI_UNIT_NONE,     1.0f},  // 28 Cliff left signal
+  {2, 30, false, OI_UNIT_NONE,     1.0f},  // 29 Cliff front left signal
+  {2, 32, false, OI_UNIT_NONE,     1.0f},  // 30 Cliff front right signal
+  {2, 34, false, OI_UNIT_NONE,     1.0f},  // 31 Cliff right signal
+  {1, 36, false, OI_UNIT_NONE,     1.0f},  // 32 Unused
+  {2, 37, false, OI_UNIT_NONE,     1.0f},  // 33 Unused
+  {1, 39, false, OI_UNIT_NONE,     1.0f},  // 34 Charging sources available
+  {1, 40, false, OI_UNIT_NONE,     1.0f},  // 35 OI mode
+  {1, 41, false, OI_UNIT_NONE,     1.0f},  // 36 Song number
+  {1, 42, false, OI_UNIT_NONE,     1.0f},  // 37 Song playing
+  {1, 43, false, OI_UNIT_NONE,     1.0f},  // 38 Number of stream packets
+  {2, 44, true,  OI_UNIT_MM_PER_S, 1.0f},  // 39 Requested velocity
+  {2, 46, true,  OI_UNIT_MM,       1.0f},  // 40 Requested radius
+  {2, 48, true,  OI_UNIT_MM_PER_S, 1.0f},  // 41 Requested right velocity
+  {2, 50, true,  OI_UNIT_MM_PER_S, 1.0f},  // 42 Requested left velocity
+  {2, 52, false, OI_UNIT_COUNTS,   1.0f},  // 43 Left encoder counts
+  {2, 54, false, OI_UNIT_COUNTS,   1.0f},  // 44 Right encoder counts
+  {1, 56, false, OI_UNIT_NONE,     1.0f},  // 45 Light bumper
+  {2, 57, false, OI_UNIT_NONE,     1.0f},  // 46 Light bump left signal
+  {2, 59, false, OI_UNIT_NONE,     1.0f},  // 47 Light bump front left signal
+  {2, 61, false, OI_UNIT_NONE,     1.0f},  // 48 Light bump center left signal
+  {2, 63, false, OI_UNIT_NONE,     1.0f},  // 49 Light bump center right signal
+  {2, 65, false, OI_UNIT_NONE,     1.0f},  // 50 Light bump front right signal
+  {2, 67, false, OI_UNIT_NONE,     1.0f},  // 51 Light bump right signal
+  {1, 69, false, OI_UNIT_NONE,     1.0f},  // 52 IR opcode left
+  {1, 70, false, OI_UNIT_NONE,     1.0f},  // 53 IR opcode right
+  {2, 71, true,  OI_UNIT_MA,       1.0f},  // 54 Left motor current
+  {2, 73, true,  OI_UNIT_MA,       1.0f},  // 55 Right motor current
+  {2, 75, true,  OI_UNIT_MA,       1.0f},  // 56 Main brush motor current
+  {2, 77, true,  OI_UNIT_MA,       1.0f},  // 57 Side brush motor current
+  {1, 79, false, OI_UNIT_NONE,     1.0f}   // 58 Stasis
+};
+
+constexpr OIGroupInfo OI_GROUP_TABLE[OI_GROUP_COUNT] PROGMEM = {
+  {SENSOR_GROUP_7_26,  7,  26},
+  {SENSOR_GROUP_7_16,  7,  16},
+  {SENSOR_GROUP_17_20, 17, 20},
+  {SENSOR_GROUP_21_26, 21, 26},
+  {SENSOR_GROUP_27_34, 27, 34},
+  {SENSOR_GROUP_35_42, 35, 42},
+  {SENSOR_GROUP_7_42,  7,  42},
+  {SENSOR_GROUP_ALL,   7,  58},
+  {SENSOR_GROUP_43_58, 43, 58},
+  {SENSOR_GROUP_46_51, 46, 51},
+  {SENSOR_GROUP_54_58, 54, 58}
+};
+
+// Each packet must start where the previous one ends, ending at 80 bytes
+constexpr bool oiPacketLayoutValid(uint8_t i = 0) {
+  return i + 1 == OI_PACKET_COUNT
+    ? OI_PACKET_TABLE[i].offset + OI_PACKET_TABLE[i].size == OI_PACKET_DATA_BYTES
+    : OI_PACKET_TABLE[i].offset + OI_PACKET_TABLE[i].size == OI_PACKET_TABLE[i + 1].offset &&
+      oiPacketLayoutValid(i + 1);
+}
+static_assert(oiPacketLayoutValid(), "OI_PACKET_TABLE offsets do not match packet sizes");
+
+// Value type and decoder for a given data size and signedness
+template <uint8_t Size, bool Signed> struct OIPacketValue;
+
+template <> struct OIPacketValue<1, false> {
+  typedef uint8_t type;
+  static type decode(const uint8_t* data) { return data[0]; }
+};
+
+template <> struct OIPacketValue<1, true> {
+  typedef int8_t type;
+  static type decode(const uint8_t* data) { return (int8_t)data[0]; }
+};
+
+template <> struct OIPacketValue<2, false> {
+  typedef uint16_t type;
+  static type decode(const uint8_t* data) { return ((uint16_t)data[0] << 8) | data[1]; }
+};
+
+template <> struct OIPacketValue<2, true> {
+  typedef int16_t type;
+  static type decode(const uint8_t* data) { return (int16_t)(((uint16_t)data[0] << 8) | data[1]); }
+};
+
+/**
+ * Compile-time view of one single sensor packet
+ * e.g. OIPacket<SENSOR_VOLTAGE>::type is uint16_t
+ */
+template <uint8_t Id>
+struct OIPacket {
+  static_assert(Id >= OI_PACKET_FIRST && Id <= OI_PACKET_LAST,
+                "OIPacket<Id> requires a single sensor packet id (7-58)");
+
+  static constexpr uint8_t size = OI_PACKET_TABLE[Id - OI_PACKET_FIRST].size;
+  static constexpr uint8_t offset = OI_PACKET_TABLE[Id - OI_PACKET_FIRST].offset;
+  static constexpr bool isSigned = OI_PACKET_TABLE[Id - OI_PACKET_FIRST].isSigned;
+  static constexpr OIUnit unit = OI_PACKET_TABLE[Id - OI_PACKET_FIRST].unit;
+
+  typedef OIPacketValue<size, isSigned> Value;
+  typedef typename Value::type type;
+
+  static type decode(const uint8_t* data) { return Value::decode(data); }
+};
+
+template <uint8_t Id> constexpr uint8_t OIPacket<Id>::size;
+template <uint8_t Id> constexpr uint8_t OIPacket<Id>::offset;
+template <uint8_t Id> constexpr bool OIPacket<Id>::isSigned;
+template <uint8_t Id> constexpr OIUnit OIPacket<Id>::unit;
+
+// Runtime lookups over the tables above
+class RoombaPackets {
+public:
+  // Data bytes for a single or group packet, 0 if unknown
+  static uint8_t size(uint8_t packetId);
+
+  // Single packets spanned by a packet id (a single packet spans itself)
+  static bool range(uint8_t packetId, uint8_t& first, uint8_t& last);
+
+  static bool info(uint8_t packetId, OIPacketInfo& out);
+  static const char* unitName(OIUnit unit);
+
+  // snake_case name of a single packet ("voltage", "cliff_left_signal", ...),
+  // copied out of flash; returns its length, 0 if the id is not 7-58
+  static uint8_t name(uint8_t packetId, char* out, size_t outSize);
+
+  // Single packet id for a name (not NUL-terminated), 0 if unknown
+  static uint8_t idForName(const char* name, size_t length);
+};
+
+/**
+ * Decoded sensor data for packets 7-58
+ * Stored as raw bytes in the group 100 layout so any packet (or group) can be
+ * copied in with one memcpy and read back by its compile-time offset.
+ */
+struct RoombaSensorSnapshot {
+  uint8_t raw[OI_PACKET_DATA_BYTES];
+  uint64_t present;        // Bit (id - OI_PACKET_FIRST) set for each stored packet
+  unsigned long timestamp; // millis() when the data was decoded
+
+  bool has(uint8_t packetId) const;
+
+  // Store a single or group packet's raw data; returns bytes consumed, 0 if unknown
+  uint8_t apply(uint8_t packetId, const uint8_t* data);
+
+  // Any single packet decoded at runtime (sign-extended); 0 if the id is unknown
+  int32_t value(uint8_t packetId) const;
+
+  template <uint8_t Id>
+  typename OIPacket<Id>::type get() const {
+    return OIPacket<Id>::decode(raw + OIPacket<Id>::offset);
+  }
+};
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * @file RoombaRingBuffer.h
+ * @brief Lock-free single-producer, single-consumer byte ring
+ *
+ * One context pushes (a UART interrupt, a timer ISR or a driver task) while
+ * another pops (loop()); neither ever blocks. Each index is written by one
+ * side only, is no wider than the CPU can store atomically, and is published
+ * after the data it covers. Only the diagnostic overrun count is read with
+ * interrupts masked, on AVR.
+ *
+ * Size must be a power of two; one slot is kept free to tell full from empty.
+ *
+ * RoombaMailbox applies the same rules to whole records, for handing decoded
+ * commands from a driver task to loop().
+ */
+
+#ifndef ROOMBA_RING_BUFFER_H
+#define ROOMBA_RING_BUFFER_H
+
+#include <Arduino.h>
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+typedef uint8_t RoombaRingIndex;  // 8-bit loads and stores are the only atomic ones
+#else
+typedef uint16_t RoombaRingIndex;
+#endif
+
+// Order data accesses against index updates (free on AVR, needed on dual-core ESP32)
+#define ROOMBA_RING_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define ROOMBA_RING_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+
+template <uint16_t Size>
+class RoombaRingBuffer {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "ring size must be a power of two");
+  static_assert(Size - 1 <= (RoombaRingIndex)~0, "ring size too large for this CPU");
+
+public:
+  RoombaRingBuffer() : _head(0), _tail(0), _overruns(0) {}
+
+  // Producer side. Drops the byte (and counts it) when full
+  bool push(uint8_t byte) {
+    RoombaRingIndex head = _head;
+    RoombaRingIndex next = (head + 1) & MASK;
+    if (next == _tail) {
+      _overruns++;
+      return false;
+    }
+    ROOMBA_RING_ACQUIRE(); // Consumer is done with the slot
+    _data[head] = byte;
+    ROOMBA_RING_RELEASE();
+    _head = next;
+    return true;
+  }
+
+  // Room left for the producer
+  uint16_t space() const { return MASK - available(); }
+
+  // Consumer side
+  uint16_t available() const { return (RoombaRingIndex)(_head - _tail) & MASK; }
+
+  int peek() const {
+    RoombaRingIndex tail = _tail;
+    if (tail == _head) return -1;
+    ROOMBA_RING_ACQUIRE();
+    return _data[tail];
+  }
+
+  int read() {
+    RoombaRingIndex tail = _tail;
+    if (tail == _head) return -1;
+    ROOMBA_RING_ACQUIRE();
+    uint8_t byte = _data[tail];
+    ROOMBA_RING_RELEASE(); // Slot is read before the producer may reuse it
+    _tail = (tail + 1) & MASK;
+    return byte;
+  }
+
+  // Discard everything currently queued (consumer side)
+  void clear() { _tail = _head; }
+
+  static uint16_t capacity() { return MASK; }
+  // Bytes dropped while full. 16 bits take two loads on AVR, so the read
+  // masks interrupts there to keep a push from an ISR between them
+  uint16_t overruns() const {
+#if defined(__AVR__)
+    uint16_t count;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { count = _overruns; }
+    return count;
+#else
+    return _overruns;
+#endif
+  }
+
+private:
+  static const RoombaRingIndex MASK = Size - 1;
+
+  uint8_t _data[Size];
+  volatile RoombaRingIndex _head; // Written by the producer only
+  volatile RoombaRingIndex _tail; // Written by the consumer only
+  volatile uint16_t _overruns;
+};
+
+// Single-producer, single-consumer queue of fixed-size records
+template <typename T, uint8_t Size>
+class RoombaMailbox {
+  static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "mailbox size must be a power of two");
+
+public:
+  RoombaMailbox() : _head(0), _tail(0), _dropped(0) {}
+
+  // Producer side. Drops the record (and counts it) when full
+  bool post(const T& item) {
+    RoombaRingIndex head = _head;
+    RoombaRingIndex next = (head + 1) & MASK;
+    if (next == _tail) {
+      _dropped++;
+      return false;
+    }
+    ROOMBA_RING_ACQUIRE();
+    _slots[head] = item;
+    ROOMBA_RING_RELEASE();
+    _head = next;
+    return true;
+  }
+
+  // Consumer side
+  bool take(T& item) {
+    RoombaRingIndex tail = _tail;
+    if (tail == _head) return false;
+    ROOMBA_RING_ACQUIRE();
+    item = _slots[tail];
+    ROOMBA_RING_RELEASE();
+    _tail = (tail + 1) & MASK;
+    return true;
+  }
+
+  bool empty() const { return _tail == _head; }
+  uint8_t dropped() const { return _dropped; } // Records refused while full (wraps)
+
+private:
+  static const RoombaRingIndex MASK = Size - 1;
+
+  T _slots[Size];
+  volatile RoombaRingIndex _head; // Written by the producer only
+  volatile RoombaRingIndex _tail; // Written by the consumer only
+  volatile uint8_t _dropped;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * @file RoombaScheduler.cpp
+ * @brief Implementation of the command queue
+ */
+
+#include "RoombaScheduler.h"
+
+#if (ROOMBA_QUEUE_SIZE & (ROOMBA_QUEUE_SIZE - 1)) != 0 || ROOMBA_QUEUE_SIZE > 128
+#error "ROOMBA_QUEUE_SIZE must be a power of two no larger than 128"
+#endif
+
+RoombaScheduler::RoombaScheduler()
+  : _head(0), _tail(0), _timedActive(false), _deadline(0) {
+}
+
+bool RoombaScheduler::push(const RoombaScheduledCommand& cmd) {
+  if (isFull()) return false;
+
+  _queue[_head & (ROOMBA_QUEUE_SIZE - 1)] = cmd;
+  _head++;
+  return true;
+}
+
+void RoombaScheduler::replace(const RoombaScheduledCommand& cmd) {
+  clear();
+  push(cmd);
+}
+
+void RoombaScheduler::clear() {
+  _tail = _head;
+  _timedActive = false;
+}
+
+RoombaSchedulerEvent RoombaScheduler::poll(unsigned long now, RoombaScheduledCommand& next) {
+  // A timed command owns the robot until its deadline
+  if (_timedActive && (long)(now - _deadline) < 0) return SCHEDULER_IDLE;
+
+  bool expired = _timedActive;
+  _timedActive = false;
+
+  if (_head != _tail) {
+    next = _queue[_tail & (ROOMBA_QUEUE_SIZE - 1)];
+    _tail++;
+
+    if (next.duration > 0) {
+      _timedActive = true;
+      _deadline = now + next.duration;
+    }
+    return SCHEDULER_START;
+  }
+
+  return expired ? SCHEDULER_EXPIRED : SCHEDULER_IDLE;
+}
+
+bool RoombaScheduler::isMotion(RoombaAction action) {
+  switch (action) {
+    case ROOMBA_ACTION_FORWARD:
+    case ROOMBA_ACTION_BACKWARD:
+    case ROOMBA_ACTION_LEFT:
+    case ROOMBA_ACTION_RIGHT:
+    case ROOMBA_ACTION_DRIVE:
+    case ROOMBA_ACTION_DRIVE_DIRECT:
+      return true;
+    default:
+      return false;
+  }
+}
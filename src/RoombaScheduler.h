@@ -0,0 +1,78 @@
+/**
+ * @file RoombaScheduler.h
+ * @brief Fixed-capacity command queue with non-blocking timed actions
+ *
+ * Commands are queued in a ring buffer and started in order. A command with
+ * a duration holds the queue until its deadline passes; continuous commands
+ * (duration 0) are replaced by whatever is queued next. replace() drops the
+ * queue and any running deadline instead, for a newer command that should
+ * take over at once. The owner advances the queue from its tick() and never
+ * waits.
+ */
+
+#ifndef ROOMBA_SCHEDULER_H
+#define ROOMBA_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Queue capacity, must be a power of two
+#ifndef ROOMBA_QUEUE_SIZE
+#define ROOMBA_QUEUE_SIZE 8
+#endif
+
+enum RoombaAction : uint8_t {
+  ROOMBA_ACTION_NONE,
+  ROOMBA_ACTION_FORWARD,      // arg0 = speed
+  ROOMBA_ACTION_BACKWARD,     // arg0 = speed
+  ROOMBA_ACTION_LEFT,         // arg0 = speed
+  ROOMBA_ACTION_RIGHT,        // arg0 = speed
+  ROOMBA_ACTION_STOP,
+  ROOMBA_ACTION_CLEAN,
+  ROOMBA_ACTION_SPOT,
+  ROOMBA_ACTION_DOCK,
+  ROOMBA_ACTION_BEEP,
+  ROOMBA_ACTION_DRIVE,        // arg0 = velocity, arg1 = radius
+  ROOMBA_ACTION_DRIVE_DIRECT  // arg0 = right velocity, arg1 = left velocity
+};
+
+struct RoombaScheduledCommand {
+  RoombaAction action;
+  int16_t arg0;
+  int16_t arg1;
+  uint16_t duration; // ms, 0 = continuous
+};
+
+// poll() results
+enum RoombaSchedulerEvent : uint8_t {
+  SCHEDULER_IDLE,    // Nothing to do
+  SCHEDULER_START,   // Start the returned command
+  SCHEDULER_EXPIRED  // A timed command ended and nothing follows it
+};
+
+class RoombaScheduler {
+public:
+  RoombaScheduler();
+
+  bool push(const RoombaScheduledCommand& cmd);
+  void replace(const RoombaScheduledCommand& cmd); // Starts on the next poll()
+  void clear(); // Drop queued commands and any running deadline
+
+  uint8_t size() const { return (uint8_t)(_head - _tail); }
+  bool isFull() const { return size() == ROOMBA_QUEUE_SIZE; }
+  bool isBusy() const { return _timedActive || size() > 0; }
+
+  RoombaSchedulerEvent poll(unsigned long now, RoombaScheduledCommand& next);
+
+  // Drive actions (forward ... drive direct), as opposed to modes and sounds
+  static bool isMotion(RoombaAction action);
+
+private:
+  RoombaScheduledCommand _queue[ROOMBA_QUEUE_SIZE];
+  uint8_t _head; // Free-running write index
+  uint8_t _tail; // Free-running read index
+
+  bool _timedActive;
+  unsigned long _deadline;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * @file RoombaSensorCache.cpp
+ * @brief Implementation of the timestamped sensor cache
+ */
+
+#include "RoombaSensorCache.h"
+
+#define PACKET_BIT(id) ((uint64_t)1 << ((id) - OI_PACKET_FIRST))
+
+RoombaSensorCache::RoombaSensorCache() {
+  clear();
+}
+
+void RoombaSensorCache::clear() {
+  memset(&_values, 0, sizeof(_values));
+  memset(_stamps, 0, sizeof(_stamps));
+}
+
+void RoombaSensorCache::store(const RoombaSensorSnapshot& frame) {
+  if (!frame.present) return;
+
+  OIPacketInfo info;
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    if ((frame.present & PACKET_BIT(id)) && RoombaPackets::info(id, info)) {
+      memcpy(_values.raw + info.offset, frame.raw + info.offset, info.size);
+      _stamps[id - OI_PACKET_FIRST] = frame.timestamp;
+    }
+  }
+  _values.present |= frame.present;
+  _values.timestamp = frame.timestamp;
+}
+
+void RoombaSensorCache::store(uint8_t packetId, const uint8_t* data, unsigned long now) {
+  uint8_t first, last;
+  if (!_values.apply(packetId, data) || !RoombaPackets::range(packetId, first, last)) return;
+
+  for (uint8_t id = first; id <= last; id++) {
+    _stamps[id - OI_PACKET_FIRST] = now;
+  }
+  _values.timestamp = now;
+}
+
+bool RoombaSensorCache::has(uint8_t packetId) const {
+  return _values.has(packetId);
+}
+
+bool RoombaSensorCache::isFresh(uint8_t packetId, unsigned long maxAge, unsigned long now) const {
+  return has(packetId) && (now - _stamps[packetId - OI_PACKET_FIRST]) <= maxAge;
+}
+
+unsigned long RoombaSensorCache::getAge(uint8_t packetId, unsigned long now) const {
+  if (!has(packetId)) return (unsigned long)-1;
+  return now - _stamps[packetId - OI_PACKET_FIRST];
+}
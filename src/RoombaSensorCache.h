@@ -0,0 +1,38 @@
+/**
+ * @file RoombaSensorCache.h
+ * @brief Timestamped cache of the latest sensor values
+ *
+ * Merges decoded stream frames and individually polled packets into one
+ * snapshot, keeping a millis() timestamp per field so readers can decide
+ * how old a value they are willing to accept.
+ */
+
+#ifndef ROOMBA_SENSOR_CACHE_H
+#define ROOMBA_SENSOR_CACHE_H
+
+#include "RoombaStreamParser.h"
+
+class RoombaSensorCache {
+public:
+  RoombaSensorCache();
+
+  void clear();
+
+  // Merge every packet present in a decoded stream frame
+  void store(const RoombaSensorSnapshot& frame);
+
+  // Merge a single or group packet's raw data
+  void store(uint8_t packetId, const uint8_t* data, unsigned long now);
+
+  bool has(uint8_t packetId) const;
+  bool isFresh(uint8_t packetId, unsigned long maxAge, unsigned long now) const;
+  unsigned long getAge(uint8_t packetId, unsigned long now) const;
+
+  const RoombaSensorSnapshot& values() const { return _values; }
+
+private:
+  RoombaSensorSnapshot _values;
+  unsigned long _stamps[OI_PACKET_COUNT];
+};
+
+#endif
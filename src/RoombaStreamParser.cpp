@@ -0,0 +1,131 @@
+/**
+ * @file RoombaStreamParser.cpp
+ * @brief Implementation of the OI_STREAM frame parser
+ */
+
+#include "RoombaStreamParser.h"
+
+RoombaStreamParser::RoombaStreamParser() {
+  reset();
+  resetStats();
+}
+
+void RoombaStreamParser::reset() {
+  _state = WAIT_HEADER;
+  _count = 0;
+  _frameLength = 0;
+}
+
+void RoombaStreamParser::resetStats() {
+  _stats.goodFrames = 0;
+  _stats.badFrames = 0;
+  _stats.resyncs = 0;
+  _stats.droppedBytes = 0;
+}
+
+bool RoombaStreamParser::feed(uint8_t byte) {
+  StepResult result = step(byte);
+  bool complete = (result == STEP_FRAME);
+
+  // A rejected frame may still contain the start of the next one: rescan the
+  // buffered bytes for a header and replay everything after it. Writes into
+  // _buf always trail the replay position, so this works in place.
+  while (result == STEP_FAIL) {
+    _stats.resyncs++;
+
+    uint8_t pending = _count;
+    uint8_t start = 0;
+    while (start < pending && _buf[start] != OI_STREAM_HEADER) start++;
+
+    _stats.droppedBytes += start + 1; // Skipped bytes plus the false header
+    _state = WAIT_HEADER;
+    _count = 0;
+    if (start >= pending) break;
+
+    step(_buf[start]);
+    result = STEP_NONE;
+    for (uint8_t i = start + 1; i < pending; i++) {
+      result = step(_buf[i]);
+      if (result == STEP_FRAME) {
+        complete = true;
+      } else if (result == STEP_FAIL) {
+        // Append the not-yet-replayed tail to the rejected bytes and rescan
+        uint8_t rest = pending - i - 1;
+        memmove(_buf + _count, _buf + i + 1, rest);
+        _count += rest;
+        break;
+      }
+    }
+  }
+
+  return complete;
+}
+
+RoombaStreamParser::StepResult RoombaStreamParser::step(uint8_t byte) {
+  switch (_state) {
+    case WAIT_HEADER:
+      if (byte == OI_STREAM_HEADER) {
+        _state = WAIT_LENGTH;
+        _count = 0;
+      } else {
+        _stats.droppedBytes++;
+      }
+      return STEP_NONE;
+
+    case WAIT_LENGTH:
+      _buf[_count++] = byte;
+      if (byte == 0 || byte > OI_STREAM_MAX_PAYLOAD) {
+        _stats.badFrames++;
+        return STEP_FAIL;
+      }
+      _state = PAYLOAD;
+      return STEP_NONE;
+
+    case PAYLOAD:
+      _buf[_count++] = byte;
+      if (_count > _buf[0]) _state = CHECKSUM;
+      return STEP_NONE;
+
+    case CHECKSUM: {
+      _buf[_count++] = byte;
+
+      // Header, length, payload and checksum must sum to zero
+      uint8_t sum = OI_STREAM_HEADER;
+      for (uint8_t i = 0; i < _count; i++) sum += _buf[i];
+
+      uint8_t length = _buf[0];
+      if (sum != 0 || !validLayout(_buf + 1, length)) {
+        _stats.badFrames++;
+        return STEP_FAIL;
+      }
+
+      memcpy(_frame, _buf + 1, length);
+      _frameLength = length;
+      _stats.goodFrames++;
+      _state = WAIT_HEADER;
+      _count = 0;
+      return STEP_FRAME;
+    }
+  }
+  return STEP_NONE;
+}
+
+bool RoombaStreamParser::validLayout(const uint8_t* payload, uint8_t length) const {
+  uint8_t i = 0;
+  while (i < length) {
+    uint8_t size = RoombaPackets::size(payload[i]);
+    if (size == 0) return false;
+    i += 1 + size;
+  }
+  return i == length;
+}
+
+void RoombaStreamParser::decode(RoombaSensorSnapshot& snapshot) const {
+  snapshot.present = 0;
+
+  uint8_t i = 0;
+  while (i < _frameLength) {
+    uint8_t id = _frame[i++];
+    i += snapshot.apply(id, _frame + i);
+  }
+}
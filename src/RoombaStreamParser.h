@@ -0,0 +1,79 @@
+/**
+ * @file RoombaStreamParser.h
+ * @brief Incremental parser for OI_STREAM sensor frames
+ *
+ * Consumes stream bytes one at a time and never blocks. Frames are checked
+ * for length, packet layout and checksum; on any mismatch the parser rescans
+ * the rejected bytes for the next header so a single corrupted byte costs at
+ * most one frame.
+ *
+ * Frame layout: [19][n][id][data...][id][data...]...[checksum]
+ */
+
+#ifndef ROOMBA_STREAM_PARSER_H
+#define ROOMBA_STREAM_PARSER_H
+
+#include "RoombaPackets.h"
+
+#define OI_STREAM_HEADER 19
+
+// Largest payload (n) accepted; larger length bytes are treated as noise
+#ifndef OI_STREAM_MAX_PAYLOAD
+#define OI_STREAM_MAX_PAYLOAD 64
+#endif
+
+// Frame counters
+struct RoombaStreamStats {
+  uint32_t goodFrames;   // Frames that passed length, layout and checksum
+  uint32_t badFrames;    // Frames rejected after the header was seen
+  uint32_t resyncs;      // Rescans of rejected bytes for a new header
+  uint32_t droppedBytes; // Bytes discarded while hunting for a header
+};
+
+class RoombaStreamParser {
+public:
+  RoombaStreamParser();
+
+  void reset();
+
+  // Feed one received byte; returns true if a valid frame completed
+  bool feed(uint8_t byte);
+
+  // Last valid frame payload (packet ids and data, no header/length/checksum)
+  const uint8_t* getFrame() const { return _frame; }
+  uint8_t getFrameLength() const { return _frameLength; }
+
+  // Decode the last valid frame into a typed snapshot (present = packets in this frame)
+  void decode(RoombaSensorSnapshot& snapshot) const;
+
+  const RoombaStreamStats& getStats() const { return _stats; }
+  void resetStats();
+
+private:
+  enum State : uint8_t {
+    WAIT_HEADER,
+    WAIT_LENGTH,
+    PAYLOAD,
+    CHECKSUM
+  };
+
+  enum StepResult : uint8_t {
+    STEP_NONE,
+    STEP_FRAME,
+    STEP_FAIL
+  };
+
+  State _state;
+  uint8_t _count;  // Bytes buffered since the header (length, payload, checksum)
+  uint8_t _buf[OI_STREAM_MAX_PAYLOAD + 2];
+
+  uint8_t _frame[OI_STREAM_MAX_PAYLOAD];
+  uint8_t _frameLength;
+
+  RoombaStreamStats _stats;
+
+  StepResult step(uint8_t byte);
+  bool validLayout(const uint8_t* payload, uint8_t length) const;
+};
+
+#endif
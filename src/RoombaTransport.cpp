@@ -0,0 +1,64 @@
+/**
+ * @file RoombaTransport.cpp
+ * @brief Implementation of the hardware UART transport
+ */
+
+#include "RoombaTransport.h"
+
+RoombaUartTransport::RoombaUartTransport(HardwareSerial& serial)
+  : _serial(serial), _external(false) {
+#ifdef ESP32
+  _rxPin = -1;
+  _txPin = -1;
+#endif
+}
+
+#ifdef ESP32
+RoombaUartTransport::RoombaUartTransport(HardwareSerial& serial, int8_t rxPin, int8_t txPin)
+  : _serial(serial), _external(false), _rxPin(rxPin), _txPin(txPin) {
+}
+#endif
+
+void RoombaUartTransport::begin(uint32_t baudRate) {
+  _rx.clear();
+#ifdef ESP32
+  // Driver buffer to match, filled by the UART task; it hands bytes over
+  // through the receive callback, so loop() only ever reads the ring
+  _serial.setRxBufferSize(ROOMBA_RX_BUFFER_SIZE);
+  _serial.begin(baudRate, SERIAL_8N1, _rxPin, _txPin);
+  _serial.onReceive([this]() { service(); });
+  _external = true;
+#else
+  _serial.begin(baudRate);
+#endif
+}
+
+void RoombaUartTransport::end() {
+#ifdef ESP32
+  _serial.onReceive(nullptr);
+  _external = false;
+#endif
+  _serial.end();
+}
+
+void RoombaUartTransport::service() {
+  // Like a UART FIFO, bytes that find the ring full are dropped and counted
+  while (_serial.available() > 0) {
+    _rx.push((uint8_t)_serial.read());
+  }
+}
+
+int RoombaUartTransport::available() {
+  if (!_external) service();
+  return _rx.available();
+}
+
+int RoombaUartTransport::read() {
+  if (!_external && _rx.available() == 0) service();
+  return _rx.read();
+}
+
+int RoombaUartTransport::peek() {
+  if (!_external && _rx.available() == 0) service();
+  return _rx.peek();
+}
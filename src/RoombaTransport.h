@@ -0,0 +1,108 @@
+/**
+ * @file RoombaTransport.h
+ * @brief Serial ports RoombaOI can own: open, close, read, write
+ *
+ * A RoombaTransport is a Stream that also knows how to open its port at a
+ * given baud rate, so RoombaOI::begin() can bring it up. Pass one to
+ * RoombaOI(RoombaTransport&, brcPin) or ArduRoomba(RoombaTransport&, brcPin):
+ *
+ *  - RoombaSoftwareSerialTransport: SoftwareSerial on any two pins (the
+ *    default on boards without a spare UART; reliable to about 19200 baud).
+ *  - RoombaUartTransport: a hardware UART (Serial1 on the Uno R4 and Mega,
+ *    UART1 on ESP32) with a ROOMBA_RX_BUFFER_SIZE receive ring, for 115200
+ *    baud and long sensor streams. The ring fills in the background on
+ *    ESP32 only; see the class comment.
+ */
+
+#ifndef ROOMBA_TRANSPORT_H
+#define ROOMBA_TRANSPORT_H
+
+#include <Arduino.h>
+
+#if defined(ESP32) || defined(ARDUROOMBA_HOST)
+  #include <HardwareSerial.h>
+#endif
+#ifndef ESP32
+  #include <SoftwareSerial.h>
+#endif
+
+#include "RoombaRingBuffer.h"
+
+// Receive ring for RoombaUartTransport, a power of two (at most 256 on AVR)
+#ifndef ROOMBA_RX_BUFFER_SIZE
+#define ROOMBA_RX_BUFFER_SIZE 256
+#endif
+
+class RoombaTransport : public Stream {
+public:
+  virtual void begin(uint32_t baudRate) = 0;
+  virtual void end() = 0;
+};
+
+#ifndef ESP32
+class RoombaSoftwareSerialTransport : public RoombaTransport {
+public:
+  RoombaSoftwareSerialTransport(uint8_t rxPin, uint8_t txPin) : _serial(rxPin, txPin) {}
+
+  void begin(uint32_t baudRate) { _serial.begin(baudRate); }
+  void end() { _serial.end(); }
+
+  int available() { return _serial.available(); }
+  int read() { return _serial.read(); }
+  int peek() { return _serial.peek(); }
+  void flush() { _serial.flush(); }
+  size_t write(uint8_t byte) { return _serial.write(byte); }
+  size_t write(const uint8_t* buffer, size_t size) { return _serial.write(buffer, size); }
+  using Print::write;
+
+private:
+  SoftwareSerial _serial;
+};
+#endif
+
+/**
+ * Hardware UART with a lock-free receive ring
+ *
+ * service() moves whatever the UART driver has buffered into the ring and is
+ * the ring's only producer. Only on ESP32 is the ring filled in the
+ * background, by the driver's receive callback. On AVR and Renesas the core
+ * fills its own RX buffer from the UART interrupt, and available() and read()
+ * copy it into the ring on demand; between loop() passes that core buffer
+ * (64 bytes on AVR) is all that absorbs incoming bytes, and its overflows are
+ * not counted by getOverruns(). A sketch that cannot reach loop() often
+ * enough calls service() from a timer interrupt after
+ * setServicedExternally(true), which makes the ring the buffer that counts.
+ */
+class RoombaUartTransport : public RoombaTransport {
+public:
+  explicit RoombaUartTransport(HardwareSerial& serial);
+#ifdef ESP32
+  RoombaUartTransport(HardwareSerial& serial, int8_t rxPin, int8_t txPin);
+#endif
+
+  void begin(uint32_t baudRate);
+  void end();
+
+  void service();
+  void setServicedExternally(bool enable) { _external = enable; }
+
+  int available();
+  int read();
+  int peek();
+  void flush() { _serial.flush(); }
+  size_t write(uint8_t byte) { return _serial.write(byte); }
+  size_t write(const uint8_t* buffer, size_t size) { return _serial.write(buffer, size); }
+  using Print::write;
+
+  uint16_t getOverruns() const { return _rx.overruns(); } // Bytes the ring dropped
+
+private:
+  HardwareSerial& _serial;
+  RoombaRingBuffer<ROOMBA_RX_BUFFER_SIZE> _rx;
+  bool _external;
+#ifdef ESP32
+  int8_t _rxPin, _txPin;
+#endif
+};
+
+#endif
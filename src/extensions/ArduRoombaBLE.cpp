@@ -4,6 +4,7 @@
  */
 
 #include "ArduRoombaBLE.h"
+#include "../RoombaMetrics.h"
 
 #if defined(ESP32)
 
@@ -21,6 +22,8 @@ public:
 
   void onDisconnect(BLEServer* server) {
     _parent->_deviceConnected = false;
+    _parent->_binaryStatus = false;
+    _parent->_haveSequence = false;
     Serial.println("BLE Client disconnected");
 
     // Restart advertising
@@ -37,11 +40,17 @@ public:
   CommandCallbacks(ArduRoombaBLE* parent) : _parent(parent) {}
 
   void onWrite(BLECharacteristic* characteristic) {
-    String value = characteristic->getValue().c_str();
-    if (value.length() > 0) {
+    ROOMBA_TRACE(METRIC_BLE_COMMAND);
+    // Read the value in place; no String copy
+    const char* value = (const char*)characteristic->getData();
+    size_t length = characteristic->getLength();
+    if (RoombaBinaryProtocol::isBinary((const uint8_t*)value, length)) {
+      _parent->processBinaryCommand((const uint8_t*)value, length);
+    } else if (value && length > 0) {
       Serial.print("Received BLE command: ");
-      Serial.println(value);
-      _parent->processCommand(value);
+      Serial.write((const uint8_t*)value, length);
+      Serial.println();
+      _parent->processCommand(value, length);
     }
   }
 };
@@ -49,8 +58,11 @@ public:
 ArduRoombaBLE::ArduRoombaBLE(ArduRoomba& roomba, const char* deviceName)
   : _roomba(roomba), _deviceName(deviceName), _remoteEnabled(true),
     _deviceConnected(false), _oldDeviceConnected(false), _connectionCount(0),
-    _commandCallback(nullptr), _server(nullptr), _service(nullptr),
-    _commandChar(nullptr), _statusChar(nullptr), _lastStatusUpdate(0) {
+    _commandCallback(nullptr), _binaryStatus(false), _haveSequence(false), _lastSequence(0),
+    _server(nullptr), _service(nullptr), _commandChar(nullptr), _statusChar(nullptr),
+    _healthChar(nullptr), _lastStatusUpdate(0), _lastStatusPoll(0), _lastHealthUpdate(0), _statusInterval(BLE_STATUS_MIN_INTERVAL),
+    _heartbeatInterval(BLE_STATUS_HEARTBEAT), _voltageThreshold(BLE_STATUS_VOLTAGE_THRESHOLD),
+    _statusValid(false) {
 }
 
 ArduRoombaBLE::~ArduRoombaBLE() {
@@ -70,10 +82,11 @@ bool ArduRoombaBLE::begin() {
   // Create BLE Service
   _service = _server->createService(SERVICE_UUID);
 
-  // Create Command Characteristic (Write)
+  // Create Command Characteristic (Write, and Write Without Response for
+  // high-rate binary drive frames)
   _commandChar = _service->createCharacteristic(
     COMMAND_CHAR_UUID,
-    BLECharacteristic::PROPERTY_WRITE
+    BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_WRITE_NR
   );
   _commandChar->setCallbacks(new CommandCallbacks(this));
 
@@ -85,8 +98,18 @@ bool ArduRoombaBLE::begin() {
   _statusChar->addDescriptor(new BLE2902());
 
   // Set initial status
-  String status = generateStatus();
-  _statusChar->setValue(status.c_str());
+  RoombaBinaryStatus status;
+  readStatus(status);
+  char text[32];
+  size_t length = generateStatus(status, text, sizeof(text));
+  _statusChar->setValue((uint8_t*)text, length);
+
+  // Create Link Health Characteristic (Read)
+  _healthChar = _service->createCharacteristic(
+    HEALTH_CHAR_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  publishHealth();
 
   // Start the service
   _service->start();
@@ -114,111 +137,158 @@ void ArduRoombaBLE::end() {
     _service = nullptr;
     _commandChar = nullptr;
     _statusChar = nullptr;
+    _healthChar = nullptr;
   }
 }
 
 void ArduRoombaBLE::updateStatus() {
+  applyCommands();
+
   // Handle connection state changes
   if (_deviceConnected && !_oldDeviceConnected) {
     _oldDeviceConnected = _deviceConnected;
+    _statusValid = false; // Send current state to the new client
   }
 
   if (!_deviceConnected && _oldDeviceConnected) {
     _oldDeviceConnected = _deviceConnected;
   }
 
-  // Periodically update status characteristic
-  if (_deviceConnected && (millis() - _lastStatusUpdate > STATUS_UPDATE_INTERVAL)) {
-    String status = generateStatus();
-    _statusChar->setValue(status.c_str());
-    _statusChar->notify();
-    _lastStatusUpdate = millis();
+  if (!_deviceConnected) return;
+  ROOMBA_TRACE(METRIC_BLE_STATUS);
+
+  unsigned long now = millis();
+
+  // The stream keeps the cache current; otherwise refresh it with one query
+  if (!_roomba.isStreaming() && now - _lastStatusPoll >= _statusInterval) {
+    _roomba.refreshSensors(RoombaBinaryProtocol::STATUS_PACKETS, ROOMBA_STATUS_PACKET_COUNT);
+    _lastStatusPoll = now;
   }
+
+  RoombaBinaryStatus status;
+  readStatus(status);
+
+  bool edge = !_statusValid || status.flags != _lastStatus.flags;
+  int32_t voltageDelta = (int32_t)status.voltage - _lastStatus.voltage;
+  bool moved = voltageDelta > _voltageThreshold || -voltageDelta > _voltageThreshold;
+  unsigned long elapsed = now - _lastStatusUpdate;
+
+  if (edge || (moved && elapsed >= _statusInterval) || elapsed >= _heartbeatInterval) {
+    publishStatus(status);
+    _lastStatus = status;
+    _statusValid = true;
+    _lastStatusUpdate = now;
+  }
+
+  if (now - _lastHealthUpdate >= BLE_HEALTH_INTERVAL) {
+    publishHealth();
+    _lastHealthUpdate = now;
+  }
+}
+
+void ArduRoombaBLE::publishHealth() {
+  char text[BLE_HEALTH_MAX];
+  RoombaBufferPrint out(text, sizeof(text));
+  RoombaJsonWriter json(out);
+  RoombaLinkSnapshot link;
+  link.capture(_roomba);
+  json.beginObject();
+  writeLinkHealthFields(json, link);
+  json.endObject();
+  json.finish();
+  _healthChar->setValue((uint8_t*)text, out.length());
+}
+
+void ArduRoombaBLE::publishStatus(const RoombaBinaryStatus& status) {
+  if (_binaryStatus) {
+    uint8_t frame[ROOMBA_BINARY_STATUS_SIZE];
+    size_t length = RoombaBinaryProtocol::encodeStatus(status, frame, sizeof(frame));
+    _statusChar->setValue(frame, length);
+  } else {
+    char text[32];
+    size_t length = generateStatus(status, text, sizeof(text));
+    _statusChar->setValue((uint8_t*)text, length);
+  }
+  _statusChar->notify();
 }
 
 void ArduRoombaBLE::setCommandCallback(void (*callback)(const String&)) {
   _commandCallback = callback;
 }
 
-void ArduRoombaBLE::processCommand(const String& command) {
+void ArduRoombaBLE::processCommand(const char* command, size_t length) {
   if (!_remoteEnabled) {
     Serial.println("Remote control disabled");
     return;
   }
 
-  // Call user callback if set
+  // Call user callback if set (only then is a String built)
   if (_commandCallback) {
-    _commandCallback(command);
+    char text[32];
+    size_t n = length < sizeof(text) - 1 ? length : sizeof(text) - 1;
+    memcpy(text, command, n);
+    text[n] = '\0';
+    _commandCallback(String(text));
   }
 
   // Parse command format: "ACTION:SPEED:DURATION"
   // Examples: "forward:200:0", "left:150:1000", "stop:0:0"
-  int firstColon = command.indexOf(':');
-  int secondColon = command.indexOf(':', firstColon + 1);
-
-  String action = command.substring(0, firstColon);
-  int speed = 200;
-  int duration = 0;
-
-  if (firstColon > 0) {
-    if (secondColon > firstColon) {
-      speed = command.substring(firstColon + 1, secondColon).toInt();
-      duration = command.substring(secondColon + 1).toInt();
-    } else {
-      speed = command.substring(firstColon + 1).toInt();
-    }
+  RoombaCommand cmd;
+  if (!RoombaCommandParser::parseCommand(command, length, cmd)) return;
+
+  // Same mapping as RoombaCommandParser::dispatch(), applied later from loop()
+  RoombaBinaryCommand queued = { 0, RoombaCommandParser::actionFromName(cmd.action), 0, 0, 0 };
+  switch (queued.action) {
+    case ROOMBA_ACTION_NONE:
+    case ROOMBA_ACTION_DRIVE:
+    case ROOMBA_ACTION_DRIVE_DIRECT:
+      return;
+    case ROOMBA_ACTION_STOP:
+      break;
+    default:
+      queued.arg0 = cmd.speed;
+      queued.duration = cmd.duration > 0 ? cmd.duration : 0; // Timed commands expire from tick()
+      break;
   }
+  if (!_commands.post(queued)) Serial.println("BLE command dropped: mailbox full");
+}
 
-  // Process commands
-  if (action == "forward") {
-    _roomba.moveForward(speed);
-  }
-  else if (action == "backward") {
-    _roomba.moveBackward(speed);
-  }
-  else if (action == "left") {
-    _roomba.turnLeft(speed);
-  }
-  else if (action == "right") {
-    _roomba.turnRight(speed);
-  }
-  else if (action == "stop") {
-    _roomba.stop();
-  }
-  else if (action == "clean") {
-    _roomba.startCleaning();
-  }
-  else if (action == "spot") {
-    _roomba.spotClean();
-  }
-  else if (action == "dock") {
-    _roomba.dock();
-  }
-  else if (action == "beep") {
-    _roomba.beep();
-  }
+void ArduRoombaBLE::processBinaryCommand(const uint8_t* data, size_t length) {
+  if (!_remoteEnabled) return;
 
-  // Handle timed commands
-  if (duration > 0 && action != "stop") {
-    delay(duration);
-    _roomba.stop();
-  }
+  RoombaBinaryCommand cmd;
+  if (!RoombaBinaryProtocol::decodeCommand(data, length, cmd)) return;
+
+  // Drop retransmitted or stale frames
+  if (_haveSequence && !RoombaBinaryProtocol::isNewer(cmd.sequence, _lastSequence)) return;
+  _haveSequence = true;
+  _lastSequence = cmd.sequence;
+  _binaryStatus = true;
+
+  if (!_commands.post(cmd)) Serial.println("BLE command dropped: mailbox full");
 }
 
-String ArduRoombaBLE::generateStatus() {
-  uint16_t voltage = _roomba.getBatteryVoltage();
-  bool connected = _roomba.isConnected();
-  bool wall = _roomba.isWallDetected();
-  bool bumper = _roomba.isBumperPressed();
+void ArduRoombaBLE::applyCommands() {
+  _commands.apply(_roomba);
+}
 
-  // Format: "voltage:connected:wall:bumper:remote"
-  String status = String(voltage) + ":";
-  status += (connected ? "1" : "0") + String(":");
-  status += (wall ? "1" : "0") + String(":");
-  status += (bumper ? "1" : "0") + String(":");
-  status += (_remoteEnabled ? "1" : "0");
+void ArduRoombaBLE::readStatus(RoombaBinaryStatus& status) {
+  // Cache only: no serial traffic here
+  RoombaBinaryProtocol::readStatus(_roomba, status);
+  status.sequence = _lastSequence;
+  if (_remoteEnabled) status.flags |= BINARY_STATUS_REMOTE;
+}
 
-  return status;
+size_t ArduRoombaBLE::generateStatus(const RoombaBinaryStatus& status, char* out, size_t outSize) {
+  // Format: "voltage:connected:wall:bumper:remote"
+  int n = snprintf(out, outSize, "%u:%d:%d:%d:%d",
+                   (unsigned)status.voltage,
+                   (status.flags & BINARY_STATUS_CONNECTED) ? 1 : 0,
+                   (status.flags & BINARY_STATUS_WALL) ? 1 : 0,
+                   (status.flags & BINARY_STATUS_BUMPER) ? 1 : 0,
+                   (status.flags & BINARY_STATUS_REMOTE) ? 1 : 0);
+  if (n < 0) return 0;
+  return (size_t)n < outSize ? (size_t)n : outSize - 1;
 }
 
 #endif // ESP32
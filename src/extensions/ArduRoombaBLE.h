@@ -9,12 +9,32 @@
  * BLE Service UUID: 4fafc201-1fb5-459e-8fcc-c5c9c331914b
  * Command Characteristic: beb5483e-36e1-4688-b7f5-ea07361b26a8 (Write)
  * Status Characteristic: beb5483f-36e1-4688-b7f5-ea07361b26a8 (Read/Notify)
+ * Link Health Characteristic: beb54840-36e1-4688-b7f5-ea07361b26a8 (Read)
+ *
+ * Commands are ASCII ("forward:200:0") or binary frames (ArduRoombaBinary.h).
+ * Writes arrive in the BLE stack's task, so they are only decoded there and
+ * posted to a mailbox; updateStatus() applies them from loop(), where tick()
+ * also runs. STOP skips the mailbox queue, so a backlog never delays or
+ * drops it. The command callback is the exception: it is called from the
+ * BLE task and must not touch the ArduRoomba object.
+ * After a client sends its first binary frame, status is sent as the packed
+ * binary struct until it disconnects.
+ *
+ * Status notifications are change-driven and read from the sensor cache:
+ * bumper/wall/busy edges notify immediately, voltage only after moving by
+ * more than the threshold (rate limited), and a heartbeat is sent when idle.
+ *
+ * The link health characteristic holds the same link_* JSON object as
+ * /status?fields=link, refreshed every BLE_HEALTH_INTERVAL while connected.
  */
 
 #ifndef ARDUROOMBA_BLE_H
 #define ARDUROOMBA_BLE_H
 
 #include "../ArduRoomba.h"
+#include "ArduRoombaCommand.h"
+#include "ArduRoombaBinary.h"
+#include "ArduRoombaJson.h"
 
 // Only compile for ESP32
 #if defined(ESP32)
@@ -24,10 +44,33 @@
 #include <BLEUtils.h>
 #include <BLE2902.h>
 
+#ifndef BLE_STATUS_MIN_INTERVAL
+#define BLE_STATUS_MIN_INTERVAL 100      // ms between threshold-driven notifications
+#endif
+
+#ifndef BLE_STATUS_HEARTBEAT
+#define BLE_STATUS_HEARTBEAT 2000        // ms between notifications when nothing changes
+#endif
+
+#ifndef BLE_STATUS_VOLTAGE_THRESHOLD
+#define BLE_STATUS_VOLTAGE_THRESHOLD 50  // mV
+#endif
+
+#ifndef BLE_HEALTH_INTERVAL
+#define BLE_HEALTH_INTERVAL 1000         // ms between link health refreshes
+#endif
+
+#ifndef BLE_COMMAND_MAILBOX
+#define BLE_COMMAND_MAILBOX 8            // Commands waiting for loop() (power of two)
+#endif
+
+#define BLE_HEALTH_MAX 512               // Longest link health value (one ATT read)
+
 // BLE UUIDs
 #define SERVICE_UUID        "4fafc201-1fb5-459e-8fcc-c5c9c331914b"
 #define COMMAND_CHAR_UUID   "beb5483e-36e1-4688-b7f5-ea07361b26a8"
 #define STATUS_CHAR_UUID    "beb5483f-36e1-4688-b7f5-ea07361b26a8"
+#define HEALTH_CHAR_UUID    "beb54840-36e1-4688-b7f5-ea07361b26a8"
 
 /**
  * BLE extension for ESP32 Roomba control
@@ -46,16 +89,28 @@ public:
   bool isConnected() const { return _deviceConnected; }
   int getConnectionCount() const { return _connectionCount; }
 
-  // Update status (call in loop to send notifications)
+  // Apply received commands and send notifications (call in loop after roomba.tick())
   void updateStatus();
 
-  // Command callback
+  // Commands dropped because loop() fell behind (wraps at 256; never STOP)
+  uint8_t getDroppedCommands() const { return _commands.dropped(); }
+
+  // Notification tuning
+  void setStatusInterval(uint16_t minInterval) { _statusInterval = minInterval; }
+  void setHeartbeatInterval(uint16_t interval) { _heartbeatInterval = interval; }
+  void setVoltageThreshold(uint16_t millivolts) { _voltageThreshold = millivolts; }
+
+  // Command callback (runs in the BLE task)
   void setCommandCallback(void (*callback)(const String&));
 
   // Enable/disable remote control
   void enableRemoteControl(bool enable) { _remoteEnabled = enable; }
   bool isRemoteEnabled() const { return _remoteEnabled; }
 
+  // Binary status notifications (set automatically by binary commands)
+  void setBinaryStatus(bool enable) { _binaryStatus = enable; }
+  bool isBinaryStatus() const { return _binaryStatus; }
+
 private:
   ArduRoomba& _roomba;
   String _deviceName;
@@ -65,16 +120,35 @@ private:
   int _connectionCount;
   void (*_commandCallback)(const String&);
 
+  bool _binaryStatus;
+  bool _haveSequence;
+  uint8_t _lastSequence;
+
   BLEServer* _server;
   BLEService* _service;
   BLECharacteristic* _commandChar;
   BLECharacteristic* _statusChar;
+  BLECharacteristic* _healthChar;
 
   unsigned long _lastStatusUpdate;
-  static const unsigned long STATUS_UPDATE_INTERVAL = 2000; // 2 seconds
-
-  void processCommand(const String& command);
-  String generateStatus();
+  unsigned long _lastStatusPoll;
+  unsigned long _lastHealthUpdate;
+  uint16_t _statusInterval;
+  uint16_t _heartbeatInterval;
+  uint16_t _voltageThreshold;
+  RoombaBinaryStatus _lastStatus; // Last notified values
+  bool _statusValid;
+
+  // Written by the BLE task, read by loop()
+  RoombaCommandMailbox<BLE_COMMAND_MAILBOX> _commands;
+
+  void processCommand(const char* command, size_t length);
+  void processBinaryCommand(const uint8_t* data, size_t length);
+  void applyCommands();
+  void readStatus(RoombaBinaryStatus& status);
+  size_t generateStatus(const RoombaBinaryStatus& status, char* out, size_t outSize);
+  void publishStatus(const RoombaBinaryStatus& status);
+  void publishHealth();
 
   // BLE callback classes
   class ServerCallbacks;
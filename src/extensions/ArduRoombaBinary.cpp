@@ -0,0 +1,100 @@
+/**
+ * @file ArduRoombaBinary.cpp
+ * @brief Implementation of the binary command/status framing
+ */
+
+#include "ArduRoombaBinary.h"
+
+const uint8_t RoombaBinaryProtocol::STATUS_PACKETS[ROOMBA_STATUS_PACKET_COUNT] = {
+  SENSOR_BUMPS_DROPS, SENSOR_WALL, SENSOR_VOLTAGE, SENSOR_CURRENT
+};
+
+static void putU16(uint8_t* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = (value >> 8) & 0xFF;
+}
+
+static uint16_t getU16(const uint8_t* data) {
+  return (uint16_t)data[0] | ((uint16_t)data[1] << 8);
+}
+
+static RoombaAction actionForOpcode(uint8_t opcode) {
+  switch (opcode) {
+    case BINARY_OP_STOP:         return ROOMBA_ACTION_STOP;
+    case BINARY_OP_DRIVE:        return ROOMBA_ACTION_DRIVE;
+    case BINARY_OP_DRIVE_DIRECT: return ROOMBA_ACTION_DRIVE_DIRECT;
+    case BINARY_OP_FORWARD:      return ROOMBA_ACTION_FORWARD;
+    case BINARY_OP_BACKWARD:     return ROOMBA_ACTION_BACKWARD;
+    case BINARY_OP_LEFT:         return ROOMBA_ACTION_LEFT;
+    case BINARY_OP_RIGHT:        return ROOMBA_ACTION_RIGHT;
+    case BINARY_OP_CLEAN:        return ROOMBA_ACTION_CLEAN;
+    case BINARY_OP_SPOT:         return ROOMBA_ACTION_SPOT;
+    case BINARY_OP_DOCK:         return ROOMBA_ACTION_DOCK;
+    case BINARY_OP_BEEP:         return ROOMBA_ACTION_BEEP;
+    default:                     return ROOMBA_ACTION_NONE;
+  }
+}
+
+static uint8_t opcodeForAction(RoombaAction action) {
+  switch (action) {
+    case ROOMBA_ACTION_DRIVE:        return BINARY_OP_DRIVE;
+    case ROOMBA_ACTION_DRIVE_DIRECT: return BINARY_OP_DRIVE_DIRECT;
+    case ROOMBA_ACTION_FORWARD:      return BINARY_OP_FORWARD;
+    case ROOMBA_ACTION_BACKWARD:     return BINARY_OP_BACKWARD;
+    case ROOMBA_ACTION_LEFT:         return BINARY_OP_LEFT;
+    case ROOMBA_ACTION_RIGHT:        return BINARY_OP_RIGHT;
+    case ROOMBA_ACTION_CLEAN:        return BINARY_OP_CLEAN;
+    case ROOMBA_ACTION_SPOT:         return BINARY_OP_SPOT;
+    case ROOMBA_ACTION_DOCK:         return BINARY_OP_DOCK;
+    case ROOMBA_ACTION_BEEP:         return BINARY_OP_BEEP;
+    default:                         return BINARY_OP_STOP;
+  }
+}
+
+bool RoombaBinaryProtocol::decodeCommand(const uint8_t* data, size_t length, RoombaBinaryCommand& cmd) {
+  if (length < ROOMBA_BINARY_COMMAND_SIZE || data[0] != (ROOMBA_BINARY_MARKER | ROOMBA_BINARY_VERSION)) {
+    return false;
+  }
+
+  cmd.sequence = data[1];
+  cmd.action = actionForOpcode(data[2]);
+  cmd.arg0 = (int16_t)getU16(data + 3);
+  cmd.arg1 = (int16_t)getU16(data + 5);
+  cmd.duration = getU16(data + 7);
+  return cmd.action != ROOMBA_ACTION_NONE;
+}
+
+size_t RoombaBinaryProtocol::encodeCommand(const RoombaBinaryCommand& cmd, uint8_t* out, size_t outSize) {
+  if (!out || outSize < ROOMBA_BINARY_COMMAND_SIZE) return 0;
+
+  out[0] = ROOMBA_BINARY_MARKER | ROOMBA_BINARY_VERSION;
+  out[1] = cmd.sequence;
+  out[2] = opcodeForAction(cmd.action);
+  putU16(out + 3, (uint16_t)cmd.arg0);
+  putU16(out + 5, (uint16_t)cmd.arg1);
+  putU16(out + 7, cmd.duration);
+  return ROOMBA_BINARY_COMMAND_SIZE;
+}
+
+size_t RoombaBinaryProtocol::encodeStatus(const RoombaBinaryStatus& status, uint8_t* out, size_t outSize) {
+  if (!out || outSize < ROOMBA_BINARY_STATUS_SIZE) return 0;
+
+  out[0] = ROOMBA_BINARY_MARKER | ROOMBA_BINARY_VERSION;
+  out[1] = status.sequence;
+  putU16(out + 2, status.voltage);
+  putU16(out + 4, (uint16_t)status.current);
+  out[6] = status.flags;
+  return ROOMBA_BINARY_STATUS_SIZE;
+}
+
+void RoombaBinaryProtocol::readStatus(ArduRoomba& roomba, RoombaBinaryStatus& status) {
+  const RoombaSensorSnapshot& values = roomba.getSensorCache().values();
+
+  status.voltage = values.get<SENSOR_VOLTAGE>();
+  status.current = values.get<SENSOR_CURRENT>();
+  status.flags = 0;
+  if (roomba.isConnected())                      status.flags |= BINARY_STATUS_CONNECTED;
+  if (values.get<SENSOR_WALL>())                 status.flags |= BINARY_STATUS_WALL;
+  if (values.get<SENSOR_BUMPS_DROPS>() & 0x03)   status.flags |= BINARY_STATUS_BUMPER;
+  if (roomba.isBusy())                           status.flags |= BINARY_STATUS_BUSY;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file ArduRoombaBinary.h
+ * @brief Compact binary command/status framing for the BLE extension
+ *
+ * Command frame (9 bytes, little-endian):
+ *   [0] 0xB0 | version  [1] sequence  [2] opcode
+ *   [3..4] int16 arg0   [5..6] int16 arg1   [7..8] uint16 duration (ms)
+ *
+ * Status frame (7 bytes, little-endian):
+ *   [0] 0xB0 | version  [1] last accepted sequence
+ *   [2..3] uint16 voltage (mV)  [4..5] int16 current (mA)  [6] flags
+ *
+ * ASCII commands are printable, so a first byte with the 0xB0 marker in its
+ * high nibble unambiguously selects the binary decoder.
+ */
+
+#ifndef ARDUROOMBA_BINARY_H
+#define ARDUROOMBA_BINARY_H
+
+#include "../ArduRoomba.h"
+#include "../RoombaRingBuffer.h"
+
+#define ROOMBA_BINARY_MARKER       0xB0
+#define ROOMBA_BINARY_VERSION      1
+#define ROOMBA_BINARY_COMMAND_SIZE 9
+#define ROOMBA_BINARY_STATUS_SIZE  7
+
+// Packets a status frame is built from (refreshed when not streaming)
+#define ROOMBA_STATUS_PACKET_COUNT 4
+
+// Wire opcodes (fixed; independent of RoombaAction ordering)
+enum RoombaBinaryOpcode : uint8_t {
+  BINARY_OP_STOP         = 0x00,
+  BINARY_OP_DRIVE        = 0x01, // arg0 = velocity, arg1 = radius
+  BINARY_OP_DRIVE_DIRECT = 0x02, // arg0 = right velocity, arg1 = left velocity
+  BINARY_OP_FORWARD      = 0x10, // arg0 = speed
+  BINARY_OP_BACKWARD     = 0x11,
+  BINARY_OP_LEFT         = 0x12,
+  BINARY_OP_RIGHT        = 0x13,
+  BINARY_OP_CLEAN        = 0x20,
+  BINARY_OP_SPOT         = 0x21,
+  BINARY_OP_DOCK         = 0x22,
+  BINARY_OP_BEEP         = 0x30
+};
+
+// Status flag bits
+#define BINARY_STATUS_CONNECTED 0x01
+#define BINARY_STATUS_WALL      0x02
+#define BINARY_STATUS_BUMPER    0x04
+#define BINARY_STATUS_REMOTE    0x08
+#define BINARY_STATUS_BUSY      0x10
+
+struct RoombaBinaryCommand {
+  uint8_t sequence;
+  RoombaAction action;
+  int16_t arg0;
+  int16_t arg1;
+  uint16_t duration;
+};
+
+struct RoombaBinaryStatus {
+  uint8_t sequence;
+  uint16_t voltage;
+  int16_t current;
+  uint8_t flags;
+};
+
+class RoombaBinaryProtocol {
+public:
+  static bool isBinary(const uint8_t* data, size_t length) {
+    return data && length > 0 && (data[0] & 0xF0) == ROOMBA_BINARY_MARKER;
+  }
+
+  // False for short frames, other versions or unknown opcodes
+  static bool decodeCommand(const uint8_t* data, size_t length, RoombaBinaryCommand& cmd);
+  static size_t encodeCommand(const RoombaBinaryCommand& cmd, uint8_t* out, size_t outSize);
+
+  static size_t encodeStatus(const RoombaBinaryStatus& status, uint8_t* out, size_t outSize);
+
+  // Fills voltage, current and the robot flags from the sensor cache (no
+  // serial traffic); sequence and BINARY_STATUS_REMOTE are left to the caller
+  static void readStatus(ArduRoomba& roomba, RoombaBinaryStatus& status);
+  static const uint8_t STATUS_PACKETS[ROOMBA_STATUS_PACKET_COUNT];
+
+  // True if seq is newer than last (modulo 256)
+  static bool isNewer(uint8_t seq, uint8_t last) { return (int8_t)(seq - last) > 0; }
+};
+
+/**
+ * Decoded commands handed from a radio task to loop()
+ *
+ * post() runs in the task that receives the frames, apply() in loop(). STOP
+ * does not queue behind other commands; it raises a sticky flag that apply()
+ * acts on first, so it survives a full mailbox. The commands still waiting
+ * when it is applied are discarded, as the robot's own queue is.
+ */
+template <uint8_t Size>
+class RoombaCommandMailbox {
+public:
+  RoombaCommandMailbox() : _stop(false) {}
+
+  // Producer side; false (and counted in dropped()) if the mailbox is full
+  bool post(const RoombaBinaryCommand& cmd) {
+    if (cmd.action == ROOMBA_ACTION_STOP) {
+      _stop = true;
+      return true;
+    }
+    return _queue.post(cmd);
+  }
+
+  // Consumer side: queues everything received on the robot
+  void apply(ArduRoomba& roomba) {
+    RoombaBinaryCommand cmd;
+    if (_stop) {
+      _stop = false;
+      while (_queue.take(cmd)) {}
+      roomba.queueCommand(ROOMBA_ACTION_STOP);
+    }
+    while (_queue.take(cmd)) {
+      roomba.queueCommand(cmd.action, cmd.arg0, cmd.arg1, cmd.duration);
+    }
+  }
+
+  uint8_t dropped() const { return _queue.dropped(); } // Wraps at 256
+
+private:
+  RoombaMailbox<RoombaBinaryCommand, Size> _queue;
+  volatile bool _stop;
+};
+
+#endif
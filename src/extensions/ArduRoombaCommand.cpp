@@ -0,0 +1,109 @@
+/**
+ * @file ArduRoombaCommand.cpp
+ * @brief Implementation of the shared command parser
+ */
+
+#include "ArduRoombaCommand.h"
+
+uint32_t RoombaCommandParser::hash(const char* s, size_t length) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    h = (h ^ (uint8_t)s[i]) * 16777619u;
+  }
+  return h;
+}
+
+#define ACTION_CASE(str, id) \
+  case roombaActionHash(str): \
+    return (length == sizeof(str) - 1 && memcmp(name, str, length) == 0) ? id : ROOMBA_ACTION_NONE
+
+RoombaAction RoombaCommandParser::actionFromName(const char* name, size_t length) {
+  if (!name) return ROOMBA_ACTION_NONE;
+
+  switch (hash(name, length)) {
+    ACTION_CASE("forward",  ROOMBA_ACTION_FORWARD);
+    ACTION_CASE("backward", ROOMBA_ACTION_BACKWARD);
+    ACTION_CASE("left",     ROOMBA_ACTION_LEFT);
+    ACTION_CASE("right",    ROOMBA_ACTION_RIGHT);
+    ACTION_CASE("stop",     ROOMBA_ACTION_STOP);
+    ACTION_CASE("clean",    ROOMBA_ACTION_CLEAN);
+    ACTION_CASE("spot",     ROOMBA_ACTION_SPOT);
+    ACTION_CASE("dock",     ROOMBA_ACTION_DOCK);
+    ACTION_CASE("beep",     ROOMBA_ACTION_BEEP);
+    default: return ROOMBA_ACTION_NONE;
+  }
+}
+
+#undef ACTION_CASE
+
+int32_t RoombaCommandParser::parseInt(const char* text, size_t length) {
+  size_t i = 0;
+  while (i < length && text[i] == ' ') i++;
+
+  bool negative = false;
+  if (i < length && (text[i] == '-' || text[i] == '+')) {
+    negative = text[i] == '-';
+    i++;
+  }
+
+  int32_t value = 0;
+  for (; i < length && text[i] >= '0' && text[i] <= '9'; i++) {
+    if (value < 100000000) value = value * 10 + (text[i] - '0');
+  }
+  return negative ? -value : value;
+}
+
+static int16_t clampInt16(int32_t value) {
+  if (value > 32767) return 32767;
+  if (value < -32768) return -32768;
+  return (int16_t)value;
+}
+
+bool RoombaCommandParser::parseCommand(const char* text, size_t length, RoombaCommand& cmd, int16_t defaultSpeed) {
+  if (!text || length == 0) return false;
+
+  // Split into up to three ':'-separated fields
+  const char* field[3] = {text, nullptr, nullptr};
+  size_t fieldLen[3] = {length, 0, 0};
+  uint8_t fields = 1;
+
+  for (size_t i = 0; i < length && fields < 3; i++) {
+    if (text[i] == ':') {
+      fieldLen[fields - 1] = (text + i) - field[fields - 1];
+      field[fields] = text + i + 1;
+      fieldLen[fields] = length - i - 1;
+      fields++;
+    }
+  }
+
+  size_t actionLen = fieldLen[0] < sizeof(cmd.action) - 1 ? fieldLen[0] : sizeof(cmd.action) - 1;
+  memcpy(cmd.action, field[0], actionLen);
+  cmd.action[actionLen] = '\0';
+
+  cmd.speed = fields > 1 ? clampInt16(parseInt(field[1], fieldLen[1])) : defaultSpeed;
+  cmd.duration = fields > 2 ? clampInt16(parseInt(field[2], fieldLen[2])) : 0;
+  return true;
+}
+
+int16_t RoombaCommandParser::defaultSpeed(RoombaAction action) {
+  switch (action) {
+    case ROOMBA_ACTION_LEFT:
+    case ROOMBA_ACTION_RIGHT:
+      return 150;
+    default:
+      return 200;
+  }
+}
+
+bool RoombaCommandParser::dispatch(ArduRoomba& roomba, RoombaAction action, int16_t speed, uint16_t duration) {
+  switch (action) {
+    case ROOMBA_ACTION_NONE:
+    case ROOMBA_ACTION_DRIVE:
+    case ROOMBA_ACTION_DRIVE_DIRECT:
+      return false;
+    case ROOMBA_ACTION_STOP:
+      return roomba.queueCommand(ROOMBA_ACTION_STOP);
+    default:
+      return roomba.queueCommand(action, speed, 0, duration);
+  }
+}
@@ -0,0 +1,48 @@
+/**
+ * @file ArduRoombaCommand.h
+ * @brief Allocation-free command parsing shared by the WiFi and BLE extensions
+ *
+ * Action names are resolved with a switch over compile-time FNV-1a hashes
+ * (duplicate hashes fail to compile), then confirmed with one memcmp.
+ * Everything works on caller-owned buffers; nothing touches the heap.
+ */
+
+#ifndef ARDUROOMBA_COMMAND_H
+#define ARDUROOMBA_COMMAND_H
+
+#include "../ArduRoomba.h"
+
+// Command protocol for WiFi/BLE control
+struct RoombaCommand {
+  char action[16];   // "forward", "backward", "left", "right", "stop", "clean", "dock"
+  int16_t speed;     // Speed parameter (0-500)
+  int16_t duration;  // Duration in milliseconds (0 = continuous)
+};
+
+// FNV-1a over a NUL-terminated string, usable in case labels
+constexpr uint32_t roombaActionHash(const char* s, uint32_t h = 2166136261u) {
+  return *s ? roombaActionHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+class RoombaCommandParser {
+public:
+  static RoombaAction actionFromName(const char* name, size_t length);
+  static RoombaAction actionFromName(const char* name) { return actionFromName(name, strlen(name)); }
+
+  // Parse "action[:speed[:duration]]"; speed defaults to defaultSpeed
+  static bool parseCommand(const char* text, size_t length, RoombaCommand& cmd, int16_t defaultSpeed = 200);
+
+  // Leading integer like String::toInt(): optional sign, digits, 0 if none
+  static int32_t parseInt(const char* text, size_t length);
+
+  // Default speed for movement actions sent without one
+  static int16_t defaultSpeed(RoombaAction action);
+
+  // Queue an action on the robot; timed actions expire from ArduRoomba::tick()
+  static bool dispatch(ArduRoomba& roomba, RoombaAction action, int16_t speed, uint16_t duration);
+
+private:
+  static uint32_t hash(const char* s, size_t length);
+};
+
+#endif
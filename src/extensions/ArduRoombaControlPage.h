@@ -0,0 +1,110 @@
+/**
+ * @file ArduRoombaControlPage.h
+ * @brief Gzip-compressed control page (generated - do not edit)
+ *
+ * Generated by extras/web/build_page.py from extras/web/control.html
+ * (3607 bytes, 1447 compressed).
+ */
+
+#ifndef ARDUROOMBA_CONTROL_PAGE_H
+#define ARDUROOMBA_CONTROL_PAGE_H
+
+#include <Arduino.h>
+
+#define ARDUROOMBA_CONTROL_PAGE_LENGTH 1447
+
+static const uint8_t ARDUROOMBA_CONTROL_PAGE_GZ[ARDUROOMBA_CONTROL_PAGE_LENGTH] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xa5, 0x57, 0x5b, 0x6f, 0xdb, 0x36,
+  0x14, 0x7e, 0xef, 0xaf, 0x38, 0xf3, 0x80, 0x5a, 0x46, 0x6d, 0x59, 0x8e, 0x93, 0x34, 0xf1, 0x25,
+  0x43, 0x93, 0xb6, 0x58, 0x81, 0x0e, 0x2d, 0x9a, 0xb4, 0xc3, 0x30, 0xec, 0x81, 0x96, 0x8e, 0x6c,
+  0xb6, 0x32, 0xa9, 0x92, 0x94, 0x1d, 0xaf, 0xeb, 0xeb, 0x9e, 0x77, 0xf9, 0x87, 0xfb, 0x25, 0x3b,
+  0x24, 0x25, 0x59, 0xbe, 0xac, 0x28, 0xb0, 0x3c, 0x44, 0xe4, 0xb9, 0xf1, 0x5c, 0xbe, 0x73, 0x48,
+  0x4f, 0xbe, 0x79, 0xfa, 0xea, 0xe6, 0xee, 0xa7, 0xd7, 0xcf, 0x60, 0x61, 0x96, 0xd9, 0xd5, 0x83,
+  0x49, 0xf5, 0x41, 0x96, 0x5c, 0x3d, 0x00, 0x98, 0x2c, 0xd1, 0x30, 0x10, 0x6c, 0x89, 0xd3, 0xd6,
+  0x8a, 0xe3, 0x3a, 0x97, 0xca, 0xb4, 0x20, 0x96, 0xc2, 0xa0, 0x30, 0xd3, 0xd6, 0x9a, 0x27, 0x66,
+  0x31, 0x4d, 0x70, 0xc5, 0x63, 0xec, 0xb9, 0x4d, 0x17, 0xb8, 0xe0, 0x86, 0xb3, 0xac, 0xa7, 0x63,
+  0x96, 0xe1, 0x74, 0x10, 0x46, 0x2d, 0x67, 0xc8, 0x70, 0x93, 0xe1, 0xd5, 0x13, 0x95, 0x14, 0x6f,
+  0xa4, 0x5c, 0xce, 0x18, 0xdc, 0x90, 0x11, 0x25, 0xb3, 0x49, 0xdf, 0x73, 0xac, 0x8c, 0x36, 0x1b,
+  0xbf, 0x02, 0x98, 0xc9, 0x64, 0x03, 0x9f, 0xdc, 0x12, 0x20, 0x25, 0xd1, 0x5e, 0xca, 0x96, 0x3c,
+  0xdb, 0x8c, 0xe0, 0x89, 0x22, 0xeb, 0x5d, 0xd0, 0x4c, 0xe8, 0x9e, 0x46, 0xc5, 0xd3, 0x71, 0x29,
+  0x65, 0xf0, 0xde, 0xf4, 0x58, 0xc6, 0xe7, 0x62, 0x04, 0x31, 0xb9, 0x87, 0xaa, 0xe2, 0xcc, 0x58,
+  0xfc, 0x61, 0xae, 0x64, 0x21, 0x92, 0x11, 0x7c, 0x7b, 0x12, 0x0f, 0xf1, 0x2c, 0xaa, 0x58, 0xb1,
+  0xcc, 0xa4, 0x22, 0x2a, 0xc6, 0x69, 0x94, 0x0e, 0x2a, 0x6a, 0xce, 0x92, 0x84, 0x8b, 0xf9, 0x08,
+  0x4e, 0xa2, 0xfc, 0xde, 0x13, 0x3f, 0xbb, 0xff, 0x8b, 0x01, 0x7c, 0xaa, 0x75, 0x86, 0xa7, 0x97,
+  0x17, 0xc9, 0x6c, 0x5c, 0xb2, 0xc2, 0xd8, 0x07, 0xa4, 0x6b, 0xb7, 0x13, 0xae, 0xf3, 0x8c, 0x91,
+  0xcb, 0x73, 0xc5, 0x93, 0xca, 0xb4, 0x5d, 0xf7, 0x0c, 0x2e, 0x89, 0x63, 0xb0, 0x47, 0xa6, 0x8a,
+  0xa5, 0xd0, 0x23, 0x50, 0x98, 0x23, 0x33, 0xc1, 0xb0, 0x0b, 0x83, 0x88, 0xce, 0xec, 0xd4, 0xe2,
+  0x2c, 0x1f, 0x11, 0xa9, 0xf2, 0x02, 0xe0, 0x7d, 0xa1, 0x0d, 0x4f, 0x37, 0xbd, 0xb2, 0x06, 0xfb,
+  0xa1, 0x2e, 0x99, 0x9a, 0x73, 0xe1, 0x1d, 0x07, 0x56, 0x18, 0xd9, 0xf4, 0x7e, 0x56, 0x18, 0x23,
+  0x45, 0xed, 0xdf, 0x91, 0x28, 0xcb, 0x5c, 0x6b, 0xfe, 0x2b, 0xd2, 0xb1, 0xe7, 0x5b, 0xf2, 0x4e,
+  0x0a, 0xcb, 0xc0, 0x77, 0x53, 0xb8, 0x5e, 0x70, 0x83, 0xb5, 0xb8, 0x54, 0x09, 0x12, 0x51, 0x48,
+  0xb1, 0x47, 0xeb, 0x29, 0x96, 0xf0, 0x82, 0x22, 0xbe, 0xd8, 0x1a, 0x8f, 0x0b, 0xa5, 0xad, 0x89,
+  0x5c, 0xf2, 0x66, 0x2c, 0x46, 0x51, 0x8d, 0x09, 0x4c, 0x92, 0xe2, 0x89, 0xc2, 0xa1, 0x3e, 0x0c,
+  0x65, 0xc4, 0x62, 0xc3, 0x57, 0x48, 0x35, 0xd9, 0x2d, 0xf1, 0xe5, 0x45, 0x34, 0xbb, 0x1c, 0x7b,
+  0x03, 0xa9, 0x54, 0xcb, 0x11, 0x38, 0x34, 0x06, 0x51, 0x78, 0x79, 0xd6, 0xa9, 0x0b, 0x46, 0x9c,
+  0x35, 0x53, 0x09, 0x69, 0xbb, 0xa2, 0xf8, 0x5a, 0x50, 0x36, 0x6a, 0x81, 0x0c, 0x53, 0xb3, 0xcf,
+  0x1d, 0x8c, 0xfd, 0x5e, 0xc9, 0x75, 0x53, 0x54, 0x1b, 0x99, 0x1f, 0x31, 0xb4, 0x23, 0xba, 0xe3,
+  0x23, 0x3e, 0x3e, 0x8d, 0x87, 0x71, 0xad, 0xaf, 0xf8, 0x7c, 0x71, 0x70, 0xd6, 0xf0, 0xf8, 0x59,
+  0xd6, 0xce, 0x7f, 0x38, 0xbe, 0x15, 0x1f, 0xd6, 0xe2, 0x36, 0x47, 0x52, 0x10, 0x2c, 0x4b, 0x70,
+  0xf4, 0xc8, 0x55, 0xe2, 0xdb, 0x9a, 0xef, 0x8b, 0x54, 0x00, 0xa9, 0x61, 0x74, 0x66, 0x85, 0x76,
+  0x73, 0xfb, 0x98, 0xe1, 0x79, 0xd4, 0x88, 0x9b, 0x99, 0x42, 0x37, 0x34, 0x1c, 0x96, 0xb6, 0xd0,
+  0x1a, 0x1c, 0x5a, 0x18, 0x9e, 0x9e, 0x5e, 0x9e, 0xe1, 0xf8, 0x18, 0x1e, 0x9c, 0xd5, 0x49, 0xbf,
+  0x9c, 0x03, 0x93, 0xbe, 0x1f, 0x43, 0x13, 0x3b, 0x0c, 0xdc, 0x80, 0x58, 0x0c, 0x8e, 0x4e, 0x10,
+  0x22, 0x5b, 0x6e, 0xc2, 0x57, 0x10, 0x67, 0x4c, 0xeb, 0x69, 0xcb, 0xbb, 0xd5, 0x02, 0x9e, 0xd4,
+  0xeb, 0xab, 0x6b, 0x66, 0x08, 0x5c, 0xd4, 0x8e, 0xbd, 0x1e, 0x2c, 0xdf, 0xc1, 0x6f, 0x70, 0xeb,
+  0x18, 0x76, 0x3f, 0xe9, 0x93, 0xee, 0xbe, 0x8d, 0xaa, 0x9f, 0x5b, 0x7e, 0x22, 0x4d, 0xca, 0xe4,
+  0x94, 0xdc, 0x12, 0x3c, 0x2d, 0x90, 0x22, 0xce, 0x78, 0xfc, 0x81, 0xce, 0x41, 0x91, 0x04, 0xed,
+  0x92, 0xde, 0xee, 0xb4, 0xae, 0xfe, 0xf9, 0xfd, 0xcf, 0x49, 0xdf, 0x6b, 0x1d, 0x35, 0x61, 0xe1,
+  0x75, 0xa0, 0x6f, 0x89, 0x5e, 0xf9, 0x8f, 0x2f, 0x2a, 0x5b, 0xc0, 0x1d, 0x28, 0x5b, 0xa2, 0x55,
+  0xbe, 0xbd, 0x7b, 0xf5, 0xfa, 0x8b, 0xda, 0x0e, 0x6e, 0x07, 0xea, 0x8e, 0xea, 0x0f, 0xff, 0xeb,
+  0x8b, 0xea, 0x15, 0x02, 0x0f, 0x2c, 0x54, 0x0c, 0x6f, 0xe4, 0xef, 0xa6, 0x91, 0xa3, 0x39, 0x2e,
+  0x81, 0xb7, 0x97, 0xe2, 0x3d, 0xa3, 0x71, 0x86, 0x4c, 0x58, 0x8b, 0x37, 0x76, 0x71, 0xdc, 0xb1,
+  0xfd, 0x44, 0xe4, 0xd2, 0x05, 0x72, 0x4b, 0x5f, 0xf8, 0x7a, 0xb5, 0x44, 0xc6, 0x1f, 0xac, 0xda,
+  0x53, 0xfa, 0x7e, 0x95, 0xc2, 0x0c, 0xd1, 0x25, 0xfc, 0x9a, 0xbe, 0xc7, 0x83, 0xd5, 0xb1, 0xe2,
+  0xb9, 0xf1, 0x46, 0xfa, 0x7d, 0xb8, 0xe6, 0x82, 0xa9, 0x0d, 0xe4, 0x4a, 0x1a, 0x49, 0x7d, 0x0b,
+  0xc1, 0x16, 0xcf, 0x9e, 0x15, 0x2e, 0x3a, 0x20, 0x57, 0xa8, 0xc0, 0x2c, 0x10, 0x7e, 0xc4, 0xd9,
+  0x2d, 0xb9, 0x82, 0x86, 0xce, 0x05, 0x7b, 0xf7, 0xc2, 0x45, 0x79, 0x47, 0x91, 0xa9, 0x99, 0xa4,
+  0x44, 0x6b, 0x58, 0x73, 0xb3, 0x90, 0x85, 0x01, 0x6e, 0x20, 0x78, 0x2b, 0x24, 0xbc, 0x39, 0xed,
+  0x40, 0xca, 0xb2, 0xcc, 0x35, 0x1d, 0x18, 0x09, 0xfd, 0x78, 0x99, 0x00, 0x13, 0x09, 0xf4, 0xcb,
+  0x66, 0xcd, 0x65, 0x96, 0x51, 0x73, 0x3a, 0x3b, 0x2b, 0xa6, 0xe0, 0xd5, 0xeb, 0x5b, 0x98, 0x52,
+  0x0b, 0x6b, 0x37, 0x18, 0xa2, 0xfb, 0x28, 0xea, 0x42, 0x09, 0x63, 0xbb, 0x1d, 0xd0, 0xb6, 0xaa,
+  0xab, 0xdb, 0x0f, 0xba, 0x60, 0x51, 0xea, 0xd6, 0x27, 0x5d, 0x70, 0xa8, 0x71, 0x9b, 0x61, 0xb7,
+  0x9c, 0xdc, 0xdb, 0x3f, 0x57, 0x3b, 0xcb, 0x3c, 0x21, 0x2b, 0xb6, 0x2a, 0x6e, 0x4d, 0x16, 0x6c,
+  0xaa, 0xdd, 0x9a, 0x2c, 0xd8, 0x2c, 0xda, 0xf5, 0x30, 0x82, 0xcf, 0xe3, 0xda, 0xad, 0xb5, 0x26,
+  0xaf, 0x44, 0x91, 0xd9, 0xcb, 0x1e, 0x3f, 0xd2, 0x9a, 0x2e, 0x6d, 0xc7, 0x4c, 0x0b, 0xe1, 0x60,
+  0x03, 0x7a, 0x21, 0xd7, 0xc1, 0x4a, 0x66, 0x86, 0xcd, 0xb1, 0x6b, 0x5f, 0x25, 0x02, 0x63, 0x83,
+  0x49, 0x67, 0x7b, 0x03, 0xcb, 0xb8, 0x58, 0xd2, 0xfd, 0x18, 0xce, 0xd1, 0x3c, 0xcb, 0xd0, 0x2e,
+  0xaf, 0x37, 0x2f, 0x5c, 0xa3, 0xd8, 0x4c, 0xb4, 0x3b, 0x21, 0x27, 0x1d, 0xf5, 0xfd, 0xdd, 0x0f,
+  0x2f, 0x61, 0x5a, 0xfb, 0xde, 0xae, 0x27, 0x45, 0x1b, 0x1e, 0x41, 0x69, 0x9f, 0x56, 0x6d, 0x3f,
+  0x36, 0x6e, 0xaa, 0x73, 0x3c, 0xbf, 0x3e, 0xb6, 0x79, 0x3d, 0x6d, 0x5d, 0xb4, 0x30, 0xf1, 0x28,
+  0xdf, 0xba, 0xc5, 0x53, 0x08, 0x28, 0xba, 0x87, 0x0f, 0x29, 0xc6, 0x50, 0xd1, 0x8c, 0xdb, 0xd8,
+  0x51, 0x84, 0x30, 0x9d, 0x4e, 0x61, 0xb0, 0x15, 0xf3, 0x69, 0x48, 0x6d, 0x16, 0x70, 0x0d, 0x4f,
+  0x99, 0x61, 0xef, 0xe8, 0x09, 0x16, 0xd8, 0xcd, 0x13, 0xa5, 0xd8, 0xe6, 0xba, 0x48, 0x53, 0x54,
+  0xc1, 0x65, 0xa7, 0x7e, 0x2d, 0x40, 0x99, 0xa9, 0xc0, 0x7e, 0x1e, 0x59, 0x5b, 0x0f, 0x29, 0xad,
+  0xcf, 0x9f, 0x6f, 0xf9, 0x69, 0xa8, 0xd1, 0xbc, 0xa5, 0x6b, 0xf6, 0x22, 0xa0, 0x82, 0x44, 0xf7,
+  0xd7, 0x83, 0xce, 0x51, 0xe6, 0xc0, 0x25, 0xfd, 0x38, 0x8f, 0x2a, 0x46, 0x90, 0xf9, 0xd9, 0x47,
+  0xf5, 0xcb, 0xbe, 0xcc, 0x0b, 0x61, 0x06, 0xe7, 0xf6, 0x21, 0x73, 0x62, 0x71, 0x64, 0x54, 0x81,
+  0x0d, 0x09, 0x8a, 0xd7, 0x65, 0x24, 0x0d, 0x67, 0xce, 0xf9, 0x06, 0x4b, 0xa1, 0x29, 0x94, 0xa8,
+  0xf6, 0x9f, 0xab, 0xe7, 0x08, 0x9a, 0x78, 0x11, 0xb4, 0x2d, 0x86, 0xbf, 0xf3, 0x07, 0x4e, 0x6d,
+  0xd2, 0xcb, 0x8c, 0xd6, 0xca, 0x21, 0x75, 0x8b, 0x08, 0x14, 0x4c, 0xaf, 0x40, 0x85, 0xf6, 0x21,
+  0x18, 0x74, 0xf6, 0x99, 0xc6, 0x32, 0xa9, 0x58, 0x5a, 0x66, 0x18, 0x66, 0x72, 0x1e, 0x98, 0xa6,
+  0x48, 0xcc, 0xec, 0x39, 0xd8, 0x94, 0x41, 0xa5, 0xa4, 0x0a, 0xb0, 0xca, 0xee, 0x5e, 0x61, 0x8b,
+  0x3c, 0xa1, 0x92, 0xf9, 0x2b, 0x24, 0xf8, 0xea, 0xd2, 0xee, 0x06, 0x59, 0x05, 0x57, 0xa1, 0xf1,
+  0x78, 0x38, 0xef, 0xb5, 0x14, 0x87, 0xe1, 0x24, 0x96, 0xe9, 0x1a, 0x20, 0x09, 0xeb, 0x16, 0x48,
+  0xc2, 0x6d, 0x13, 0xfc, 0x9f, 0xe0, 0x4a, 0x2b, 0x8d, 0xb8, 0x2c, 0x12, 0x75, 0x89, 0xc4, 0x7a,
+  0x2a, 0x05, 0xed, 0xb5, 0x1e, 0xf5, 0xfb, 0xb6, 0x20, 0x99, 0xa4, 0x43, 0x48, 0x35, 0x5c, 0x48,
+  0x6d, 0xec, 0xef, 0x05, 0xdb, 0x2f, 0xa3, 0x8b, 0x41, 0xbf, 0x5d, 0x97, 0x58, 0x87, 0x33, 0x37,
+  0xe1, 0xee, 0x36, 0x39, 0xb9, 0x02, 0x6d, 0x66, 0x31, 0xec, 0x61, 0xd0, 0xde, 0xca, 0x48, 0x21,
+  0x73, 0x14, 0xc4, 0xaf, 0x9d, 0xb1, 0x5e, 0xf8, 0x61, 0xa0, 0xc7, 0xf5, 0x24, 0xa8, 0x06, 0x85,
+  0x57, 0x59, 0xa2, 0xd6, 0xb6, 0x47, 0x9b, 0x5a, 0xb8, 0xdf, 0x48, 0xc9, 0x7e, 0x23, 0x61, 0x48,
+  0x25, 0x64, 0x0d, 0x08, 0xda, 0xe2, 0x25, 0xe1, 0x6c, 0x63, 0xf0, 0x25, 0x8a, 0xb9, 0x59, 0xc0,
+  0xd5, 0x14, 0x1e, 0x77, 0xaa, 0x2c, 0xcf, 0x3d, 0xfe, 0x09, 0xdc, 0x27, 0x25, 0xae, 0xbb, 0xb0,
+  0x25, 0x5f, 0x04, 0xe7, 0xb6, 0xdb, 0xa8, 0xc6, 0xae, 0xd2, 0x35, 0x8e, 0x9b, 0x6e, 0xc6, 0x99,
+  0xd4, 0x78, 0x3c, 0x34, 0x3b, 0xe7, 0x6c, 0x74, 0xe6, 0x8e, 0x2f, 0x91, 0xc6, 0x79, 0x50, 0x96,
+  0xa0, 0x0b, 0x67, 0x51, 0x14, 0x75, 0xea, 0x78, 0x7d, 0xa1, 0xea, 0xfa, 0x78, 0xa2, 0xef, 0x3a,
+  0x54, 0x2b, 0x96, 0x05, 0x4d, 0x5c, 0xba, 0x1e, 0x8c, 0x4a, 0xa1, 0x5d, 0xc0, 0x8e, 0xfd, 0x43,
+  0xab, 0xbc, 0x9c, 0xe8, 0xea, 0x72, 0x4f, 0x2c, 0x7a, 0x4a, 0xb9, 0xdf, 0x7f, 0xff, 0x02, 0x09,
+  0xcd, 0x98, 0xc3, 0x17, 0x0e, 0x00, 0x00,
+};
+
+#endif
@@ -4,17 +4,25 @@
  */
 
 #include "ArduRoombaESP32WiFi.h"
+#include "../RoombaMetrics.h"
 
 #if defined(ESP32)
 
 ArduRoombaESP32WiFi::ArduRoombaESP32WiFi(ArduRoomba& roomba)
-  : ArduRoombaWiFi(roomba), _server(nullptr), _mode(AR_WIFI_MODE_AP), _connected(false) {
+  : ArduRoombaWiFi(roomba), _server(nullptr), _mode(AR_WIFI_MODE_AP), _connected(false),
+    _wsServer(nullptr), _telemetryInterval(WS_TELEMETRY_INTERVAL), _lastTelemetry(0) {
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    _wsClients[i].open = false;
+  }
 }
 
 ArduRoombaESP32WiFi::~ArduRoombaESP32WiFi() {
   if (_server) {
     delete _server;
   }
+  if (_wsServer) {
+    delete _wsServer;
+  }
 }
 
 bool ArduRoombaESP32WiFi::beginAP(const char* ssid, const char* password) {
@@ -84,6 +92,18 @@ void ArduRoombaESP32WiFi::end() {
     _server = nullptr;
   }
 
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    closeWebSocket(_wsClients[i]);
+  }
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    _eventClients[i].stop();
+  }
+  if (_wsServer) {
+    _wsServer->end();
+    delete _wsServer;
+    _wsServer = nullptr;
+  }
+
   if (_mode == AR_WIFI_MODE_AP) {
     WiFi.softAPdisconnect(true);
   } else {
@@ -119,10 +139,17 @@ void ArduRoombaESP32WiFi::startWebServer(uint16_t port) {
   _server->on("/", [this]() { handleRoot(); });
   _server->on("/cmd", [this]() { handleCommand(); });
   _server->on("/status", [this]() { handleStatus(); });
+  _server->on("/events", [this]() { handleEvents(); });
+  _server->on("/metrics", [this]() { handleMetrics(); });
   _server->onNotFound([this]() { handleNotFound(); });
 
   _server->begin();
 
+  if (!_wsServer) {
+    _wsServer = new WiFiServer(WS_PORT);
+    _wsServer->begin();
+  }
+
   Serial.print("Web server started on port ");
   Serial.println(port);
   Serial.print("Access at: http://");
@@ -133,39 +160,242 @@ void ArduRoombaESP32WiFi::handleClient() {
   if (_server) {
     _server->handleClient();
   }
+  if (_wsServer) {
+    handleWebSockets();
+  }
+  sendEvents();
 }
 
+// Responses are written straight to the client with the shared writer, so
+// both backends send the same headers; WebServer closes the connection after
 void ArduRoombaESP32WiFi::handleRoot() {
-  String html = generateControlPage();
-  _server->send(200, "text/html", html);
+  // Served straight from flash; no RAM copy of the page
+  WiFiClient client = _server->client();
+  respondControlPage(client, 0);
 }
 
 void ArduRoombaESP32WiFi::handleCommand() {
-  // Parse command parameters
-  String action = _server->arg("action");
-  String speedStr = _server->arg("speed");
-  String durationStr = _server->arg("duration");
+  WiFiClient client = _server->client();
+  respondCommand(client, _server->arg("action").c_str(), _server->arg("speed").c_str(),
+                 _server->arg("duration").c_str(), 0);
+}
+
+void ArduRoombaESP32WiFi::handleStatus() {
+  WiFiClient client = _server->client();
+  respondStatus(client, _server->arg("fields").c_str(), 0);
+}
 
-  RoombaCommand cmd;
-  strncpy(cmd.action, action.c_str(), sizeof(cmd.action) - 1);
-  cmd.action[sizeof(cmd.action) - 1] = '\0';
-  cmd.speed = speedStr.length() > 0 ? speedStr.toInt() : 200;
-  cmd.duration = durationStr.length() > 0 ? durationStr.toInt() : 0;
+void ArduRoombaESP32WiFi::handleMetrics() {
+  WiFiClient client = _server->client();
+  respondMetrics(client, 0);
+}
 
-  processCommand(cmd);
+void ArduRoombaESP32WiFi::handleNotFound() {
+  WiFiClient client = _server->client();
+  respondError(client, 404, 0);
+}
 
-  _server->sendHeader("Access-Control-Allow-Origin", "*");
-  _server->send(200, "text/plain", "OK");
+// Keeps a copy of the socket so it outlives the request; WebServer only
+// drops its own reference
+void ArduRoombaESP32WiFi::handleEvents() {
+  WiFiClient client = _server->client();
+
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (!_eventClients[i].connected()) {
+      respondEventStream(client);
+      _eventClients[i] = client;
+      return;
+    }
+  }
+  respondError(client, 503, 0);
 }
 
-void ArduRoombaESP32WiFi::handleStatus() {
-  String json = generateStatusJSON();
-  _server->sendHeader("Access-Control-Allow-Origin", "*");
-  _server->send(200, "application/json", json);
+void ArduRoombaESP32WiFi::sendEvents() {
+  uint8_t streams = 0;
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    if (_eventClients[i].connected()) streams++;
+  }
+
+  char event[SSE_EVENT_MAX];
+  size_t length = nextEvent(event, sizeof(event), streams);
+  if (length == 0) return;
+
+  for (uint8_t i = 0; i < SSE_MAX_CLIENTS; i++) {
+    WiFiClient& client = _eventClients[i];
+    if (client.connected() && client.write((const uint8_t*)event, length) != length) {
+      client.stop();
+    }
+  }
 }
 
-void ArduRoombaESP32WiFi::handleNotFound() {
-  _server->send(404, "text/plain", "Not Found");
+uint8_t ArduRoombaESP32WiFi::getWebSocketClientCount() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (_wsClients[i].open && _wsClients[i].upgraded) count++;
+  }
+  return count;
+}
+
+// Never blocks: accepts, reads what has arrived on each socket, and pushes
+// one status frame to every upgraded client per telemetry interval
+void ArduRoombaESP32WiFi::handleWebSockets() {
+  WiFiClient incoming = _wsServer->available();
+  if (incoming) {
+    WebSocketClient* slot = nullptr;
+    for (uint8_t i = 0; i < WS_MAX_CLIENTS && !slot; i++) {
+      if (!_wsClients[i].open) slot = &_wsClients[i];
+    }
+
+    if (slot) {
+      incoming.setNoDelay(true); // Frames are tiny; don't wait to coalesce them
+      slot->client = incoming;
+      slot->handshake.reset();
+      slot->open = true;
+      slot->upgraded = false;
+      slot->haveSequence = false;
+      slot->lastSequence = 0;
+      slot->since = millis();
+    } else {
+      respondError(incoming, 503, 0);
+      incoming.stop();
+    }
+  }
+
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (_wsClients[i].open) serviceWebSocket(_wsClients[i]);
+  }
+
+  unsigned long now = millis();
+  if (getWebSocketClientCount() == 0 || now - _lastTelemetry < _telemetryInterval) return;
+  _lastTelemetry = now;
+
+  // One sensor read shared by every client
+  if (!_roomba.isStreaming()) {
+    _roomba.refreshSensors(RoombaBinaryProtocol::STATUS_PACKETS, ROOMBA_STATUS_PACKET_COUNT);
+  }
+
+  RoombaBinaryStatus status;
+  RoombaBinaryProtocol::readStatus(_roomba, status);
+  if (_remoteEnabled) status.flags |= BINARY_STATUS_REMOTE;
+
+  for (uint8_t i = 0; i < WS_MAX_CLIENTS; i++) {
+    if (_wsClients[i].open && _wsClients[i].upgraded) sendTelemetry(_wsClients[i], status);
+  }
+}
+
+void ArduRoombaESP32WiFi::serviceWebSocket(WebSocketClient& ws) {
+  // Bounded so a flooding client cannot stall the loop
+  uint8_t budget = 64;
+
+  if (!ws.upgraded) {
+    HttpParseResult result = ws.handshake.result();
+    while (result == HTTP_PARSE_INCOMPLETE && ws.client.available() > 0 && budget--) {
+      result = ws.handshake.feed((char)ws.client.read());
+    }
+
+    if (result == HTTP_PARSE_DONE) {
+      if (ws.handshake.method() == HTTP_METHOD_GET && ws.handshake.isWebSocketUpgrade()) {
+        RoombaWebSocket::writeHandshake(ws.client, ws.handshake.webSocketKey());
+        ws.upgraded = true;
+        ws.decoder.reset();
+
+        // Current state right away rather than on the next interval
+        RoombaBinaryStatus status;
+        RoombaBinaryProtocol::readStatus(_roomba, status);
+        if (_remoteEnabled) status.flags |= BINARY_STATUS_REMOTE;
+        sendTelemetry(ws, status);
+      } else {
+        respondError(ws.client, 400, 0);
+        closeWebSocket(ws);
+      }
+    } else if (result == HTTP_PARSE_ERROR) {
+      respondError(ws.client, ws.handshake.errorStatus(), 0);
+      closeWebSocket(ws);
+    } else if (!ws.client.connected()) {
+      closeWebSocket(ws);
+    } else if (millis() - ws.since > WS_HANDSHAKE_TIMEOUT_MS) {
+      respondError(ws.client, 408, 0);
+      closeWebSocket(ws);
+    }
+    return;
+  }
+
+  while (ws.client.available() > 0 && budget--) {
+    WebSocketFrameResult result = ws.decoder.feed((uint8_t)ws.client.read());
+    if (result == WS_FRAME_DONE) {
+      handleWebSocketFrame(ws);
+      if (!ws.open) return;
+    } else if (result == WS_FRAME_ERROR) {
+      RoombaWebSocket::writeClose(ws.client, ws.decoder.errorCode());
+      closeWebSocket(ws);
+      return;
+    }
+  }
+
+  if (!ws.client.connected()) {
+    closeWebSocket(ws);
+  }
+}
+
+void ArduRoombaESP32WiFi::handleWebSocketFrame(WebSocketClient& ws) {
+  ROOMBA_TRACE(METRIC_WS_FRAME);
+  const uint8_t* payload = ws.decoder.payload();
+  uint8_t length = ws.decoder.length();
+
+  switch (ws.decoder.opcode()) {
+    case WS_OP_BINARY: {
+      if (!_remoteEnabled) break;
+
+      RoombaBinaryCommand cmd;
+      if (!RoombaBinaryProtocol::decodeCommand(payload, length, cmd)) break;
+
+      // Drop retransmitted or stale frames
+      if (ws.haveSequence && !RoombaBinaryProtocol::isNewer(cmd.sequence, ws.lastSequence)) break;
+      ws.haveSequence = true;
+      ws.lastSequence = cmd.sequence;
+
+      _roomba.queueCommand(cmd.action, cmd.arg0, cmd.arg1, cmd.duration);
+      break;
+    }
+
+    case WS_OP_TEXT: {
+      // Same ASCII commands as BLE: "forward:200:1000"
+      RoombaCommand cmd;
+      if (RoombaCommandParser::parseCommand((const char*)payload, length, cmd)) {
+        processCommand(cmd);
+      }
+      break;
+    }
+
+    case WS_OP_PING:
+      RoombaWebSocket::writeFrame(ws.client, WS_OP_PONG, payload, length);
+      break;
+
+    case WS_OP_CLOSE:
+      RoombaWebSocket::writeClose(ws.client, WS_CLOSE_NORMAL);
+      closeWebSocket(ws);
+      break;
+
+    default:
+      break;
+  }
+}
+
+void ArduRoombaESP32WiFi::sendTelemetry(WebSocketClient& ws, RoombaBinaryStatus& status) {
+  uint8_t frame[ROOMBA_BINARY_STATUS_SIZE];
+
+  status.sequence = ws.lastSequence;
+  size_t length = RoombaBinaryProtocol::encodeStatus(status, frame, sizeof(frame));
+  RoombaWebSocket::writeFrame(ws.client, WS_OP_BINARY, frame, length);
+}
+
+void ArduRoombaESP32WiFi::closeWebSocket(WebSocketClient& ws) {
+  if (ws.open) {
+    ws.client.stop();
+    ws.client = WiFiClient();
+  }
+  ws.open = false;
+  ws.upgraded = false;
 }
 
 #endif // ESP32
@@ -4,12 +4,22 @@
  *
  * Uses WiFi library specific to ESP32.
  * Provides AP and Client modes with HTTP web server control.
+ *
+ * Next to the WebServer routes, a WebSocket channel on WS_PORT carries
+ * binary command frames (ArduRoombaBinary.h) from the control page and
+ * pushes status frames back every WS_TELEMETRY_INTERVAL ms, so a button
+ * press costs one frame instead of a new HTTP request.
+ *
+ * GET /events sockets are taken over from WebServer and kept open as
+ * Server-Sent Events streams.
  */
 
 #ifndef ARDUROOMBA_ESP32WIFI_H
 #define ARDUROOMBA_ESP32WIFI_H
 
 #include "ArduRoombaWiFi.h"
+#include "ArduRoombaBinary.h"
+#include "ArduRoombaWebSocket.h"
 
 // Only compile for ESP32
 #if defined(ESP32)
@@ -17,6 +27,22 @@
 #include <WiFi.h>
 #include <WebServer.h>
 
+#ifndef WS_PORT
+#define WS_PORT 81                   // The control page connects to ws://<ip>:81/
+#endif
+
+#ifndef WS_MAX_CLIENTS
+#define WS_MAX_CLIENTS 2
+#endif
+
+#ifndef WS_TELEMETRY_INTERVAL
+#define WS_TELEMETRY_INTERVAL 100    // ms between pushed status frames
+#endif
+
+#ifndef WS_HANDSHAKE_TIMEOUT_MS
+#define WS_HANDSHAKE_TIMEOUT_MS 1000
+#endif
+
 class ArduRoombaESP32WiFi : public ArduRoombaWiFi {
 public:
   ArduRoombaESP32WiFi(ArduRoomba& roomba);
@@ -35,16 +61,49 @@ public:
   void startWebServer(uint16_t port = 80) override;
   void handleClient() override;
 
+  // WebSocket telemetry rate
+  void setTelemetryInterval(uint16_t ms) { _telemetryInterval = ms; }
+  uint8_t getWebSocketClientCount() const;
+
 private:
   WebServer* _server;
   WiFiMode _mode;
   bool _connected;
 
+  // One WebSocket connection: HTTP handshake first, then frames
+  struct WebSocketClient {
+    WiFiClient client;
+    RoombaHttpParser handshake;
+    RoombaWebSocketDecoder decoder;
+    bool open;
+    bool upgraded;
+    bool haveSequence;      // Binary command sequence, per connection
+    uint8_t lastSequence;
+    unsigned long since;    // Accept time, for the handshake timeout
+  };
+
+  WiFiServer* _wsServer;
+  WebSocketClient _wsClients[WS_MAX_CLIENTS];
+  uint16_t _telemetryInterval;
+  unsigned long _lastTelemetry;
+
+  WiFiClient _eventClients[SSE_MAX_CLIENTS];
+
   // HTTP request handlers
   void handleRoot();
   void handleCommand();
   void handleStatus();
+  void handleMetrics();
   void handleNotFound();
+  void handleEvents();
+  void sendEvents();
+
+  // WebSocket channel
+  void handleWebSockets();
+  void serviceWebSocket(WebSocketClient& ws);
+  void handleWebSocketFrame(WebSocketClient& ws);
+  void sendTelemetry(WebSocketClient& ws, RoombaBinaryStatus& status);
+  void closeWebSocket(WebSocketClient& ws);
 };
 
 #endif // ESP32
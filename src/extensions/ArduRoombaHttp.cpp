@@ -0,0 +1,358 @@
+/**
+ * @file ArduRoombaHttp.cpp
+ * @brief Implementation of the incremental HTTP request parser and response writer
+ */
+
+#include "ArduRoombaHttp.h"
+
+// Headers the parser interprets
+#define HEADER_NONE           0
+#define HEADER_CONNECTION     1
+#define HEADER_CONTENT_LENGTH 2
+#define HEADER_UPGRADE        3
+#define HEADER_WEBSOCKET_KEY  4
+
+static int8_t hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static char lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+RoombaHttpParser::RoombaHttpParser() {
+  reset();
+}
+
+void RoombaHttpParser::reset() {
+  _state = S_METHOD;
+  _method = HTTP_METHOD_OTHER;
+  _error = 0;
+  _keepAlive = false;
+  _upgrade = false;
+  _lineBytes = 0;
+  _headerBytes = 0;
+  _tokenLength = 0;
+  _header = HEADER_NONE;
+  _webSocketKey[0] = '\0';
+  _keyLength = 0;
+  _path[0] = '\0';
+  _pathLength = 0;
+  _paramCount = 0;
+  _nameLength = 0;
+  _valueLength = 0;
+  _paramDropped = false;
+  _percent = 0;
+}
+
+HttpParseResult RoombaHttpParser::result() const {
+  if (_state == S_DONE) return HTTP_PARSE_DONE;
+  if (_state == S_ERROR) return HTTP_PARSE_ERROR;
+  return HTTP_PARSE_INCOMPLETE;
+}
+
+HttpParseResult RoombaHttpParser::fail(uint16_t status) {
+  _error = status;
+  _state = S_ERROR;
+  return HTTP_PARSE_ERROR;
+}
+
+HttpParseResult RoombaHttpParser::feed(char c) {
+  if (_state == S_DONE || _state == S_ERROR) return result();
+
+  if (_state < S_HEADER_START) {
+    if (++_lineBytes > HTTP_MAX_REQUEST_LINE) return fail(414);
+  } else {
+    if (++_headerBytes > HTTP_MAX_HEADER_BYTES) return fail(431);
+  }
+
+  switch (_state) {
+    case S_METHOD:
+      if (c == ' ') {
+        _token[_tokenLength] = '\0';
+        if (strcmp(_token, "GET") == 0) _method = HTTP_METHOD_GET;
+        else if (strcmp(_token, "HEAD") == 0) _method = HTTP_METHOD_HEAD;
+        else if (strcmp(_token, "POST") == 0) _method = HTTP_METHOD_POST;
+        _state = S_PATH;
+      } else if (c == '\r' || c == '\n') {
+        // Blank lines ahead of a request are allowed
+        if (_tokenLength > 0) return fail(400);
+        _lineBytes = 0;
+      } else if (_tokenLength < 7) {
+        _token[_tokenLength++] = c;
+      } else {
+        return fail(400);
+      }
+      break;
+
+    case S_PATH:
+      if (_pathLength == 0 && c != '/') return fail(400);
+      if (c == ' ') {
+        _state = S_VERSION;
+        _tokenLength = 0;
+      } else if (c == '?') {
+        _state = S_PARAM_NAME;
+        _nameLength = _valueLength = 0;
+        _paramDropped = _paramCount >= HTTP_MAX_PARAMS;
+      } else if (c == '\r' || c == '\n') {
+        return fail(400);
+      } else if (_pathLength < HTTP_MAX_PATH) {
+        _path[_pathLength++] = c;
+        _path[_pathLength] = '\0';
+      } else {
+        return fail(414);
+      }
+      break;
+
+    case S_PARAM_NAME:
+    case S_PARAM_VALUE:
+      if (c == '&' || c == ' ') {
+        commitParam();
+        if (c == ' ') {
+          _state = S_VERSION;
+          _tokenLength = 0;
+        } else {
+          _state = S_PARAM_NAME;
+          _paramDropped = _paramCount >= HTTP_MAX_PARAMS;
+        }
+      } else if (c == '\r' || c == '\n') {
+        return fail(400);
+      } else if (_state == S_PARAM_NAME) {
+        if (c == '=') {
+          _state = S_PARAM_VALUE;
+        } else if (_paramDropped) {
+          // Not kept
+        } else if (_nameLength < HTTP_MAX_PARAM_NAME) {
+          _params[_paramCount].name[_nameLength++] = c;
+        } else {
+          _paramDropped = true; // A truncated name could match the wrong key
+        }
+      } else if (c == '%') {
+        _state = S_PERCENT_HIGH;
+      } else if (!appendValue(c == '+' ? ' ' : c)) {
+        return fail(414);
+      }
+      break;
+
+    case S_PERCENT_HIGH:
+    case S_PERCENT_LOW: {
+      int8_t v = hexValue(c);
+      if (v < 0) return fail(400);
+      if (_state == S_PERCENT_HIGH) {
+        _percent = v << 4;
+        _state = S_PERCENT_LOW;
+      } else {
+        _state = S_PARAM_VALUE;
+        if (!appendValue((char)(_percent | v))) return fail(414);
+      }
+      break;
+    }
+
+    case S_VERSION:
+      if (c == '\n') {
+        _token[_tokenLength] = '\0';
+        endRequestLine();
+        if (_state == S_ERROR) return HTTP_PARSE_ERROR;
+        _state = S_HEADER_START;
+      } else if (c != '\r') {
+        if (_tokenLength >= sizeof(_token) - 1) return fail(400);
+        _token[_tokenLength++] = c;
+      }
+      break;
+
+    case S_HEADER_START:
+      if (c == '\n') {
+        _state = S_DONE;
+        return HTTP_PARSE_DONE;
+      } else if (c == ' ' || c == '\t') {
+        // Folded continuation of the previous header: skipped
+        _header = HEADER_NONE;
+        _tokenLength = 0;
+        _state = S_HEADER_VALUE;
+      } else if (c != '\r') {
+        _tokenLength = 0;
+        _state = S_HEADER_NAME;
+        if (c == ':') return fail(400);
+        _token[_tokenLength++] = lower(c);
+      }
+      break;
+
+    case S_HEADER_NAME:
+      if (c == ':') {
+        endHeaderName();
+        _tokenLength = 0;
+        _state = S_HEADER_VALUE;
+      } else if (c == '\n') {
+        return fail(400);
+      } else if (_tokenLength < sizeof(_token) - 1) {
+        _token[_tokenLength++] = lower(c);
+      } else {
+        _tokenLength = sizeof(_token); // Too long to be one we care about
+      }
+      break;
+
+    case S_HEADER_VALUE:
+      if (c == '\n') {
+        endHeaderValue();
+        _state = S_HEADER_START;
+      } else if (c == '\r' || ((c == ' ' || c == '\t') &&
+                              (_header == HEADER_WEBSOCKET_KEY ? _keyLength : _tokenLength) == 0)) {
+        // Skip leading whitespace and the CR
+      } else if (_header == HEADER_WEBSOCKET_KEY) {
+        // Case matters in the key; it is kept apart from the lowercased token
+        if (_keyLength < HTTP_WEBSOCKET_KEY_LENGTH) _webSocketKey[_keyLength] = c;
+        if (_keyLength <= HTTP_WEBSOCKET_KEY_LENGTH) _keyLength++;
+      } else if (_header != HEADER_NONE && _tokenLength < sizeof(_token) - 1) {
+        _token[_tokenLength++] = lower(c);
+      }
+      break;
+
+    default:
+      break;
+  }
+  return result();
+}
+
+const char* RoombaHttpParser::param(const char* name) const {
+  for (uint8_t i = 0; i < _paramCount; i++) {
+    if (strcmp(_params[i].name, name) == 0) return _params[i].value;
+  }
+  return nullptr;
+}
+
+bool RoombaHttpParser::appendValue(char c) {
+  if (_paramDropped) return true;
+  if (_valueLength >= HTTP_MAX_PARAM_VALUE) return false;
+  _params[_paramCount].value[_valueLength++] = c;
+  return true;
+}
+
+void RoombaHttpParser::commitParam() {
+  if (!_paramDropped && _nameLength > 0) {
+    _params[_paramCount].name[_nameLength] = '\0';
+    _params[_paramCount].value[_valueLength] = '\0';
+    _paramCount++;
+  }
+  _nameLength = _valueLength = 0;
+}
+
+void RoombaHttpParser::endRequestLine() {
+  if (strcmp(_token, "HTTP/1.1") == 0) {
+    _keepAlive = true;
+  } else if (strcmp(_token, "HTTP/1.0") == 0) {
+    _keepAlive = false;
+  } else {
+    fail(strncmp(_token, "HTTP/", 5) == 0 ? 505 : 400);
+  }
+}
+
+void RoombaHttpParser::endHeaderName() {
+  _token[_tokenLength < sizeof(_token) ? _tokenLength : sizeof(_token) - 1] = '\0';
+  if (_tokenLength < sizeof(_token) && strcmp(_token, "connection") == 0) {
+    _header = HEADER_CONNECTION;
+  } else if (_tokenLength < sizeof(_token) && strcmp(_token, "content-length") == 0) {
+    _header = HEADER_CONTENT_LENGTH;
+  } else if (_tokenLength < sizeof(_token) && strcmp(_token, "upgrade") == 0) {
+    _header = HEADER_UPGRADE;
+  } else if (_tokenLength < sizeof(_token) && strcmp(_token, "sec-websocket-key") == 0) {
+    _header = HEADER_WEBSOCKET_KEY;
+    _keyLength = 0;
+  } else {
+    _header = HEADER_NONE;
+  }
+}
+
+void RoombaHttpParser::endHeaderValue() {
+  _token[_tokenLength] = '\0';
+
+  if (_header == HEADER_CONNECTION) {
+    if (strstr(_token, "close")) _keepAlive = false;
+    else if (strstr(_token, "keep-alive")) _keepAlive = true;
+  } else if (_header == HEADER_CONTENT_LENGTH) {
+    // Bodies are not read; the connection cannot be reused after one
+    if (atol(_token) > 0) _keepAlive = false;
+  } else if (_header == HEADER_UPGRADE) {
+    _upgrade = strstr(_token, "websocket") != nullptr;
+  } else if (_header == HEADER_WEBSOCKET_KEY) {
+    // Anything but exactly 24 characters cannot be a valid key
+    _webSocketKey[_keyLength == HTTP_WEBSOCKET_KEY_LENGTH ? _keyLength : 0] = '\0';
+  }
+
+  _header = HEADER_NONE;
+  _tokenLength = 0;
+}
+
+const char* RoombaHttpParser::reasonPhrase(uint16_t status) {
+  switch (status) {
+    case 200: return "OK";
+    case 204: return "No Content";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 414: return "URI Too Long";
+    case 431: return "Request Header Fields Too Large";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default:  return "Error";
+  }
+}
+
+size_t RoombaHttpResponse::formatHead(char* buffer, size_t size, uint16_t status,
+                                      const char* contentType, long contentLength,
+                                      uint8_t flags) {
+  size_t length = 0;
+  int n = snprintf(buffer, size, "HTTP/1.1 %u %s\r\n", status,
+                   RoombaHttpParser::reasonPhrase(status));
+
+  // Each piece is appended only while the previous ones fitted
+#define HEAD_APPEND(...) \
+  if (n >= 0 && (size_t)n < size - length) { \
+    length += n; \
+    n = snprintf(buffer + length, size - length, __VA_ARGS__); \
+  }
+
+  if (contentType) HEAD_APPEND("Content-Type: %s\r\n", contentType);
+  if (flags & HTTP_GZIP) HEAD_APPEND("Content-Encoding: gzip\r\n");
+  if (flags & HTTP_CACHE) HEAD_APPEND("Cache-Control: " HTTP_CACHE_CONTROL "\r\n");
+  if (flags & HTTP_NO_CACHE) HEAD_APPEND("Cache-Control: no-cache\r\n");
+  if (flags & HTTP_CORS) HEAD_APPEND("Access-Control-Allow-Origin: *\r\n");
+  if (contentLength >= 0) HEAD_APPEND("Content-Length: %ld\r\n", contentLength);
+  if (flags & HTTP_KEEP_ALIVE) {
+    HEAD_APPEND("Connection: keep-alive\r\nKeep-Alive: timeout=%u\r\n\r\n",
+                (unsigned)(HTTP_KEEP_ALIVE_TIMEOUT_MS / 1000));
+  } else {
+    HEAD_APPEND("Connection: close\r\n\r\n");
+  }
+#undef HEAD_APPEND
+
+  if (n < 0 || (size_t)n >= size - length) return 0;
+  return length + n;
+}
+
+size_t RoombaHttpResponse::writeHead(Print& out, uint16_t status, const char* contentType,
+                                     long contentLength, uint8_t flags) {
+  char head[HTTP_RESPONSE_HEAD_MAX];
+  size_t length = formatHead(head, sizeof(head), status, contentType, contentLength, flags);
+  return length > 0 ? out.write((const uint8_t*)head, length) : 0;
+}
+
+size_t RoombaHttpResponse::write(Print& out, uint16_t status, const char* contentType,
+                                 const char* body, uint8_t flags) {
+  char buffer[HTTP_RESPONSE_HEAD_MAX + 64];
+  size_t bodyLength = body ? strlen(body) : 0;
+  size_t length = formatHead(buffer, sizeof(buffer), status, contentType, (long)bodyLength, flags);
+  if (length == 0) return 0;
+
+  // Small bodies ride in the same packet as the head
+  if (bodyLength <= sizeof(buffer) - length) {
+    if (bodyLength > 0) memcpy(buffer + length, body, bodyLength);
+    return out.write((const uint8_t*)buffer, length + bodyLength);
+  }
+  size_t sent = out.write((const uint8_t*)buffer, length);
+  return sent + out.write((const uint8_t*)body, bodyLength);
+}
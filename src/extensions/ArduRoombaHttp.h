@@ -0,0 +1,175 @@
+/**
+ * @file ArduRoombaHttp.h
+ * @brief Bounded, incremental HTTP/1.x request parser
+ *
+ * Fed one byte at a time as data arrives, so a server never waits for a
+ * whole request. The request line is decoded in a single pass: the path and
+ * up to HTTP_MAX_PARAMS query parameters (percent-decoded) land in fixed
+ * buffers. Headers are scanned, not stored; only Connection, Content-Length,
+ * Upgrade and Sec-WebSocket-Key are read. Anything over a limit ends the
+ * parse with an HTTP error status instead of growing memory.
+ *
+ * RoombaHttpResponse writes the status line and headers for both WiFi
+ * backends, formatted on the stack and sent with a single write().
+ */
+
+#ifndef ARDUROOMBA_HTTP_H
+#define ARDUROOMBA_HTTP_H
+
+#include <Arduino.h>
+
+#ifndef HTTP_MAX_PATH
+#define HTTP_MAX_PATH 32          // Path bytes, without the query
+#endif
+
+#ifndef HTTP_MAX_PARAMS
+#define HTTP_MAX_PARAMS 4         // Query parameters kept; extras are ignored
+#endif
+
+#ifndef HTTP_MAX_PARAM_NAME
+#define HTTP_MAX_PARAM_NAME 12
+#endif
+
+#ifndef HTTP_MAX_PARAM_VALUE
+#define HTTP_MAX_PARAM_VALUE 48        // Room for a short /status?fields= list
+#endif
+
+#ifndef HTTP_MAX_REQUEST_LINE
+#define HTTP_MAX_REQUEST_LINE 256
+#endif
+
+#ifndef HTTP_MAX_HEADER_BYTES
+#define HTTP_MAX_HEADER_BYTES 1024
+#endif
+
+#define HTTP_WEBSOCKET_KEY_LENGTH 24  // Base64 of the 16-byte handshake nonce
+
+#ifndef HTTP_KEEP_ALIVE_TIMEOUT_MS
+#define HTTP_KEEP_ALIVE_TIMEOUT_MS 5000  // Idle time before a kept-alive connection is closed
+#endif
+
+#define HTTP_CACHE_CONTROL "max-age=3600"
+
+// Response header options
+#define HTTP_KEEP_ALIVE 0x01  // "Connection: keep-alive" (otherwise close)
+#define HTTP_GZIP       0x02  // "Content-Encoding: gzip"
+#define HTTP_CORS       0x04  // "Access-Control-Allow-Origin: *"
+#define HTTP_CACHE      0x08  // "Cache-Control: " HTTP_CACHE_CONTROL
+#define HTTP_NO_CACHE   0x10  // "Cache-Control: no-cache" (live data)
+
+// Largest status line plus headers written by RoombaHttpResponse
+#define HTTP_RESPONSE_HEAD_MAX 192
+
+enum HttpMethod : uint8_t {
+  HTTP_METHOD_OTHER,
+  HTTP_METHOD_GET,
+  HTTP_METHOD_HEAD,
+  HTTP_METHOD_POST
+};
+
+enum HttpParseResult : uint8_t {
+  HTTP_PARSE_INCOMPLETE,
+  HTTP_PARSE_DONE,
+  HTTP_PARSE_ERROR
+};
+
+class RoombaHttpParser {
+public:
+  RoombaHttpParser();
+
+  void reset();
+
+  // Consume one byte; after DONE or ERROR further bytes are ignored until reset()
+  HttpParseResult feed(char c);
+  HttpParseResult result() const;
+
+  HttpMethod method() const { return _method; }
+  const char* path() const { return _path; }
+
+  // Decoded value of a query parameter, or nullptr if absent
+  const char* param(const char* name) const;
+  uint8_t paramCount() const { return _paramCount; }
+
+  // HTTP/1.1 defaults to keep-alive, HTTP/1.0 to close; Connection overrides
+  bool keepAlive() const { return _keepAlive; }
+
+  // "Upgrade: websocket" with a well-formed Sec-WebSocket-Key
+  bool isWebSocketUpgrade() const { return _upgrade && _webSocketKey[0] != '\0'; }
+  const char* webSocketKey() const { return _webSocketKey; }
+
+  // Status to answer with after HTTP_PARSE_ERROR (400, 414, 431 or 505)
+  uint16_t errorStatus() const { return _error; }
+
+  static const char* reasonPhrase(uint16_t status);
+
+private:
+  enum State : uint8_t {
+    S_METHOD,
+    S_PATH,
+    S_PARAM_NAME,
+    S_PARAM_VALUE,
+    S_PERCENT_HIGH,
+    S_PERCENT_LOW,
+    S_VERSION,
+    S_HEADER_START,
+    S_HEADER_NAME,
+    S_HEADER_VALUE,
+    S_DONE,
+    S_ERROR
+  };
+
+  struct Param {
+    char name[HTTP_MAX_PARAM_NAME + 1];
+    char value[HTTP_MAX_PARAM_VALUE + 1];
+  };
+
+  State _state;
+  HttpMethod _method;
+  uint16_t _error;
+  bool _keepAlive;
+  bool _upgrade;
+
+  uint16_t _lineBytes;
+  uint16_t _headerBytes;
+
+  char _token[20];   // Method, version, header name or interesting header value
+  uint8_t _tokenLength;
+  uint8_t _header;   // Which header is being read (HEADER_*)
+
+  char _webSocketKey[HTTP_WEBSOCKET_KEY_LENGTH + 1];
+  uint8_t _keyLength;
+
+  char _path[HTTP_MAX_PATH + 1];
+  uint8_t _pathLength;
+
+  Param _params[HTTP_MAX_PARAMS];
+  uint8_t _paramCount;
+  uint8_t _nameLength;
+  uint8_t _valueLength;
+  bool _paramDropped; // Current parameter is not being kept
+  uint8_t _percent;
+
+  HttpParseResult fail(uint16_t status);
+  bool appendValue(char c);
+  void commitParam();
+  void endRequestLine();
+  void endHeaderName();
+  void endHeaderValue();
+};
+
+class RoombaHttpResponse {
+public:
+  // Status line and headers in one write(); contentLength < 0 omits Content-Length
+  static size_t writeHead(Print& out, uint16_t status, const char* contentType,
+                          long contentLength, uint8_t flags);
+
+  // Complete response with a short body; sent as one write() when it fits
+  static size_t write(Print& out, uint16_t status, const char* contentType,
+                      const char* body, uint8_t flags);
+
+  // Formats the head into buffer; returns its length, or 0 if it did not fit
+  static size_t formatHead(char* buffer, size_t size, uint16_t status, const char* contentType,
+                           long contentLength, uint8_t flags);
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file ArduRoombaJson.cpp
+ * @brief Implementation of the buffered JSON writer
+ */
+
+#include "ArduRoombaJson.h"
+#include "../ArduRoomba.h"
+
+RoombaJsonWriter::RoombaJsonWriter(Print& out)
+  : _out(out), _used(0), _first(true), _written(0) {
+}
+
+void RoombaJsonWriter::beginObject() {
+  put('{');
+  _first = true;
+}
+
+void RoombaJsonWriter::endObject() {
+  put('}');
+}
+
+void RoombaJsonWriter::fieldInt(const char* name, int32_t value) {
+  key(name);
+  number(value);
+}
+
+void RoombaJsonWriter::fieldArray(const char* name, const uint16_t* values, uint8_t count) {
+  key(name);
+  put('[');
+  for (uint8_t i = 0; i < count; i++) {
+    if (i > 0) put(',');
+    number(values[i]);
+  }
+  put(']');
+}
+
+void RoombaJsonWriter::number(int32_t value) {
+  // Digits come out backwards; the sign and the largest magnitude fit in 11
+  char digits[11];
+  uint8_t n = 0;
+  uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+  do {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0);
+
+  if (value < 0) put('-');
+  while (n > 0) put(digits[--n]);
+}
+
+void RoombaJsonWriter::fieldBool(const char* name, bool value) {
+  key(name);
+  put(value ? "true" : "false");
+}
+
+void RoombaJsonWriter::fieldString(const char* name, const char* value) {
+  static const char hex[] = "0123456789abcdef";
+
+  key(name);
+  put('"');
+  for (const char* p = value ? value : ""; *p; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if ((uint8_t)c < 0x20) {
+      put("\\u00");
+      put(hex[(c >> 4) & 0x0F]);
+      put(hex[c & 0x0F]);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+}
+
+size_t RoombaJsonWriter::finish() {
+  flush();
+  return _written;
+}
+
+void RoombaJsonWriter::key(const char* name) {
+  if (!_first) put(',');
+  _first = false;
+  put('"');
+  put(name);
+  put("\":");
+}
+
+void RoombaJsonWriter::put(char c) {
+  if (_used == sizeof(_buffer)) flush();
+  _buffer[_used++] = c;
+}
+
+void RoombaJsonWriter::put(const char* text) {
+  while (*text) put(*text++);
+}
+
+void RoombaJsonWriter::flush() {
+  if (_used == 0) return;
+  _written += _out.write((const uint8_t*)_buffer, _used);
+  _used = 0;
+}
+
+RoombaBufferPrint::RoombaBufferPrint(char* buffer, size_t size)
+  : _buffer(buffer), _size(size), _length(0), _overflow(false) {
+  if (_size > 0) _buffer[0] = '\0';
+}
+
+size_t RoombaBufferPrint::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t RoombaBufferPrint::write(const uint8_t* data, size_t length) {
+  if (_size == 0) return 0;
+
+  size_t room = _size - 1 - _length;
+  if (length > room) {
+    _overflow = true;
+    length = room;
+  }
+  memcpy(_buffer + _length, data, length);
+  _length += length;
+  _buffer[_length] = '\0';
+  return length;
+}
+
+void RoombaLinkSnapshot::capture(const ArduRoomba& roomba) {
+  state = roomba.getLinkState();
+  msSinceValid = roomba.getTimeSinceValid();
+  health = roomba.getLinkHealth();
+  stream = roomba.getStreamStats();
+}
+
+void writeLinkHealthFields(RoombaJsonWriter& json, const RoombaLinkSnapshot& link) {
+  static const char* const states[] = { "off", "probing", "waking", "starting", "retry", "connected" };
+  const RoombaLinkHealth& health = link.health;
+  const RoombaStreamStats& stream = link.stream;
+
+  json.fieldString("link_state", link.state <= OI_LINK_CONNECTED ? states[link.state] : "unknown");
+  json.fieldInt("link_ms_since_valid", (int32_t)link.msSinceValid);
+  json.fieldInt("link_replies", (int32_t)health.replies);
+  json.fieldInt("link_timeouts", (int32_t)health.timeouts);
+  json.fieldInt("link_latency_min_us", (int32_t)health.latencyMin);
+  json.fieldInt("link_latency_mean_us", (int32_t)health.latencyMean());
+  json.fieldInt("link_latency_max_us", (int32_t)health.latencyMax);
+  json.fieldArray("link_latency_ms_log2", health.latencyHistogram, LINK_LATENCY_BUCKETS);
+  json.fieldInt("link_good_frames", (int32_t)stream.goodFrames);
+  json.fieldInt("link_checksum_errors", (int32_t)stream.badFrames);
+  json.fieldInt("link_resyncs", (int32_t)stream.resyncs);
+  json.fieldInt("link_connects", health.connects);
+  json.fieldInt("link_wakes", health.wakes);
+  json.fieldInt("link_losses", health.losses);
+  json.fieldString("link_last_loss", RoombaLinkHealth::lossName(health.lastLoss));
+}
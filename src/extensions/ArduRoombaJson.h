@@ -0,0 +1,99 @@
+/**
+ * @file ArduRoombaJson.h
+ * @brief Allocation-free JSON output for the WiFi status endpoints
+ *
+ * RoombaJsonWriter formats a flat JSON object straight into any Print (a
+ * client socket, RoombaBufferPrint over a fixed array, or RoombaCountingPrint
+ * to learn the length first). Output is gathered in a small internal buffer
+ * so a socket sees a few large writes rather than one per character.
+ */
+
+#ifndef ARDUROOMBA_JSON_H
+#define ARDUROOMBA_JSON_H
+
+#include <Arduino.h>
+#include "../RoombaOI.h"
+
+class ArduRoomba;
+
+#ifndef JSON_WRITE_CHUNK
+#define JSON_WRITE_CHUNK 128
+#endif
+
+class RoombaJsonWriter {
+public:
+  explicit RoombaJsonWriter(Print& out);
+
+  void beginObject();
+  void endObject();
+
+  void fieldInt(const char* name, int32_t value);
+  void fieldBool(const char* name, bool value);
+  void fieldString(const char* name, const char* value); // Escaped
+  void fieldArray(const char* name, const uint16_t* values, uint8_t count);
+
+  // Sends anything still buffered; returns the total bytes written
+  size_t finish();
+
+private:
+  Print& _out;
+  char _buffer[JSON_WRITE_CHUNK];
+  uint8_t _used;
+  bool _first;
+  size_t _written;
+
+  void put(char c);
+  void put(const char* text);
+  void key(const char* name);
+  void number(int32_t value);
+  void flush();
+};
+
+// Link state and counters, copied once so a measured length and the written
+// body agree (ms since valid moves on while the response head is sent)
+struct RoombaLinkSnapshot {
+  RoombaLinkState state;
+  unsigned long msSinceValid;
+  RoombaLinkHealth health;
+  RoombaStreamStats stream;
+
+  void capture(const ArduRoomba& roomba);
+};
+
+// "link_*" fields for the OI link health (see RoombaLinkHealth.h): state,
+// ms since the last valid frame or reply, query counts and latency (us,
+// with the power-of-two ms histogram), stream frame errors, wakes and losses
+void writeLinkHealthFields(RoombaJsonWriter& json, const RoombaLinkSnapshot& link);
+
+// Counts bytes instead of sending them (e.g. for Content-Length)
+class RoombaCountingPrint : public Print {
+public:
+  RoombaCountingPrint() : count(0) {}
+
+  size_t write(uint8_t) { count++; return 1; }
+  size_t write(const uint8_t*, size_t length) { count += length; return length; }
+  using Print::write;
+
+  size_t count;
+};
+
+// Writes into a caller-owned array, always NUL-terminated; excess is dropped
+class RoombaBufferPrint : public Print {
+public:
+  RoombaBufferPrint(char* buffer, size_t size);
+
+  size_t write(uint8_t byte);
+  size_t write(const uint8_t* data, size_t length);
+  using Print::write;
+
+  size_t length() const { return _length; }
+  bool overflowed() const { return _overflow; }
+
+private:
+  char* _buffer;
+  size_t _size;
+  size_t _length;
+  bool _overflow;
+};
+
+#endif
@@ -0,0 +1,241 @@
+/**
+ * @file ArduRoombaWebSocket.cpp
+ * @brief Implementation of the WebSocket handshake and frame codec
+ */
+
+#include "ArduRoombaWebSocket.h"
+
+static const char WS_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// SHA-1 (only used for the handshake, so small over fast)
+struct Sha1 {
+  uint32_t h[5];
+  uint8_t block[64];
+  uint8_t used;
+  uint32_t total;
+
+  void begin() {
+    h[0] = 0x67452301; h[1] = 0xEFCDAB89; h[2] = 0x98BADCFE;
+    h[3] = 0x10325476; h[4] = 0xC3D2E1F0;
+    used = 0;
+    total = 0;
+  }
+
+  static uint32_t rol(uint32_t x, uint8_t n) { return (x << n) | (x >> (32 - n)); }
+
+  void compress() {
+    uint32_t w[16];
+    for (uint8_t i = 0; i < 16; i++) {
+      w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+             ((uint32_t)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (uint8_t i = 0; i < 80; i++) {
+      if (i >= 16) {
+        w[i & 15] = rol(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+      }
+      uint32_t f, k;
+      if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+      else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+      else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+      else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+      uint32_t t = rol(a, 5) + f + e + k + w[i & 15];
+      e = d; d = c; c = rol(b, 30); b = a; a = t;
+    }
+    h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+  }
+
+  void update(const uint8_t* data, size_t length) {
+    total += length;
+    while (length--) {
+      block[used++] = *data++;
+      if (used == 64) {
+        compress();
+        used = 0;
+      }
+    }
+  }
+
+  void finish(uint8_t* digest) {
+    uint64_t bits = (uint64_t)total * 8;
+    uint8_t pad = 0x80;
+    update(&pad, 1);
+    pad = 0;
+    while (used != 56) update(&pad, 1);
+    for (int8_t i = 7; i >= 0; i--) {
+      uint8_t b = (uint8_t)(bits >> (i * 8));
+      update(&b, 1);
+    }
+    for (uint8_t i = 0; i < 20; i++) {
+      digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+    }
+  }
+};
+
+static void base64(const uint8_t* data, size_t length, char* out) {
+  static const char alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  for (size_t i = 0; i < length; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < length) v |= (uint32_t)data[i + 1] << 8;
+    if (i + 2 < length) v |= data[i + 2];
+
+    *out++ = alphabet[(v >> 18) & 0x3F];
+    *out++ = alphabet[(v >> 12) & 0x3F];
+    *out++ = i + 1 < length ? alphabet[(v >> 6) & 0x3F] : '=';
+    *out++ = i + 2 < length ? alphabet[v & 0x3F] : '=';
+  }
+  *out = '\0';
+}
+
+RoombaWebSocketDecoder::RoombaWebSocketDecoder() {
+  reset();
+}
+
+void RoombaWebSocketDecoder::reset() {
+  _state = S_HEADER;
+  _opcode = 0;
+  _error = 0;
+  _count = 0;
+  _extendedBytes = 0;
+  _expected = 0;
+  _length = 0;
+}
+
+WebSocketFrameResult RoombaWebSocketDecoder::fail(uint16_t code) {
+  _error = code;
+  _state = S_ERROR;
+  return WS_FRAME_ERROR;
+}
+
+WebSocketFrameResult RoombaWebSocketDecoder::beginPayload() {
+  _length = 0;
+  _count = 0;
+  if (_expected == 0) {
+    _state = S_DONE;
+    return WS_FRAME_DONE;
+  }
+  _state = S_PAYLOAD;
+  return WS_FRAME_INCOMPLETE;
+}
+
+WebSocketFrameResult RoombaWebSocketDecoder::feed(uint8_t byte) {
+  if (_state == S_ERROR) return WS_FRAME_ERROR;
+  if (_state == S_DONE) _state = S_HEADER;
+
+  switch (_state) {
+    case S_HEADER: {
+      uint8_t opcode = byte & 0x0F;
+      if (byte & 0x70) return fail(WS_CLOSE_PROTOCOL); // No extensions negotiated
+      // Fragmented messages would need reassembly; nothing we accept is that large
+      if (!(byte & 0x80) || opcode == WS_OP_CONTINUATION) return fail(WS_CLOSE_TOO_BIG);
+      if (opcode != WS_OP_TEXT && opcode != WS_OP_BINARY && opcode != WS_OP_CLOSE &&
+          opcode != WS_OP_PING && opcode != WS_OP_PONG) {
+        return fail(WS_CLOSE_PROTOCOL);
+      }
+      _opcode = opcode;
+      _state = S_LENGTH;
+      break;
+    }
+
+    case S_LENGTH: {
+      uint8_t length = byte & 0x7F;
+      if (!(byte & 0x80)) return fail(WS_CLOSE_PROTOCOL); // Clients must mask
+      if ((_opcode & 0x08) && length > 125) return fail(WS_CLOSE_PROTOCOL);
+
+      _count = 0;
+      _expected = 0;
+      if (length == 126 || length == 127) {
+        _extendedBytes = length == 126 ? 2 : 8;
+        _state = S_EXTENDED_LENGTH;
+      } else {
+        _expected = length;
+        if (_expected > WS_MAX_PAYLOAD) return fail(WS_CLOSE_TOO_BIG);
+        _state = S_MASK;
+      }
+      break;
+    }
+
+    case S_EXTENDED_LENGTH:
+      _expected = (_expected << 8) | byte;
+      if (++_count == _extendedBytes) {
+        if (_expected > WS_MAX_PAYLOAD) return fail(WS_CLOSE_TOO_BIG);
+        _count = 0;
+        _state = S_MASK;
+      }
+      break;
+
+    case S_MASK:
+      _mask[_count++] = byte;
+      if (_count == 4) return beginPayload();
+      break;
+
+    case S_PAYLOAD:
+      _payload[_length] = byte ^ _mask[_length & 3];
+      if (++_length == _expected) {
+        _state = S_DONE;
+        return WS_FRAME_DONE;
+      }
+      break;
+
+    default:
+      break;
+  }
+  return WS_FRAME_INCOMPLETE;
+}
+
+void RoombaWebSocket::acceptKey(const char* key, char* out) {
+  Sha1 sha;
+  uint8_t digest[20];
+
+  sha.begin();
+  sha.update((const uint8_t*)key, strlen(key));
+  sha.update((const uint8_t*)WS_GUID, sizeof(WS_GUID) - 1);
+  sha.finish(digest);
+  base64(digest, sizeof(digest), out);
+}
+
+size_t RoombaWebSocket::writeHandshake(Print& out, const char* key) {
+  char accept[WS_ACCEPT_LENGTH + 1];
+  char head[160];
+
+  acceptKey(key, accept);
+  int n = snprintf(head, sizeof(head),
+                   "HTTP/1.1 101 Switching Protocols\r\n"
+                   "Upgrade: websocket\r\n"
+                   "Connection: Upgrade\r\n"
+                   "Sec-WebSocket-Accept: %s\r\n\r\n", accept);
+  if (n < 0 || (size_t)n >= sizeof(head)) return 0;
+  return out.write((const uint8_t*)head, n);
+}
+
+size_t RoombaWebSocket::writeFrame(Print& out, uint8_t opcode, const uint8_t* payload,
+                                   size_t length) {
+  uint8_t frame[4 + 64];
+  size_t head = 2;
+
+  if (length > 0xFFFF) return 0;
+  frame[0] = 0x80 | (opcode & 0x0F);
+  if (length < 126) {
+    frame[1] = (uint8_t)length;
+  } else {
+    frame[1] = 126;
+    frame[2] = (uint8_t)(length >> 8);
+    frame[3] = (uint8_t)length;
+    head = 4;
+  }
+
+  if (length <= sizeof(frame) - head) {
+    if (length > 0) memcpy(frame + head, payload, length);
+    return out.write(frame, head + length);
+  }
+  size_t sent = out.write(frame, head);
+  return sent + out.write(payload, length);
+}
+
+size_t RoombaWebSocket::writeClose(Print& out, uint16_t code) {
+  uint8_t payload[2] = { (uint8_t)(code >> 8), (uint8_t)code };
+  return writeFrame(out, WS_OP_CLOSE, payload, sizeof(payload));
+}
@@ -0,0 +1,104 @@
+/**
+ * @file ArduRoombaWebSocket.h
+ * @brief Minimal RFC 6455 WebSocket framing for the WiFi extensions
+ *
+ * Just enough WebSocket for a control channel: the opening handshake
+ * (Sec-WebSocket-Accept, from a key captured by RoombaHttpParser), whole
+ * client frames up to WS_MAX_PAYLOAD bytes, and unmasked frames back.
+ * Fragmented messages and extensions are not supported.
+ *
+ * Like RoombaHttpParser, the decoder is fed one byte at a time, so a server
+ * never blocks waiting for the rest of a frame.
+ */
+
+#ifndef ARDUROOMBA_WEBSOCKET_H
+#define ARDUROOMBA_WEBSOCKET_H
+
+#include <Arduino.h>
+
+// Largest client frame payload accepted (binary commands are 9 bytes)
+#ifndef WS_MAX_PAYLOAD
+#define WS_MAX_PAYLOAD 32
+#endif
+
+#define WS_ACCEPT_LENGTH 28  // Base64 of a SHA-1 digest
+
+// Close codes
+#define WS_CLOSE_NORMAL   1000
+#define WS_CLOSE_PROTOCOL 1002
+#define WS_CLOSE_TOO_BIG  1009
+
+enum WebSocketOpcode : uint8_t {
+  WS_OP_CONTINUATION = 0x0,
+  WS_OP_TEXT         = 0x1,
+  WS_OP_BINARY       = 0x2,
+  WS_OP_CLOSE        = 0x8,
+  WS_OP_PING         = 0x9,
+  WS_OP_PONG         = 0xA
+};
+
+enum WebSocketFrameResult : uint8_t {
+  WS_FRAME_INCOMPLETE,
+  WS_FRAME_DONE,
+  WS_FRAME_ERROR
+};
+
+class RoombaWebSocketDecoder {
+public:
+  RoombaWebSocketDecoder();
+
+  void reset();
+
+  // Consume one byte from the client. After DONE the next byte starts a new
+  // frame; after ERROR bytes are ignored until reset()
+  WebSocketFrameResult feed(uint8_t byte);
+
+  // Last complete frame, unmasked
+  uint8_t opcode() const { return _opcode; }
+  const uint8_t* payload() const { return _payload; }
+  uint8_t length() const { return _length; }
+
+  // Close code to send after WS_FRAME_ERROR
+  uint16_t errorCode() const { return _error; }
+
+private:
+  enum State : uint8_t {
+    S_HEADER,
+    S_LENGTH,
+    S_EXTENDED_LENGTH,
+    S_MASK,
+    S_PAYLOAD,
+    S_DONE,
+    S_ERROR
+  };
+
+  State _state;
+  uint8_t _opcode;
+  uint16_t _error;
+
+  uint8_t _count;         // Bytes read in the current state
+  uint8_t _extendedBytes; // 2 or 8
+  uint64_t _expected;     // Payload length from the header
+  uint8_t _mask[4];
+
+  uint8_t _payload[WS_MAX_PAYLOAD];
+  uint8_t _length;
+
+  WebSocketFrameResult fail(uint16_t code);
+  WebSocketFrameResult beginPayload();
+};
+
+class RoombaWebSocket {
+public:
+  // Sec-WebSocket-Accept for a client key; out holds WS_ACCEPT_LENGTH + 1 bytes
+  static void acceptKey(const char* key, char* out);
+
+  // 101 Switching Protocols, in one write()
+  static size_t writeHandshake(Print& out, const char* key);
+
+  // One unmasked, final frame; small frames go out in a single write()
+  static size_t writeFrame(Print& out, uint8_t opcode, const uint8_t* payload, size_t length);
+  static size_t writeClose(Print& out, uint16_t code);
+};
+
+#endif
@@ -4,9 +4,12 @@
  */
 
 #include "ArduRoombaWiFi.h"
+#include "ArduRoombaControlPage.h"
+#include "../RoombaMetrics.h"
 
 ArduRoombaWiFi::ArduRoombaWiFi(ArduRoomba& roomba)
-  : _roomba(roomba), _remoteEnabled(true), _commandCallback(nullptr) {
+  : _roomba(roomba), _remoteEnabled(true), _commandCallback(nullptr),
+    _eventInterval(SSE_MIN_INTERVAL), _lastEventPoll(0), _lastEventSent(0), _eventValid(false) {
 }
 
 void ArduRoombaWiFi::processCommand(const RoombaCommand& cmd) {
@@ -17,147 +20,279 @@ void ArduRoombaWiFi::processCommand(const RoombaCommand& cmd) {
     _commandCallback(cmd);
   }
 
-  // Process standard commands
-  String action = String(cmd.action);
+  // Process standard commands; timed ones expire from ArduRoomba::tick()
+  RoombaAction action = RoombaCommandParser::actionFromName(cmd.action);
+  int16_t speed = cmd.speed > 0 ? cmd.speed : RoombaCommandParser::defaultSpeed(action);
+  uint16_t duration = cmd.duration > 0 ? cmd.duration : 0;
 
-  if (action == "forward") {
-    _roomba.moveForward(cmd.speed > 0 ? cmd.speed : 200);
-  }
-  else if (action == "backward") {
-    _roomba.moveBackward(cmd.speed > 0 ? cmd.speed : 200);
-  }
-  else if (action == "left") {
-    _roomba.turnLeft(cmd.speed > 0 ? cmd.speed : 150);
-  }
-  else if (action == "right") {
-    _roomba.turnRight(cmd.speed > 0 ? cmd.speed : 150);
-  }
-  else if (action == "stop") {
-    _roomba.stop();
-  }
-  else if (action == "clean") {
-    _roomba.startCleaning();
+  RoombaCommandParser::dispatch(_roomba, action, speed, duration);
+}
+
+void ArduRoombaWiFi::setCommandCallback(void (*callback)(const RoombaCommand&)) {
+  _commandCallback = callback;
+}
+
+// The page lives in flash only; it is copied out one chunk at a time
+size_t ArduRoombaWiFi::writeControlPage(Print& out) {
+  uint8_t chunk[WIFI_PAGE_CHUNK_SIZE];
+  size_t sent = 0;
+
+  while (sent < ARDUROOMBA_CONTROL_PAGE_LENGTH) {
+    size_t n = ARDUROOMBA_CONTROL_PAGE_LENGTH - sent;
+    if (n > sizeof(chunk)) n = sizeof(chunk);
+
+    memcpy_P(chunk, ARDUROOMBA_CONTROL_PAGE_GZ + sent, n);
+    size_t written = out.write(chunk, n);
+    if (written == 0) break; // Client went away
+    sent += written;
   }
-  else if (action == "spot") {
-    _roomba.spotClean();
+  return sent;
+}
+
+const uint8_t* ArduRoombaWiFi::controlPageData() {
+  return ARDUROOMBA_CONTROL_PAGE_GZ;
+}
+
+size_t ArduRoombaWiFi::controlPageLength() {
+  return ARDUROOMBA_CONTROL_PAGE_LENGTH;
+}
+
+void ArduRoombaWiFi::parseStatusFields(const char* list, RoombaStatusFields& fields) {
+  fields.packets = 0;
+  fields.extras = 0;
+
+  if (!list || !*list) {
+    fields.packets = PACKET_BIT(SENSOR_VOLTAGE);
+    fields.extras = STATUS_FIELD_CONNECTED | STATUS_FIELD_REMOTE;
+    return;
   }
-  else if (action == "dock") {
-    _roomba.dock();
+
+  while (*list) {
+    const char* end = list;
+    while (*end && *end != ',') end++;
+    size_t length = end - list;
+
+    uint8_t id = RoombaPackets::idForName(list, length);
+    if (id == 0 && length > 0 && length <= 2 && list[0] >= '0' && list[0] <= '9') {
+      id = (uint8_t)RoombaCommandParser::parseInt(list, length);
+      if (id < OI_PACKET_FIRST || id > OI_PACKET_LAST) id = 0;
+    }
+
+    if (id != 0) {
+      fields.packets |= PACKET_BIT(id);
+    } else if (length == 3 && strncmp(list, "all", 3) == 0) {
+      fields.packets = ~(uint64_t)0 >> (64 - OI_PACKET_COUNT);
+      fields.extras = STATUS_FIELD_CONNECTED | STATUS_FIELD_REMOTE | STATUS_FIELD_BUSY | STATUS_FIELD_LINK;
+    } else if (length == 9 && strncmp(list, "connected", 9) == 0) {
+      fields.extras |= STATUS_FIELD_CONNECTED;
+    } else if (length == 14 && strncmp(list, "remote_enabled", 14) == 0) {
+      fields.extras |= STATUS_FIELD_REMOTE;
+    } else if (length == 4 && strncmp(list, "busy", 4) == 0) {
+      fields.extras |= STATUS_FIELD_BUSY;
+    } else if (length == 4 && strncmp(list, "link", 4) == 0) {
+      fields.extras |= STATUS_FIELD_LINK;
+    }
+    // Unknown names are ignored
+
+    list = *end ? end + 1 : end;
   }
-  else if (action == "beep") {
-    _roomba.beep();
+}
+
+void ArduRoombaWiFi::refreshStatusFields(const RoombaStatusFields& fields) {
+  if (fields.packets == 0 || _roomba.isStreaming()) return;
+
+  // A query reply must fit one snapshot buffer; larger selections are split
+  uint8_t ids[OI_PACKET_COUNT];
+  uint8_t count = 0;
+  uint8_t bytes = 0;
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    if (!(fields.packets & PACKET_BIT(id))) continue;
+
+    uint8_t size = RoombaPackets::size(id);
+    if (bytes + size > OI_STREAM_MAX_PAYLOAD) {
+      _roomba.refreshSensors(ids, count);
+      count = 0;
+      bytes = 0;
+    }
+    ids[count++] = id;
+    bytes += size;
   }
+  if (count > 0) _roomba.refreshSensors(ids, count);
+}
 
-  // Handle timed commands
-  if (cmd.duration > 0 && action != "stop") {
-    delay(cmd.duration);
-    _roomba.stop();
+size_t ArduRoombaWiFi::writeStatusJSON(Print& out, const RoombaStatusFields& fields,
+                                       const RoombaLinkSnapshot& link) {
+  const RoombaSensorCache& cache = _roomba.getSensorCache();
+  RoombaJsonWriter json(out);
+  char name[28];
+
+  json.beginObject();
+  for (uint8_t id = OI_PACKET_FIRST; id <= OI_PACKET_LAST; id++) {
+    if (!(fields.packets & PACKET_BIT(id)) || !cache.has(id)) continue;
+    RoombaPackets::name(id, name, sizeof(name));
+    json.fieldInt(name, cache.values().value(id));
   }
+  if (fields.extras & STATUS_FIELD_CONNECTED) json.fieldBool("connected", _roomba.isConnected());
+  if (fields.extras & STATUS_FIELD_REMOTE)    json.fieldBool("remote_enabled", _remoteEnabled);
+  if (fields.extras & STATUS_FIELD_BUSY)      json.fieldBool("busy", _roomba.isBusy());
+  if (fields.extras & STATUS_FIELD_LINK)      writeLinkHealthFields(json, link);
+  json.endObject();
+
+  return json.finish();
 }
 
-void ArduRoombaWiFi::setCommandCallback(void (*callback)(const RoombaCommand&)) {
-  _commandCallback = callback;
+void ArduRoombaWiFi::respondControlPage(Print& out, uint8_t flags) {
+  ROOMBA_TRACE(METRIC_HTTP_PAGE);
+  RoombaHttpResponse::writeHead(out, 200, "text/html", (long)controlPageLength(),
+                                flags | HTTP_GZIP | HTTP_CACHE);
+  writeControlPage(out);
 }
 
-String ArduRoombaWiFi::generateControlPage() {
-  String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-  <meta name="viewport" content="width=device-width, initial-scale=1.0">
-  <title>ArduRoomba Control</title>
-  <style>
-    body {
-      font-family: Arial, sans-serif;
-      text-align: center;
-      background: #2c3e50;
-      color: #ecf0f1;
-      padding: 20px;
-    }
-    h1 { color: #3498db; }
-    .controls {
-      display: grid;
-      grid-template-columns: repeat(3, 100px);
-      gap: 10px;
-      justify-content: center;
-      margin: 20px auto;
-    }
-    button {
-      padding: 20px;
-      font-size: 16px;
-      background: #3498db;
-      color: white;
-      border: none;
-      border-radius: 8px;
-      cursor: pointer;
-      transition: 0.3s;
-    }
-    button:active { background: #2980b9; transform: scale(0.95); }
-    .forward { grid-column: 2; }
-    .left { grid-column: 1; grid-row: 2; }
-    .stop { grid-column: 2; grid-row: 2; background: #e74c3c; }
-    .right { grid-column: 3; grid-row: 2; }
-    .backward { grid-column: 2; grid-row: 3; }
-    .actions { margin-top: 30px; }
-    .actions button { margin: 5px; background: #27ae60; }
-    .status { margin: 20px; padding: 15px; background: #34495e; border-radius: 8px; }
-  </style>
-</head>
-<body>
-  <h1>ArduRoomba Control</h1>
-  <div class="status" id="status">Battery: -- mV | Status: --</div>
-  <div class="controls">
-    <button class="forward" onclick="send('forward')">↑</button>
-    <button class="left" onclick="send('left')">←</button>
-    <button class="stop" onclick="send('stop')">STOP</button>
-    <button class="right" onclick="send('right')">→</button>
-    <button class="backward" onclick="send('backward')">↓</button>
-  </div>
-  <div class="actions">
-    <button onclick="send('clean')">Clean</button>
-    <button onclick="send('spot')">Spot Clean</button>
-    <button onclick="send('dock')">Dock</button>
-    <button onclick="send('beep')">Beep</button>
-  </div>
-  <script>
-    function send(action) {
-      fetch('/cmd?action=' + action)
-        .then(r => r.text())
-        .then(t => console.log(t))
-        .catch(e => console.error(e));
-    }
-    function updateStatus() {
-      fetch('/status')
-        .then(r => r.json())
-        .then(d => {
-          document.getElementById('status').innerHTML =
-            'Battery: ' + d.voltage + ' mV | Connected: ' + d.connected;
-        })
-        .catch(e => console.error(e));
-    }
-    setInterval(updateStatus, 2000);
-    updateStatus();
-  </script>
-</body>
-</html>
-)rawliteral";
-  return html;
+void ArduRoombaWiFi::respondStatus(Print& out, const char* fields, uint8_t flags) {
+  ROOMBA_TRACE(METRIC_HTTP_STATUS);
+  RoombaStatusFields selected;
+  parseStatusFields(fields, selected);
+  refreshStatusFields(selected);
+
+  // Measured first so the response can carry a Content-Length (keep-alive);
+  // both passes write the same link snapshot
+  RoombaLinkSnapshot link;
+  link.capture(_roomba);
+  RoombaCountingPrint length;
+  writeStatusJSON(length, selected, link);
+
+  RoombaHttpResponse::writeHead(out, 200, "application/json", (long)length.count, flags | HTTP_CORS);
+  writeStatusJSON(out, selected, link);
+}
+
+// /cmd?action=forward&speed=200&duration=1000; missing parameters take defaults
+void ArduRoombaWiFi::respondCommand(Print& out, const char* action, const char* speed,
+                                    const char* duration, uint8_t flags) {
+  ROOMBA_TRACE(METRIC_HTTP_COMMAND);
+  RoombaCommand cmd;
+  strncpy(cmd.action, action ? action : "", sizeof(cmd.action) - 1);
+  cmd.action[sizeof(cmd.action) - 1] = '\0';
+  cmd.speed = (speed && *speed) ? RoombaCommandParser::parseInt(speed, strlen(speed)) : 200;
+  cmd.duration = (duration && *duration) ? RoombaCommandParser::parseInt(duration, strlen(duration)) : 0;
+
+  processCommand(cmd);
+
+  RoombaHttpResponse::write(out, 200, "text/plain", "OK", flags | HTTP_CORS);
+}
+
+// Everything /metrics reports, copied once so the measured length and the
+// written body agree
+struct MetricsSnapshot {
+  RoombaMetric traces[METRIC_COUNT];
+  RoombaLinkHealth health;
+  RoombaStreamStats stream;
+  unsigned long msSinceValid;
+  bool connected;
+};
+
+static size_t writeMetrics(Print& out, const MetricsSnapshot& s) {
+  size_t written = RoombaMetrics::writePrometheus(out, s.traces);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_up", "gauge", s.connected ? 1 : 0);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_ms_since_valid", "gauge", s.msSinceValid);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_replies_total", "counter", s.health.replies);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_timeouts_total", "counter", s.health.timeouts);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_connects_total", "counter", s.health.connects);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_wakes_total", "counter", s.health.wakes);
+  written += RoombaMetrics::writeSample(out, "arduroomba_link_losses_total", "counter", s.health.losses);
+  written += RoombaMetrics::writeSample(out, "arduroomba_stream_frames_total", "counter", s.stream.goodFrames);
+  written += RoombaMetrics::writeSample(out, "arduroomba_stream_checksum_errors_total", "counter", s.stream.badFrames);
+  written += RoombaMetrics::writeSample(out, "arduroomba_stream_resyncs_total", "counter", s.stream.resyncs);
+  return written;
 }
 
-String ArduRoombaWiFi::generateStatusJSON() {
-  uint16_t voltage = _roomba.getBatteryVoltage();
-  bool connected = _roomba.isConnected();
+void ArduRoombaWiFi::respondMetrics(Print& out, uint8_t flags) {
+  ROOMBA_TRACE(METRIC_HTTP_METRICS);
+
+  MetricsSnapshot snapshot;
+  RoombaMetrics::snapshot(snapshot.traces);
+  snapshot.health = _roomba.getLinkHealth();
+  snapshot.stream = _roomba.getStreamStats();
+  snapshot.msSinceValid = _roomba.getTimeSinceValid();
+  snapshot.connected = _roomba.isConnected();
+
+  RoombaCountingPrint length;
+  writeMetrics(length, snapshot);
+
+  RoombaHttpResponse::writeHead(out, 200, "text/plain; version=0.0.4", (long)length.count,
+                                flags | HTTP_NO_CACHE);
+  writeMetrics(out, snapshot);
+}
 
-  String json = "{";
-  json += "\"voltage\":" + String(voltage) + ",";
-  json += "\"connected\":" + String(connected ? "true" : "false") + ",";
-  json += "\"remote_enabled\":" + String(_remoteEnabled ? "true" : "false");
-  json += "}";
+void ArduRoombaWiFi::respondError(Print& out, uint16_t status, uint8_t flags) {
+  RoombaHttpResponse::write(out, status, nullptr, nullptr, flags);
+}
+
+void ArduRoombaWiFi::respondEventStream(Print& out) {
+  // No Content-Length: the body runs until the connection closes
+  RoombaHttpResponse::writeHead(out, 200, "text/event-stream", -1, HTTP_NO_CACHE | HTTP_CORS);
+
+  RoombaBinaryStatus status;
+  char event[SSE_EVENT_MAX];
+  readEventStatus(status);
+  size_t length = formatEvent(status, event, sizeof(event));
+  if (length > 0) out.write((const uint8_t*)event, length);
+}
+
+size_t ArduRoombaWiFi::nextEvent(char* out, size_t outSize, uint8_t observers) {
+  if (observers == 0) {
+    _eventValid = false;
+    return 0;
+  }
+
+  unsigned long now = millis();
+  if (now - _lastEventPoll < _eventInterval) return 0;
+  _lastEventPoll = now;
+
+  // One query serves every stream; with streaming on the cache is already current
+  if (!_roomba.isStreaming()) {
+    _roomba.refreshSensors(RoombaBinaryProtocol::STATUS_PACKETS, ROOMBA_STATUS_PACKET_COUNT);
+  }
+
+  RoombaBinaryStatus status;
+  readEventStatus(status);
+
+  bool changed = !_eventValid || status.voltage != _lastEvent.voltage ||
+                 status.current != _lastEvent.current || status.flags != _lastEvent.flags;
+  if (changed) {
+    _lastEvent = status;
+    _eventValid = true;
+    _lastEventSent = now;
+    return formatEvent(status, out, outSize);
+  }
+
+  if (now - _lastEventSent >= SSE_KEEPALIVE_INTERVAL) {
+    _lastEventSent = now;
+    int n = snprintf(out, outSize, ": keepalive\n\n");
+    return (n > 0 && (size_t)n < outSize) ? n : 0;
+  }
+  return 0;
+}
+
+void ArduRoombaWiFi::readEventStatus(RoombaBinaryStatus& status) {
+  RoombaBinaryProtocol::readStatus(_roomba, status);
+  status.sequence = 0;
+  if (_remoteEnabled) status.flags |= BINARY_STATUS_REMOTE;
+}
 
-  return json;
+size_t ArduRoombaWiFi::formatEvent(const RoombaBinaryStatus& status, char* out, size_t outSize) {
+  int n = snprintf(out, outSize,
+                   "data: {\"voltage\":%u,\"current\":%d,\"connected\":%s,\"wall\":%s,"
+                   "\"bumper\":%s,\"remote_enabled\":%s,\"busy\":%s}\n\n",
+                   (unsigned)status.voltage, (int)status.current,
+                   (status.flags & BINARY_STATUS_CONNECTED) ? "true" : "false",
+                   (status.flags & BINARY_STATUS_WALL) ? "true" : "false",
+                   (status.flags & BINARY_STATUS_BUMPER) ? "true" : "false",
+                   (status.flags & BINARY_STATUS_REMOTE) ? "true" : "false",
+                   (status.flags & BINARY_STATUS_BUSY) ? "true" : "false");
+  return (n > 0 && (size_t)n < outSize) ? n : 0;
 }
 
-void ArduRoombaWiFi::startWebServer(uint16_t port) {
+void ArduRoombaWiFi::startWebServer(uint16_t /* port */) {
   // Implemented by platform-specific class
 }
 
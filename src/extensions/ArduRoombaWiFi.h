@@ -4,12 +4,52 @@
  *
  * Provides common WiFi control functionality with platform-specific implementations.
  * Supports both AP mode (Roomba creates hotspot) and Client mode (connects to network).
+ *
+ * GET /events is a Server-Sent Events stream. The platform class holds the
+ * open streams; the base class reads the sensors once per interval for all
+ * of them and emits an event only when the status changed.
  */
 
 #ifndef ARDUROOMBA_WIFI_H
 #define ARDUROOMBA_WIFI_H
 
 #include "../ArduRoomba.h"
+#include "ArduRoombaCommand.h"
+#include "ArduRoombaHttp.h"
+#include "ArduRoombaBinary.h"
+#include "ArduRoombaJson.h"
+
+// Control page is sent in pieces of this size from a stack buffer
+#ifndef WIFI_PAGE_CHUNK_SIZE
+#define WIFI_PAGE_CHUNK_SIZE 256
+#endif
+
+// Server-Sent Events
+#ifndef SSE_MAX_CLIENTS
+#define SSE_MAX_CLIENTS 2
+#endif
+
+#ifndef SSE_MIN_INTERVAL
+#define SSE_MIN_INTERVAL 200          // ms between sensor checks / change events
+#endif
+
+#ifndef SSE_KEEPALIVE_INTERVAL
+#define SSE_KEEPALIVE_INTERVAL 15000  // ms; comment line so idle streams stay open
+#endif
+
+#define SSE_EVENT_MAX 160             // Longest formatted event
+
+// /status?fields= entries that are not sensor packets
+#define STATUS_FIELD_CONNECTED 0x01
+#define STATUS_FIELD_REMOTE    0x02
+#define STATUS_FIELD_BUSY      0x04
+#define STATUS_FIELD_LINK      0x08   // The link_* health fields
+
+// Selection for /status: sensor packets by bit (id - OI_PACKET_FIRST) plus extras
+struct RoombaStatusFields {
+  uint64_t packets;
+  uint8_t extras;
+};
 
 // WiFi operating modes
 enum WiFiMode {
@@ -17,13 +57,6 @@ enum WiFiMode {
   AR_WIFI_MODE_CLIENT   // Client - Roomba connects to existing network
 };
 
-// Command protocol for WiFi control
-struct RoombaCommand {
-  char action[16];   // "forward", "backward", "left", "right", "stop", "clean", "dock"
-  int16_t speed;     // Speed parameter (0-500)
-  int16_t duration;  // Duration in milliseconds (0 = continuous)
-};
-
 /**
  * Base class for WiFi-enabled Roomba control
  * Platform-specific implementations inherit from this
@@ -54,16 +87,60 @@ public:
   void enableRemoteControl(bool enable) { _remoteEnabled = enable; }
   bool isRemoteEnabled() const { return _remoteEnabled; }
 
+  // Rate cap for /events (also how often the sensors are read for it)
+  void setEventInterval(uint16_t ms) { _eventInterval = ms; }
+
 protected:
   ArduRoomba& _roomba;
   bool _remoteEnabled;
   void (*_commandCallback)(const RoombaCommand&);
 
-  // Helper to generate HTML control page
-  String generateControlPage();
+  // Control page: gzip-compressed HTML in flash (Content-Encoding: gzip)
+  static size_t writeControlPage(Print& out);
+  static const uint8_t* controlPageData();
+  static size_t controlPageLength();
+
+  // /status fields: comma-separated packet names ("voltage,wall"), packet
+  // ids ("22,8"), "connected", "remote_enabled", "busy", "link" or "all".
+  // nullptr or an empty list selects voltage, connected and remote_enabled
+  static void parseStatusFields(const char* list, RoombaStatusFields& fields);
+
+  // Reads the selected packets (as few query round trips as fit) unless the
+  // sensor stream is already keeping the cache current
+  void refreshStatusFields(const RoombaStatusFields& fields);
+
+  // JSON object of the selected fields from the sensor cache and the link
+  // snapshot; packets with no cached value are left out
+  size_t writeStatusJSON(Print& out, const RoombaStatusFields& fields, const RoombaLinkSnapshot& link);
+
+  // Endpoint responses shared by the platform classes, written to the client
+  // socket; flags are the HTTP_* header options (connection handling)
+  void respondControlPage(Print& out, uint8_t flags);
+  void respondStatus(Print& out, const char* fields, uint8_t flags);
+  void respondCommand(Print& out, const char* action, const char* speed,
+                      const char* duration, uint8_t flags);
+  static void respondError(Print& out, uint16_t status, uint8_t flags);
+
+  // Prometheus text: the ROOMBA_TRACE timings (when compiled in) and the
+  // link health counters
+  void respondMetrics(Print& out, uint8_t flags);
+
+  // Starts an event stream: headers, then the current status
+  void respondEventStream(Print& out);
+
+  // Called every handleClient() with the number of open streams. Returns the
+  // length of the event to write to each of them, or 0 if nothing is due
+  size_t nextEvent(char* out, size_t outSize, uint8_t observers);
+
+private:
+  uint16_t _eventInterval;
+  unsigned long _lastEventPoll;
+  unsigned long _lastEventSent;
+  RoombaBinaryStatus _lastEvent;
+  bool _eventValid;
 
-  // Helper to generate JSON status
-  String generateStatusJSON();
+  void readEventStatus(RoombaBinaryStatus& status);
+  static size_t formatEvent(const RoombaBinaryStatus& status, char* out, size_t outSize);
 };
 
 #endif
@@ -4,18 +4,24 @@
  */
 
 #include "ArduRoombaWiFiS3.h"
+#include "../RoombaMetrics.h"
 
 #if defined(ARDUINO_UNOWIFIR4)
 
 ArduRoombaWiFiS3::ArduRoombaWiFiS3(ArduRoomba& roomba)
-  : ArduRoombaWiFi(roomba), _server(nullptr), _mode(WIFI_MODE_AP), _connected(false) {
+  : ArduRoombaWiFi(roomba), _server(nullptr), _mode(AR_WIFI_MODE_AP), _connected(false),
+    _nextConnection(0) {
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    _connections[i].open = false;
+    _connections[i].events = false;
+  }
 }
 
 bool ArduRoombaWiFiS3::beginAP(const char* ssid, const char* password) {
   Serial.print("Creating WiFi AP: ");
   Serial.println(ssid);
 
-  _mode = WIFI_MODE_AP;
+  _mode = AR_WIFI_MODE_AP;
 
   // Create access point
   int status;
@@ -44,7 +50,7 @@ bool ArduRoombaWiFiS3::beginClient(const char* ssid, const char* password) {
   Serial.print("Connecting to WiFi: ");
   Serial.println(ssid);
 
-  _mode = WIFI_MODE_CLIENT;
+  _mode = AR_WIFI_MODE_CLIENT;
 
   // Attempt to connect
   int status = WiFi.begin(ssid, password);
@@ -72,6 +78,9 @@ bool ArduRoombaWiFiS3::beginClient(const char* ssid, const char* password) {
 }
 
 void ArduRoombaWiFiS3::end() {
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    closeConnection(_connections[i]);
+  }
   if (_server) {
     delete _server;
     _server = nullptr;
@@ -81,7 +90,7 @@ void ArduRoombaWiFiS3::end() {
 }
 
 bool ArduRoombaWiFiS3::isConnected() const {
-  if (_mode == WIFI_MODE_CLIENT) {
+  if (_mode == AR_WIFI_MODE_CLIENT) {
     return WiFi.status() == WL_CONNECTED;
   }
   return _connected;
@@ -106,111 +115,182 @@ void ArduRoombaWiFiS3::startWebServer(uint16_t port) {
   Serial.println(getIPAddress());
 }
 
+// Never blocks: accepts at most one new connection, then reads what has
+// arrived on each open one (within HTTP_LOOP_BUDGET_MS) and answers complete
+// requests. Servicing resumes where the last call stopped, so one busy
+// client cannot starve the others.
 void ArduRoombaWiFiS3::handleClient() {
   if (!_server) return;
 
-  WiFiClient client = _server->available();
-  if (client) {
-    handleHTTPRequest(client);
+  acceptClient();
+
+  unsigned long start = millis();
+  for (uint8_t n = 0; n < HTTP_MAX_CLIENTS; n++) {
+    HttpConnection& conn = _connections[_nextConnection];
+    _nextConnection = (_nextConnection + 1) % HTTP_MAX_CLIENTS;
+
+    if (conn.open) serviceConnection(conn);
+    if (millis() - start >= HTTP_LOOP_BUDGET_MS) break;
   }
+
+  sendEvents();
 }
 
-void ArduRoombaWiFiS3::handleHTTPRequest(WiFiClient& client) {
-  String request = "";
-  bool currentLineIsBlank = true;
-
-  while (client.connected()) {
-    if (client.available()) {
-      char c = client.read();
-      request += c;
-
-      if (c == '\n' && currentLineIsBlank) {
-        // End of HTTP request, process it
-
-        // Parse request line (first line)
-        int firstSpace = request.indexOf(' ');
-        int secondSpace = request.indexOf(' ', firstSpace + 1);
-        String path = request.substring(firstSpace + 1, secondSpace);
-
-        // Handle different endpoints
-        if (path.startsWith("/cmd")) {
-          // Command endpoint: /cmd?action=forward&speed=200
-          String action = parseGETParameter(request, "action");
-          String speedStr = parseGETParameter(request, "speed");
-          String durationStr = parseGETParameter(request, "duration");
-
-          RoombaCommand cmd;
-          strncpy(cmd.action, action.c_str(), sizeof(cmd.action) - 1);
-          cmd.action[sizeof(cmd.action) - 1] = '\0';
-          cmd.speed = speedStr.length() > 0 ? speedStr.toInt() : 200;
-          cmd.duration = durationStr.length() > 0 ? durationStr.toInt() : 0;
-
-          processCommand(cmd);
-
-          // Send response
-          client.println("HTTP/1.1 200 OK");
-          client.println("Content-Type: text/plain");
-          client.println("Access-Control-Allow-Origin: *");
-          client.println("Connection: close");
-          client.println();
-          client.println("OK");
-        }
-        else if (path.startsWith("/status")) {
-          // Status endpoint: returns JSON
-          String json = generateStatusJSON();
-
-          client.println("HTTP/1.1 200 OK");
-          client.println("Content-Type: application/json");
-          client.println("Access-Control-Allow-Origin: *");
-          client.println("Connection: close");
-          client.println();
-          client.println(json);
-        }
-        else {
-          // Main control page
-          String html = generateControlPage();
-
-          client.println("HTTP/1.1 200 OK");
-          client.println("Content-Type: text/html");
-          client.println("Connection: close");
-          client.println();
-          client.println(html);
-        }
-        break;
-      }
+void ArduRoombaWiFiS3::acceptClient() {
+  // available() also returns connections already in the table when they have data
+  WiFiClient incoming = _server->available();
+  if (!incoming) return;
 
-      if (c == '\n') {
-        currentLineIsBlank = true;
-      } else if (c != '\r') {
-        currentLineIsBlank = false;
-      }
+  HttpConnection* slot = nullptr;
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    HttpConnection& conn = _connections[i];
+    if (conn.open && conn.client == incoming) return;
+    if (!conn.open && !slot) slot = &conn;
+  }
+
+  // Table full: reclaim the longest-idle keep-alive connection
+  if (!slot) {
+    unsigned long now = millis();
+    for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+      HttpConnection& conn = _connections[i];
+      if (conn.receiving || conn.events) continue;
+      if (!slot || now - conn.lastActivity > now - slot->lastActivity) slot = &conn;
     }
   }
 
-  delay(1);
-  client.stop();
+  if (!slot) {
+    respondError(incoming, 503, 0);
+    incoming.stop();
+    return;
+  }
+
+  closeConnection(*slot);
+  slot->client = incoming;
+  slot->parser.reset();
+  slot->open = true;
+  slot->receiving = false;
+  slot->events = false;
+  slot->requests = 0;
+  slot->lastActivity = millis();
 }
 
-String ArduRoombaWiFiS3::parseGETParameter(const String& request, const String& param) {
-  String searchStr = param + "=";
-  int startIdx = request.indexOf(searchStr);
+void ArduRoombaWiFiS3::serviceConnection(HttpConnection& conn) {
+  if (conn.events) {
+    // Nothing more is expected from an event stream listener
+    while (conn.client.available() > 0) conn.client.read();
+    if (!conn.client.connected()) closeConnection(conn);
+    return;
+  }
+
+  unsigned long start = millis();
+  HttpParseResult result = conn.parser.result();
+  if (result == HTTP_PARSE_INCOMPLETE && conn.client.available() > 0) {
+    ROOMBA_TRACE(METRIC_HTTP_PARSE);
+    do {
+      if (!conn.receiving) {
+        conn.receiving = true;
+        conn.requestStart = millis();
+      }
+      result = conn.parser.feed((char)conn.client.read());
+      if (millis() - start >= HTTP_LOOP_BUDGET_MS) break;
+    } while (result == HTTP_PARSE_INCOMPLETE && conn.client.available() > 0);
+  }
 
-  if (startIdx == -1) {
-    return "";
+  if (result == HTTP_PARSE_DONE) {
+    // Pipelined requests stay in the socket buffer for the next pass
+    bool keepAlive = conn.parser.keepAlive() && ++conn.requests < HTTP_MAX_KEEP_ALIVE_REQUESTS;
+    handleHTTPRequest(conn, keepAlive ? HTTP_KEEP_ALIVE : 0);
+    if (conn.events) {
+      conn.receiving = false;
+    } else if (keepAlive) {
+      conn.parser.reset();
+      conn.receiving = false;
+      conn.lastActivity = millis();
+    } else {
+      closeConnection(conn);
+    }
+  } else if (result == HTTP_PARSE_ERROR) {
+    respondError(conn.client, conn.parser.errorStatus(), 0);
+    closeConnection(conn);
+  } else if (!conn.client.connected()) {
+    closeConnection(conn);
+  } else if (conn.receiving) {
+    if (millis() - conn.requestStart > HTTP_REQUEST_TIMEOUT_MS) {
+      respondError(conn.client, 408, 0);
+      closeConnection(conn);
+    }
+  } else if (millis() - conn.lastActivity > HTTP_KEEP_ALIVE_TIMEOUT_MS) {
+    closeConnection(conn);
   }
+}
 
-  startIdx += searchStr.length();
-  int endIdx = request.indexOf('&', startIdx);
+void ArduRoombaWiFiS3::handleHTTPRequest(HttpConnection& conn, uint8_t flags) {
+  const RoombaHttpParser& request = conn.parser;
+  const char* path = request.path();
+
+  if (request.method() != HTTP_METHOD_GET) {
+    respondError(conn.client, 405, flags);
+  }
+  else if (strcmp(path, "/cmd") == 0) {
+    // Command endpoint: /cmd?action=forward&speed=200
+    respondCommand(conn.client, request.param("action"), request.param("speed"),
+                   request.param("duration"), flags);
+  }
+  else if (strcmp(path, "/status") == 0) {
+    // Status endpoint: returns JSON, /status?fields=voltage,wall
+    respondStatus(conn.client, request.param("fields"), flags);
+  }
+  else if (strcmp(path, "/metrics") == 0) {
+    // Prometheus scrape target
+    respondMetrics(conn.client, flags);
+  }
+  else if (strcmp(path, "/") == 0) {
+    // Main control page, streamed from flash
+    respondControlPage(conn.client, flags);
+  }
+  else if (strcmp(path, "/events") == 0) {
+    // Server-Sent Events: the connection stays open for sendEvents()
+    if (eventStreamCount() >= SSE_MAX_CLIENTS) {
+      respondError(conn.client, 503, flags);
+    } else {
+      respondEventStream(conn.client);
+      conn.events = true;
+    }
+  }
+  else {
+    respondError(conn.client, 404, flags);
+  }
+}
 
-  if (endIdx == -1) {
-    endIdx = request.indexOf(' ', startIdx);
+void ArduRoombaWiFiS3::closeConnection(HttpConnection& conn) {
+  if (conn.open) {
+    conn.client.stop();
+    conn.client = WiFiClient();
   }
+  conn.open = false;
+  conn.receiving = false;
+  conn.events = false;
+}
 
-  if (endIdx == -1) {
-    endIdx = request.length();
+uint8_t ArduRoombaWiFiS3::eventStreamCount() const {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    if (_connections[i].open && _connections[i].events) count++;
   }
+  return count;
+}
 
-  return request.substring(startIdx, endIdx);
+// One event, formatted once, goes to every stream
+void ArduRoombaWiFiS3::sendEvents() {
+  char event[SSE_EVENT_MAX];
+  size_t length = nextEvent(event, sizeof(event), eventStreamCount());
+  if (length == 0) return;
+
+  for (uint8_t i = 0; i < HTTP_MAX_CLIENTS; i++) {
+    HttpConnection& conn = _connections[i];
+    if (!conn.open || !conn.events) continue;
+    if (conn.client.write((const uint8_t*)event, length) != length) closeConnection(conn);
+  }
 }
 
 #endif // ARDUINO_UNOWIFIR4
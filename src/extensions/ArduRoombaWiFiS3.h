@@ -4,18 +4,45 @@
  *
  * Uses WiFiS3 library specific to Arduino Uno R4 WiFi board.
  * Provides AP and Client modes with HTTP web server control.
+ *
+ * Up to HTTP_MAX_CLIENTS connections are held open at once and serviced
+ * round-robin from handleClient(), which never blocks. HTTP/1.1 clients are
+ * answered with keep-alive, so the control page's status polling reuses one
+ * socket instead of opening a new one every request. /events streams hold a
+ * table slot for as long as the client listens.
  */
 
 #ifndef ARDUROOMBA_WIFIS3_H
 #define ARDUROOMBA_WIFIS3_H
 
 #include "ArduRoombaWiFi.h"
+#include "ArduRoombaHttp.h"
 
 // Only compile for Uno R4 WiFi
 #if defined(ARDUINO_UNOWIFIR4)
 
 #include <WiFiS3.h>
 
+// Longest a single handleClient() call spends reading request bytes
+#ifndef HTTP_LOOP_BUDGET_MS
+#define HTTP_LOOP_BUDGET_MS 2
+#endif
+
+// A request must be complete this long after its first byte arrived
+#ifndef HTTP_REQUEST_TIMEOUT_MS
+#define HTTP_REQUEST_TIMEOUT_MS 1000
+#endif
+
+// Connections held open at once (the WiFi module has a small socket pool)
+#ifndef HTTP_MAX_CLIENTS
+#define HTTP_MAX_CLIENTS 4
+#endif
+
+// Requests answered on one connection before it is closed
+#ifndef HTTP_MAX_KEEP_ALIVE_REQUESTS
+#define HTTP_MAX_KEEP_ALIVE_REQUESTS 100
+#endif
+
 class ArduRoombaWiFiS3 : public ArduRoombaWiFi {
 public:
   ArduRoombaWiFiS3(ArduRoomba& roomba);
@@ -38,8 +65,27 @@ private:
   WiFiMode _mode;
   bool _connected;
 
-  void handleHTTPRequest(WiFiClient& client);
-  String parseGETParameter(const String& request, const String& param);
+  // One open connection; its request is parsed across handleClient() calls
+  struct HttpConnection {
+    WiFiClient client;
+    RoombaHttpParser parser;
+    bool open;
+    bool receiving;             // Part of a request has arrived
+    bool events;                // Serving a /events stream; no more requests
+    uint8_t requests;           // Answered on this connection
+    unsigned long requestStart; // First byte of the current request
+    unsigned long lastActivity; // Accept or last response, for the idle timeout
+  };
+
+  HttpConnection _connections[HTTP_MAX_CLIENTS];
+  uint8_t _nextConnection;     // Round-robin position
+
+  void acceptClient();
+  void serviceConnection(HttpConnection& conn);
+  void handleHTTPRequest(HttpConnection& conn, uint8_t flags);
+  void closeConnection(HttpConnection& conn);
+  void sendEvents();
+  uint8_t eventStreamCount() const;
 };
 
 #endif // ARDUINO_UNOWIFIR4